@@ -0,0 +1,230 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "concurrent_list.h"
+#include "linked_list.h"
+#include "stdlib.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+//
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+#define MARK_BIT            ((uintptr_t)1)
+#define NODE_PTR(_link)     ((struct concurrent_node *)((_link) & ~MARK_BIT))
+
+/* Epoch reclaim callback */
+static void reclaim_node(void * ptr, void * ctx) {
+    (void)ctx;
+    free_fptr(ptr);
+}
+
+/* Retire a node this thread unlinked. A search may meet any number of
+   marked nodes, so the retire ring can fill up inside one critical
+   section. The section is then left, which lets epoch_exit() drain the
+   ring, and the node is retired outside it. Returns false if the section
+   was left and re-entered, in which case nothing read before is safe to
+   use any more. */
+static bool retire_node(struct epoch_thread * thread, struct concurrent_node * node) {
+    if (epoch_retire(thread, node)) {
+        return true;
+    }
+    epoch_exit(thread);
+    epoch_retire(thread, node);
+    epoch_enter(thread);
+    return false;
+}
+
+/* Find the first node with data >= key, unlinking and retiring any marked
+   node on the way. On return *prev is the node before *curr, and *curr is
+   NULL if every node is smaller than key. */
+static void search(struct concurrent_list * list, struct epoch_thread * thread, unsigned int key,
+                   struct concurrent_node ** prev, struct concurrent_node ** curr) {
+retry:
+    *prev = &list->head;
+    *curr = NODE_PTR(atomic_load_explicit(&(*prev)->next, memory_order_acquire));
+    while (*curr != NULL) {
+        uintptr_t next = atomic_load_explicit(&(*curr)->next, memory_order_acquire);
+        if (next & MARK_BIT) {
+            // Fails if prev was marked or changed underneath us
+            uintptr_t expected = (uintptr_t)*curr;
+            if (!atomic_compare_exchange_strong(&(*prev)->next, &expected, next & ~MARK_BIT)) {
+                goto retry;
+            }
+            if (!retire_node(thread, *curr)) {
+                goto retry;
+            }
+            *curr = NODE_PTR(next);
+            continue;
+        }
+        if ((*curr)->data >= key) {
+            return;
+        }
+        *prev = *curr;
+        *curr = NODE_PTR(next);
+    }
+}
+
+/* Create a concurrent list */
+struct concurrent_list * concurrent_list_create(void) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    struct concurrent_list * list = malloc_fptr(sizeof(struct concurrent_list));
+    INVALID_PTR_CHECK(list, NULL);
+    atomic_init(&list->head.next, 0);
+    list->head.data = 0;
+    atomic_init(&list->len, 0);
+    epoch_domain_init(&list->domain, reclaim_node, NULL);
+    return list;
+}
+
+/* Delete a concurrent list */
+bool concurrent_list_delete(struct concurrent_list * list) {
+    INVALID_PTR_CHECK(list, false);
+    epoch_domain_destroy(&list->domain);
+    struct concurrent_node * current = NODE_PTR(atomic_load(&list->head.next));
+    while (current != NULL) {
+        struct concurrent_node * next = NODE_PTR(atomic_load(&current->next));
+        free_fptr(current);
+        current = next;
+    }
+    free_fptr(list);
+    return true;
+}
+
+/* Register the calling thread */
+struct epoch_thread * concurrent_list_register_thread(struct concurrent_list * list) {
+    INVALID_PTR_CHECK(list, NULL);
+    return epoch_register(&list->domain);
+}
+
+/* Unregister a thread */
+bool concurrent_list_unregister_thread(struct epoch_thread * thread) {
+    return epoch_unregister(thread);
+}
+
+/* Insert data if not already present */
+bool concurrent_list_insert(struct concurrent_list * list, struct epoch_thread * thread, unsigned int data) {
+    INVALID_PTR_CHECK(list, false);
+    INVALID_PTR_CHECK(thread, false);
+    struct concurrent_node * node = malloc_fptr(sizeof(struct concurrent_node));
+    INVALID_PTR_CHECK(node, false);
+    node->data = data;
+
+    struct concurrent_node * prev;
+    struct concurrent_node * curr;
+    epoch_enter(thread);
+    for (;;) {
+        search(list, thread, data, &prev, &curr);
+        if (curr != NULL && curr->data == data) {
+            epoch_exit(thread);
+            free_fptr(node);
+            return false;
+        }
+        // Publish the node, release so its contents are visible first
+        atomic_store_explicit(&node->next, (uintptr_t)curr, memory_order_relaxed);
+        uintptr_t expected = (uintptr_t)curr;
+        if (atomic_compare_exchange_strong_explicit(&prev->next, &expected, (uintptr_t)node,
+                                                    memory_order_release, memory_order_relaxed)) {
+            break;
+        }
+    }
+    atomic_fetch_add_explicit(&list->len, 1, memory_order_relaxed);
+    epoch_exit(thread);
+    return true;
+}
+
+/* Remove data if present */
+bool concurrent_list_remove(struct concurrent_list * list, struct epoch_thread * thread, unsigned int data) {
+    INVALID_PTR_CHECK(list, false);
+    INVALID_PTR_CHECK(thread, false);
+
+    struct concurrent_node * prev;
+    struct concurrent_node * curr;
+    uintptr_t next;
+    epoch_enter(thread);
+    for (;;) {
+        search(list, thread, data, &prev, &curr);
+        if (curr == NULL || curr->data != data) {
+            epoch_exit(thread);
+            return false;
+        }
+        // Logical removal: whoever marks the node owns the removal
+        next = atomic_load_explicit(&curr->next, memory_order_acquire);
+        if (next & MARK_BIT) {
+            continue;
+        }
+        if (atomic_compare_exchange_strong(&curr->next, &next, next | MARK_BIT)) {
+            break;
+        }
+    }
+
+    // Physical removal, or let a search finish it if prev changed
+    uintptr_t expected = (uintptr_t)curr;
+    if (atomic_compare_exchange_strong(&prev->next, &expected, next)) {
+        retire_node(thread, curr);  // Nothing read before is used after
+    } else {
+        search(list, thread, data, &prev, &curr);
+    }
+    atomic_fetch_sub_explicit(&list->len, 1, memory_order_relaxed);
+    epoch_exit(thread);
+    return true;
+}
+
+/* Check for data without modifying the list */
+bool concurrent_list_find(struct concurrent_list * list, struct epoch_thread * thread, unsigned int data) {
+    INVALID_PTR_CHECK(list, false);
+    INVALID_PTR_CHECK(thread, false);
+
+    epoch_enter(thread);
+    struct concurrent_node * curr = NODE_PTR(atomic_load_explicit(&list->head.next, memory_order_acquire));
+    while (curr != NULL && curr->data < data) {
+        curr = NODE_PTR(atomic_load_explicit(&curr->next, memory_order_acquire));
+    }
+    bool found = (curr != NULL && curr->data == data &&
+                  !(atomic_load_explicit(&curr->next, memory_order_acquire) & MARK_BIT));
+    epoch_exit(thread);
+    return found;
+}
+
+/* Get the number of elements */
+size_t concurrent_list_size(struct concurrent_list * list) {
+    INVALID_PTR_CHECK(list, SIZE_MAX);
+    return atomic_load_explicit(&list->len, memory_order_relaxed);
+}
+
+/* Register malloc function */
+bool concurrent_list_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register free function */
+bool concurrent_list_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
@@ -0,0 +1,148 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CONCURRENT_LIST_H_
+#define CONCURRENT_LIST_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "epoch.h"
+
+/* A lock-free sorted set of unsigned ints (Harris/Michael list) that any
+   number of threads can insert into, remove from and search at the same
+   time.
+
+   A removal first marks the low bit of the victim's next pointer, which
+   stops anyone from linking after it, then swings its predecessor past
+   it. Any thread that walks over a marked node finishes the unlink for
+   it. Unlinked nodes are handed to epoch-based reclamation (epoch.h) and
+   only released with free_fptr() once no thread can still be reading
+   them.
+
+   Each thread that uses a list registers with it first and passes the
+   returned handle to every call. The registered malloc and free functions
+   must be thread safe. */
+
+// Node of the concurrent list. The low bit of next marks the node as
+// logically removed.
+//
+struct concurrent_node {
+    _Atomic uintptr_t next;
+    unsigned int data;
+};
+
+// Definition of the concurrent list. head is a sentinel, the first real
+// node is head.next.
+//
+struct concurrent_list {
+    struct concurrent_node head;
+    _Atomic size_t len;
+    struct epoch_domain domain;
+};
+
+// Creates a new, empty concurrent list.
+// PRECONDITION: Register malloc() and free() functions via the
+//               concurrent_list_register_malloc() and
+//               concurrent_list_register_free() functions.
+// Returns a new concurrent_list on success, NULL on failure.
+//
+struct concurrent_list * concurrent_list_create(void);
+
+// Deletes a concurrent list.
+// PRECONDITION: No thread is using the list.
+// \param list : Pointer to list to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool concurrent_list_delete(struct concurrent_list * list);
+
+// Registers the calling thread with a list.
+// \param list : Pointer to list.
+// Returns the thread's handle on success, NULL if EPOCH_MAX_THREADS
+// threads are already registered.
+//
+struct epoch_thread * concurrent_list_register_thread(struct concurrent_list * list);
+
+// Unregisters a thread, waiting until the nodes it removed are released.
+// \param thread : Handle from concurrent_list_register_thread().
+// Returns TRUE on success, FALSE otherwise.
+//
+bool concurrent_list_unregister_thread(struct epoch_thread * thread);
+
+// Inserts data into the list, unless it is already present.
+// \param list   : Pointer to list.
+// \param thread : Calling thread's handle.
+// \param data   : Data to insert.
+// Returns TRUE if data was inserted, FALSE if it was already present or
+// on failure.
+//
+bool concurrent_list_insert(struct concurrent_list * list,
+                            struct epoch_thread * thread,
+                            unsigned int data);
+
+// Removes data from the list.
+// \param list   : Pointer to list.
+// \param thread : Calling thread's handle.
+// \param data   : Data to remove.
+// Returns TRUE if data was removed, FALSE if it was not present or on
+// failure.
+//
+bool concurrent_list_remove(struct concurrent_list * list,
+                            struct epoch_thread * thread,
+                            unsigned int data);
+
+// Checks whether data is in the list.
+// \param list   : Pointer to list.
+// \param thread : Calling thread's handle.
+// \param data   : Data to find.
+// Returns TRUE if data is present, FALSE otherwise.
+//
+bool concurrent_list_find(struct concurrent_list * list,
+                          struct epoch_thread * thread,
+                          unsigned int data);
+
+// Returns the number of elements in the list. Under concurrent updates
+// this is a snapshot that may already be stale.
+// \param list : Pointer to list.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t concurrent_list_size(struct concurrent_list * list);
+
+// Registers malloc() function.
+// \param malloc : Function pointer to malloc()-like function, must be
+//                 thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool concurrent_list_register_malloc(void * (*malloc)(size_t));
+
+// Registers free() function.
+// \param free : Function pointer to free()-like function, must be
+//               thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool concurrent_list_register_free(void (*free)(void*));
+
+#endif
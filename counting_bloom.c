@@ -0,0 +1,194 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "counting_bloom.h"
+#include "linked_list.h"
+#include "math.h"
+#include "string.h"
+
+#define COUNTER_MAX         (15)
+#define BLOCK_BYTES         (COUNTING_BLOOM_BLOCK / 2)
+
+/* False positive rate of a filter whose blocks hold load values on
+   average. The values in one block are Poisson distributed; a block with j
+   of them answers a lookup wrongly when all hashes land on set counters. */
+static double blocked_rate(double load, unsigned int hashes) {
+    double unset = 1.0 - 1.0 / COUNTING_BLOOM_BLOCK;
+    double p_j = exp(-load);
+    double rate = 0.0;
+    double last = load + 10.0 * sqrt(load) + 10.0;
+    for (unsigned int j = 1; j <= last; j++) {
+        p_j *= load / j;
+        rate += p_j * pow(1.0 - pow(unset, (double) hashes * j), hashes);
+    }
+    return rate;
+}
+
+/* Size the filter for n values at rate p. An unblocked filter wants
+   n * -ln(p) / ln(2)^2 counters and (counters / n) * ln(2) hashes; keeping
+   that hash count, the block count is the smallest whose average load
+   still meets p, found by bisection since confining a value to one block
+   makes some blocks fuller than others. */
+static bool dimensions(size_t expected, double false_positive_rate, size_t * blocks, unsigned int * hashes) {
+    if (expected == 0 || !(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+        return false;
+    }
+    double k = round(-log(false_positive_rate) / M_LN2);
+    *hashes = (k < 1.0) ? 1 : (k > COUNTING_BLOOM_MAX_HASHES) ? COUNTING_BLOOM_MAX_HASHES : (unsigned int) k;
+
+    double lo = 0.0;
+    double hi = COUNTING_BLOOM_BLOCK;
+    for (int i = 0; i < 40; i++) {
+        double mid = (lo + hi) / 2;
+        if (blocked_rate(mid, *hashes) <= false_positive_rate) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    double count = (lo > 0.0) ? ceil((double) expected / lo) : INFINITY;
+    if (count > (double) UINT32_MAX) {
+        return false;
+    }
+    *blocks = (size_t) count;
+    return true;
+}
+
+/* 64-bit finalizer from MurmurHash3 */
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/* The low half of the hash picks the block by multiply and shift, which
+   maps it onto any block count without a division. The hash then seeds a
+   64-bit LCG whose top bits pick each counter in the block. Double hashing
+   inside a block this small would give too few distinct sets of counters,
+   and values sharing a set are indistinguishable. */
+static inline size_t block_offset(const struct counting_bloom * filter, uint64_t h) {
+    return (size_t) (((h & UINT32_MAX) * filter->blocks) >> 32) * BLOCK_BYTES;
+}
+
+#define PROBE_NEXT(_x)      ((_x) * 6364136223846793005ULL + 1442695040888963407ULL)
+#define PROBE_SLOT(_x)      ((_x) >> 57)
+
+_Static_assert(COUNTING_BLOOM_BLOCK == 128, "PROBE_SLOT() takes 7 bits");
+
+/* Counters are packed two to a byte. They are read and written with
+   relaxed atomics, so a reader checking the filter while the owner
+   updates it sees each counter either before or after the update. */
+static inline unsigned int counter_get(const uint8_t * block, size_t slot) {
+    return (__atomic_load_n(&block[slot / 2], __ATOMIC_RELAXED) >> ((slot & 1) * 4)) & COUNTER_MAX;
+}
+
+static inline void counter_add(uint8_t * block, size_t slot, int delta) {
+    unsigned int shift = (slot & 1) * 4;
+    uint8_t byte = __atomic_load_n(&block[slot / 2], __ATOMIC_RELAXED);
+    unsigned int count = (byte >> shift) & COUNTER_MAX;
+
+    // A saturated counter's true count is unknown, so it stays saturated
+    if (count == COUNTER_MAX || (count == 0 && delta < 0)) {
+        return;
+    }
+    count += delta;
+    byte = (uint8_t) ((byte & ~(COUNTER_MAX << shift)) | (count << shift));
+    __atomic_store_n(&block[slot / 2], byte, __ATOMIC_RELAXED);
+}
+
+/* Get the storage needed for a filter */
+size_t counting_bloom_size(size_t expected, double false_positive_rate) {
+    size_t blocks;
+    unsigned int hashes;
+    if (!dimensions(expected, false_positive_rate, &blocks, &hashes)) {
+        return 0;
+    }
+    return sizeof(struct counting_bloom) + (blocks + 1) * BLOCK_BYTES - 1;
+}
+
+/* Get the storage a filter uses */
+size_t counting_bloom_bytes(const struct counting_bloom * filter) {
+    return sizeof(struct counting_bloom) + (filter->blocks + 1) * BLOCK_BYTES - 1;
+}
+
+/* Initialize an empty filter */
+bool counting_bloom_init(struct counting_bloom * filter, size_t expected, double false_positive_rate) {
+    INVALID_PTR_CHECK(filter, false);
+    size_t blocks;
+    unsigned int hashes;
+    if (!dimensions(expected, false_positive_rate, &blocks, &hashes)) {
+        return false;
+    }
+    filter->blocks = blocks;
+    filter->hashes = hashes;
+    filter->base = (uint8_t *) (((uintptr_t) filter->counters + BLOCK_BYTES - 1) &
+                                ~(uintptr_t) (BLOCK_BYTES - 1));
+    counting_bloom_reset(filter);
+    return true;
+}
+
+/* Clear every counter */
+void counting_bloom_reset(struct counting_bloom * filter) {
+    memset(filter->base, 0, filter->blocks * BLOCK_BYTES);
+}
+
+/* Add a value */
+void counting_bloom_add(struct counting_bloom * filter, unsigned int data) {
+    uint64_t h = mix(data);
+    uint8_t * block = &filter->base[block_offset(filter, h)];
+    uint64_t x = h;
+    for (unsigned int i = 0; i < filter->hashes; i++) {
+        x = PROBE_NEXT(x);
+        counter_add(block, PROBE_SLOT(x), 1);
+    }
+}
+
+/* Remove a value that was added before */
+void counting_bloom_remove(struct counting_bloom * filter, unsigned int data) {
+    uint64_t h = mix(data);
+    uint8_t * block = &filter->base[block_offset(filter, h)];
+    uint64_t x = h;
+    for (unsigned int i = 0; i < filter->hashes; i++) {
+        x = PROBE_NEXT(x);
+        counter_add(block, PROBE_SLOT(x), -1);
+    }
+}
+
+/* Check whether a value may be present */
+bool counting_bloom_maybe_contains(const struct counting_bloom * filter, unsigned int data) {
+    uint64_t h = mix(data);
+    const uint8_t * block = &filter->base[block_offset(filter, h)];
+    uint64_t x = h;
+    for (unsigned int i = 0; i < filter->hashes; i++) {
+        x = PROBE_NEXT(x);
+        if (counter_get(block, PROBE_SLOT(x)) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
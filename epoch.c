@@ -0,0 +1,184 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "epoch.h"
+#include "linked_list.h"
+#include "sched.h"
+#include "stdlib.h"
+
+#define STATE_ACTIVE            (1u)
+#define STATE_EPOCH(_state)     ((_state) >> 1)
+
+/* Initialize a domain in caller-provided storage */
+bool epoch_domain_init(struct epoch_domain * domain, void (*reclaim)(void * ptr, void * ctx), void * ctx) {
+    INVALID_PTR_CHECK(domain, false);
+    INVALID_PTR_CHECK(reclaim, false);
+    atomic_init(&domain->global_epoch, 0);
+    domain->reclaim = reclaim;
+    domain->reclaim_ctx = ctx;
+    for (size_t i = 0; i < EPOCH_MAX_THREADS; i++) {
+        struct epoch_thread * thread = &domain->threads[i];
+        atomic_init(&thread->state, 0);
+        atomic_init(&thread->in_use, false);
+        thread->domain = domain;
+        thread->retired_head = 0;
+        thread->retired_count = 0;
+    }
+    return true;
+}
+
+/* Reclaim retired pointers, oldest first, up to and including epoch safe */
+static void reclaim_up_to(struct epoch_thread * thread, uint64_t safe) {
+    struct epoch_domain * domain = thread->domain;
+    while (thread->retired_count != 0) {
+        struct epoch_retired * r = &thread->retired[thread->retired_head];
+        if (r->epoch > safe) {
+            break;
+        }
+        domain->reclaim(r->ptr, domain->reclaim_ctx);
+        thread->retired_head = (thread->retired_head + 1) % EPOCH_RETIRE_CAPACITY;
+        --thread->retired_count;
+    }
+}
+
+/* Reclaim everything still retired */
+bool epoch_domain_destroy(struct epoch_domain * domain) {
+    INVALID_PTR_CHECK(domain, false);
+    for (size_t i = 0; i < EPOCH_MAX_THREADS; i++) {
+        reclaim_up_to(&domain->threads[i], UINT64_MAX);
+    }
+    return true;
+}
+
+/* Claim a free per-thread slot */
+struct epoch_thread * epoch_register(struct epoch_domain * domain) {
+    INVALID_PTR_CHECK(domain, NULL);
+    for (size_t i = 0; i < EPOCH_MAX_THREADS; i++) {
+        struct epoch_thread * thread = &domain->threads[i];
+        bool expected = false;
+        if (!atomic_load_explicit(&thread->in_use, memory_order_relaxed) &&
+                atomic_compare_exchange_strong(&thread->in_use, &expected, true)) {
+            return thread;
+        }
+    }
+    return NULL;
+}
+
+/* Try to move the global epoch forward. Succeeds only when every thread
+   inside a critical section has observed the current epoch. Returns the
+   global epoch afterwards. The fence orders the caller's earlier unlinks
+   before the scan, so a thread the scan misses as active is one whose
+   loads come after those unlinks (see epoch_enter()). */
+static uint64_t try_advance(struct epoch_domain * domain) {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t epoch = atomic_load(&domain->global_epoch);
+    for (size_t i = 0; i < EPOCH_MAX_THREADS; i++) {
+        struct epoch_thread * thread = &domain->threads[i];
+        if (!atomic_load_explicit(&thread->in_use, memory_order_acquire)) {
+            continue;
+        }
+        uint64_t state = atomic_load(&thread->state);
+        if ((state & STATE_ACTIVE) && STATE_EPOCH(state) != epoch) {
+            return epoch;
+        }
+    }
+    atomic_compare_exchange_strong(&domain->global_epoch, &epoch, epoch + 1);
+    return atomic_load(&domain->global_epoch);
+}
+
+/* Reclaim what the current epoch allows. Pointers retired in epoch e are
+   unreachable to anyone who entered in e + 1 or later, and nobody can still
+   be in e once the global epoch reaches e + 2. */
+static void collect(struct epoch_thread * thread) {
+    uint64_t epoch = try_advance(thread->domain);
+    if (epoch >= 2) {
+        reclaim_up_to(thread, epoch - 2);
+    }
+}
+
+/* Release per-thread state once its retirements are reclaimed */
+bool epoch_unregister(struct epoch_thread * thread) {
+    INVALID_PTR_CHECK(thread, false);
+    epoch_barrier(thread);
+    atomic_store(&thread->state, 0);
+    atomic_store_explicit(&thread->in_use, false, memory_order_release);
+    return true;
+}
+
+/* Enter a read-side critical section. A store, even a sequentially
+   consistent one, doesn't keep later acquire or relaxed loads from being
+   performed ahead of it, so the fence is what orders the announcement
+   before any load of shared nodes. It pairs with the fence in
+   try_advance(). */
+void epoch_enter(struct epoch_thread * thread) {
+    uint64_t epoch = atomic_load(&thread->domain->global_epoch);
+    atomic_store_explicit(&thread->state, (epoch << 1) | STATE_ACTIVE, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* Leave a read-side critical section, keeping half the retire ring free */
+void epoch_exit(struct epoch_thread * thread) {
+    atomic_store_explicit(&thread->state, 0, memory_order_release);
+    while (thread->retired_count > EPOCH_RETIRE_CAPACITY / 2) {
+        collect(thread);
+        if (thread->retired_count > EPOCH_RETIRE_CAPACITY / 2) {
+            sched_yield();
+        }
+    }
+}
+
+/* Defer reclamation of an unlinked pointer */
+bool epoch_retire(struct epoch_thread * thread, void * ptr) {
+    INVALID_PTR_CHECK(thread, false);
+    INVALID_PTR_CHECK(ptr, false);
+
+    bool active = atomic_load_explicit(&thread->state, memory_order_relaxed) & STATE_ACTIVE;
+    while (thread->retired_count == EPOCH_RETIRE_CAPACITY) {
+        if (active) {
+            return false;
+        }
+        collect(thread);
+        if (thread->retired_count == EPOCH_RETIRE_CAPACITY) {
+            sched_yield();
+        }
+    }
+
+    size_t tail = (thread->retired_head + thread->retired_count) % EPOCH_RETIRE_CAPACITY;
+    thread->retired[tail].ptr = ptr;
+    thread->retired[tail].epoch = atomic_load(&thread->domain->global_epoch);
+    ++thread->retired_count;
+    return true;
+}
+
+/* Wait until all of this thread's retirements are reclaimed */
+bool epoch_barrier(struct epoch_thread * thread) {
+    INVALID_PTR_CHECK(thread, false);
+    while (thread->retired_count != 0) {
+        collect(thread);
+        if (thread->retired_count != 0) {
+            sched_yield();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef EPOCH_H_
+#define EPOCH_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Epoch-based reclamation.
+
+   Threads that read shared nodes do so between epoch_enter() and
+   epoch_exit(). A node unlinked from a shared structure is handed to
+   epoch_retire() rather than freed: it is only reclaimed once the global
+   epoch has advanced twice past the epoch it was retired in, at which
+   point no thread can still be reading it. The global epoch only
+   advances when every thread inside a critical section has observed the
+   current one.
+
+   The domain performs no allocation of its own. Its storage is provided
+   by the owning data structure, and each thread retires into a fixed size
+   ring. epoch_exit() makes sure at least half the ring is free before the
+   next critical section starts, waiting on other readers if it has to, so
+   a critical section may retire up to EPOCH_RETIRE_CAPACITY / 2 pointers. */
+
+#define EPOCH_MAX_THREADS       (64)
+#define EPOCH_RETIRE_CAPACITY   (256)
+
+// Padding used to keep per-thread hot state on its own cache line.
+//
+#define EPOCH_CACHE_LINE        (64)
+
+struct epoch_domain;
+
+struct epoch_retired {
+    void * ptr;
+    uint64_t epoch;
+};
+
+// Per-thread state. state holds (epoch << 1) | active.
+//
+struct epoch_thread {
+    _Atomic uint64_t state;
+    atomic_bool in_use;
+    struct epoch_domain * domain;
+    size_t retired_head;
+    size_t retired_count;
+    struct epoch_retired retired[EPOCH_RETIRE_CAPACITY];
+    char pad[EPOCH_CACHE_LINE];
+};
+
+struct epoch_domain {
+    _Atomic uint64_t global_epoch;
+    char pad[EPOCH_CACHE_LINE];
+    void (*reclaim)(void * ptr, void * ctx);
+    void * reclaim_ctx;
+    struct epoch_thread threads[EPOCH_MAX_THREADS];
+};
+
+// Initializes a domain in caller-provided storage.
+// \param domain  : Domain to initialize.
+// \param reclaim : Called on every retired pointer once it is safe to free.
+// \param ctx     : Passed through to reclaim.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool epoch_domain_init(struct epoch_domain * domain,
+                       void (*reclaim)(void * ptr, void * ctx),
+                       void * ctx);
+
+// Reclaims everything still retired in a domain.
+// PRECONDITION: No thread is inside a critical section.
+// \param domain : Domain to tear down.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool epoch_domain_destroy(struct epoch_domain * domain);
+
+// Claims per-thread state for the calling thread.
+// \param domain : Domain to register with.
+// Returns the thread's state on success, NULL if all slots are taken.
+//
+struct epoch_thread * epoch_register(struct epoch_domain * domain);
+
+// Releases per-thread state, first waiting until everything the thread
+// retired has been reclaimed.
+// \param thread : Thread state from epoch_register().
+// Returns TRUE on success, FALSE otherwise.
+//
+bool epoch_unregister(struct epoch_thread * thread);
+
+// Enters a read-side critical section.
+// \param thread : Thread state from epoch_register().
+//
+void epoch_enter(struct epoch_thread * thread);
+
+// Leaves a read-side critical section. If the thread's retire ring is more
+// than half full, reclaims what it can and waits for other readers until
+// it is back to half.
+// \param thread : Thread state from epoch_register().
+//
+void epoch_exit(struct epoch_thread * thread);
+
+// Defers reclamation of a pointer that is no longer reachable by new
+// readers. Usually called from inside a critical section, straight after
+// the pointer was unlinked.
+// \param thread : Thread state from epoch_register().
+// \param ptr    : Pointer to retire.
+// Returns TRUE on success, FALSE if the retire ring is full while the
+// thread is inside a critical section (more than EPOCH_RETIRE_CAPACITY / 2
+// retirements in one section).
+//
+bool epoch_retire(struct epoch_thread * thread, void * ptr);
+
+// Waits until everything the thread has retired so far has been reclaimed.
+// \param thread : Thread state from epoch_register(), outside a critical section.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool epoch_barrier(struct epoch_thread * thread);
+
+#endif
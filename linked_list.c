@@ -23,10 +23,16 @@ SOFTWARE.
 */
 
 #include "linked_list.h"
+#include "counting_bloom.h"
+#include "epoch.h"
 #include "stdlib.h"
 #include "stdint.h"
 #include "stdbool.h"
 #include "stdio.h"
+#include "string.h"
+#include "pthread.h"
+#include "unistd.h"
+#include "stdatomic.h"
 
 // Function pointers to (potentially) custom malloc() and
 // free() functions.
@@ -35,21 +41,575 @@ SOFTWARE.
 static void * (*malloc_fptr)(size_t size) = NULL;
 static void   (*free_fptr)(void* addr)    = NULL; 
 
-/* Create a new linked list node */
-static inline struct node * create_node(unsigned int data) {
-    struct node * new = (struct node *) malloc_fptr(sizeof(struct node));
+/* Nodes handed out in bulk are carved from blocks allocated with a single
+   malloc_fptr() call. A pooled node can't be handed to free_fptr() on its
+   own, so a removed pooled node goes back onto its block's free list and
+   is reused by later inserts. Each block counts its nodes in use and is
+   released as soon as none are, mirroring how the slab allocator drops an
+   unused slab. A pooled node keeps its index in its block in the high
+   bits of flags, which is how a release finds the block.
+
+   Nodes move between lists on the registered allocator, so all of them
+   share the pool and node_pool_lock guards it. Single inserts and removes
+   don't take the lock: each list keeps a few pooled nodes of its own (see
+   node_cache_take()) and only goes to the pool to refill or trim that
+   cache. node_pool_available lets a refill skip the lock when there is
+   nothing to reuse. */
+struct node_block {
+    struct node_block * next;      // Blocks with nodes to hand out, see node_pool_blocks
+    struct node_block * prev;
+    struct node * free_list;       // Released nodes, linked by next
+    size_t count;
+    size_t bump;                   // nodes[bump] on were never handed out
+    size_t live;                   // Nodes in use by a list
+    struct node nodes[];
+};
+
+/* Smallest block allocated for a bulk insert, so repeated small bulk
+   inserts don't each pay for a malloc_fptr() call. The largest is what
+   the index bits of flags can address. */
+#define NODE_BLOCK_MIN_NODES   (64)
+#define NODE_BLOCK_MAX_NODES   ((size_t) 1 << (32 - NODE_POOL_INDEX_SHIFT))
+
+/* Most nodes a compaction step moves into one block, see
+   linked_list_set_compact_block_nodes() */
+static size_t compact_block_nodes = NODE_BLOCK_MAX_NODES;
+
+static pthread_mutex_t node_pool_lock       = PTHREAD_MUTEX_INITIALIZER;
+static struct node_block * node_pool_blocks = NULL;  // Only blocks with nodes to hand out
+static _Atomic size_t node_pool_available   = 0;     // Nodes those blocks can hand out
+
+/* Block a pooled node was carved from */
+static inline struct node_block * node_block_of(struct node * node) {
+    struct node * first = node - (node->flags >> NODE_POOL_INDEX_SHIFT);
+    return (struct node_block *) ((char *) first - offsetof(struct node_block, nodes));
+}
+
+static void node_block_link(struct node_block * block) {
+    block->prev = NULL;
+    block->next = node_pool_blocks;
+    if (node_pool_blocks != NULL) {
+        node_pool_blocks->prev = block;
+    }
+    node_pool_blocks = block;
+}
+
+static void node_block_unlink(struct node_block * block) {
+    if (block->prev == NULL) {
+        node_pool_blocks = block->next;
+    }
+    else {
+        block->prev->next = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+}
+
+/* Allocate a block of count nodes, none of them handed out yet */
+static struct node_block * node_block_create(size_t count) {
+    struct node_block * block = (struct node_block *) malloc_fptr(sizeof(struct node_block) +
+                                                                  count * sizeof(struct node));
+    if (block == NULL) {
+        return NULL;
+    }
+    block->free_list = NULL;
+    block->count = count;
+    block->bump = 0;
+    block->live = 0;
+    return block;
+}
+
+/* Hand out a node of a block in the pool, unlinking the block once it has
+   none left. Called with node_pool_lock held. */
+static struct node * node_block_take(struct node_block * block) {
+    struct node * new = block->free_list;
+    if (new != NULL) {
+        block->free_list = new->next;
+    }
+    else {
+        new = &block->nodes[block->bump++];
+    }
+    new->flags = ((unsigned int) (new - block->nodes) << NODE_POOL_INDEX_SHIFT) | NODE_FLAG_POOLED;
+    ++block->live;
+    if (block->free_list == NULL && block->bump == block->count) {
+        node_block_unlink(block);
+    }
+    return new;
+}
+
+/* Take n pooled nodes at once, chained through next in the order they
+   should be used. Whatever the pool can't supply comes from new blocks,
+   all allocated before any node is taken, so a failure changes nothing. */
+static bool node_pool_take_chain(size_t n, struct node ** chain) {
+    *chain = NULL;
+    if (n == 0) {
+        return true;
+    }
+    pthread_mutex_lock(&node_pool_lock);
+    size_t avail = atomic_load_explicit(&node_pool_available, memory_order_relaxed);
+    if (avail < n) {
+        struct node_block * fresh = NULL;
+        size_t added = 0;
+        while (added < n - avail) {
+            size_t count = n - avail - added;
+            count = (count < NODE_BLOCK_MIN_NODES) ? NODE_BLOCK_MIN_NODES : count;
+            count = (count > NODE_BLOCK_MAX_NODES) ? NODE_BLOCK_MAX_NODES : count;
+            struct node_block * block = node_block_create(count);
+            if (block == NULL) {
+                while (fresh != NULL) {
+                    struct node_block * next = fresh->next;
+                    free_fptr(fresh);
+                    fresh = next;
+                }
+                pthread_mutex_unlock(&node_pool_lock);
+                return false;
+            }
+            block->next = fresh;
+            fresh = block;
+            added += count;
+        }
+        // Linked in front, so the new nodes are used first and in order
+        while (fresh != NULL) {
+            struct node_block * next = fresh->next;
+            node_block_link(fresh);
+            fresh = next;
+        }
+        atomic_fetch_add_explicit(&node_pool_available, added, memory_order_relaxed);
+    }
+
+    struct node * last = NULL;
+    for (size_t i = 0; i < n; i++) {
+        struct node * new = node_block_take(node_pool_blocks);
+        new->next = NULL;
+        if (last == NULL) {
+            *chain = new;
+        }
+        else {
+            last->next = new;
+        }
+        last = new;
+    }
+    atomic_fetch_sub_explicit(&node_pool_available, n, memory_order_relaxed);
+    pthread_mutex_unlock(&node_pool_lock);
+    return true;
+}
+
+/* Give a pooled node back to its block. Returns the block, already out of
+   the pool, once none of its nodes are in use so the caller can free it
+   after dropping the lock. Called with node_pool_lock held. */
+static struct node_block * node_block_put(struct node * node) {
+    struct node_block * block = node_block_of(node);
+    if (--block->live == 0) {
+        if (block->free_list != NULL || block->bump != block->count) {
+            node_block_unlink(block);
+        }
+        atomic_fetch_sub_explicit(&node_pool_available, block->count - 1, memory_order_relaxed);
+        return block;
+    }
+    if (block->free_list == NULL && block->bump == block->count) {
+        node_block_link(block);
+    }
+    node->next = block->free_list;
+    block->free_list = node;
+    atomic_fetch_add_explicit(&node_pool_available, 1, memory_order_relaxed);
+    return NULL;
+}
+
+/* Give a chain of pooled nodes, linked by next, back to the pool under a
+   single lock, freeing the blocks left with none in use */
+static void node_pool_release_chain(struct node * chain) {
+    if (chain == NULL) {
+        return;
+    }
+    struct node_block * unused = NULL;
+    pthread_mutex_lock(&node_pool_lock);
+    while (chain != NULL) {
+        struct node * next = chain->next;
+        struct node_block * block = node_block_put(chain);
+        if (block != NULL) {
+            block->next = unused;
+            unused = block;
+        }
+        chain = next;
+    }
+    pthread_mutex_unlock(&node_pool_lock);
+    while (unused != NULL) {
+        struct node_block * next = unused->next;
+        free_fptr(unused);
+        unused = next;
+    }
+}
+
+/* Most pooled nodes a list keeps for its own inserts, and how many a
+   refill takes from the pool at once. Cached nodes stay in use as far as
+   their blocks are concerned, so the cap also bounds how long a list can
+   keep another list's released blocks alive. */
+#define NODE_CACHE_MAX      (64)
+#define NODE_CACHE_REFILL   (16)
+
+/* Take a pooled node from the list's cache, refilling it from the pool
+   first if it is empty. NULL if the pool has no node to spare either. */
+static struct node * node_cache_take(struct linked_list * ll) {
+    if (ll->node_cache == NULL) {
+        if (atomic_load_explicit(&node_pool_available, memory_order_relaxed) == 0) {
+            return NULL;
+        }
+        // Kept in the order the pool hands them out, so consecutive
+        // inserts still get neighbouring nodes of the same block
+        struct node * last = NULL;
+        pthread_mutex_lock(&node_pool_lock);
+        while (ll->node_cache_count < NODE_CACHE_REFILL && node_pool_blocks != NULL) {
+            struct node * new = node_block_take(node_pool_blocks);
+            new->next = NULL;
+            if (last == NULL) {
+                ll->node_cache = new;
+            }
+            else {
+                last->next = new;
+            }
+            last = new;
+            ++ll->node_cache_count;
+        }
+        atomic_fetch_sub_explicit(&node_pool_available, ll->node_cache_count, memory_order_relaxed);
+        pthread_mutex_unlock(&node_pool_lock);
+        if (last == NULL) {
+            return NULL;
+        }
+    }
+    struct node * new = ll->node_cache;
+    ll->node_cache = new->next;
+    --ll->node_cache_count;
+    new->flags &= ~NODE_FLAG_MARKER;
+    return new;
+}
+
+/* Keep a released pooled node in the list's cache. A full cache hands its
+   older half back to the pool first. */
+static void node_cache_put(struct linked_list * ll, struct node * node) {
+    if (ll->node_cache_count == NODE_CACHE_MAX) {
+        struct node * keep = ll->node_cache;
+        for (unsigned int i = 1; i < NODE_CACHE_MAX / 2; i++) {
+            keep = keep->next;
+        }
+        node_pool_release_chain(keep->next);
+        keep->next = NULL;
+        ll->node_cache_count = NODE_CACHE_MAX / 2;
+    }
+    node->next = ll->node_cache;
+    ll->node_cache = node;
+    ++ll->node_cache_count;
+}
+
+/* Hand every cached node back to the pool */
+static void node_cache_flush(struct linked_list * ll) {
+    node_pool_release_chain(ll->node_cache);
+    ll->node_cache = NULL;
+    ll->node_cache_count = 0;
+}
+
+/* Per-list allocation. A list created with its own allocator gets every
+   node, table and domain from it and never touches the shared node pool,
+   which stays on the registered malloc_fptr()/free_fptr(). */
+static inline void * ll_malloc(struct linked_list * ll, size_t size) {
+    if (ll->allocator != NULL) {
+        return ll->allocator->malloc(ll->allocator_ctx, size);
+    }
+    return malloc_fptr(size);
+}
+
+static inline void ll_free(struct linked_list * ll, void * addr) {
+    if (ll->allocator != NULL) {
+        ll->allocator->free(ll->allocator_ctx, addr);
+    }
+    else {
+        free_fptr(addr);
+    }
+}
+
+/* Nodes can only move between lists that release them the same way */
+static inline bool same_allocator(const struct linked_list * a, const struct linked_list * b) {
+    return a->allocator == b->allocator && a->allocator_ctx == b->allocator_ctx;
+}
+
+/* Release a single node */
+static inline void release_node(struct linked_list * ll, struct node * node) {
+    if (node->flags & NODE_FLAG_INLINE) {
+        ll->inline_free |= 1u << (node - ll->inline_nodes);
+    }
+    else if (node->flags & NODE_FLAG_POOLED) {
+        node_cache_put(ll, node);
+    }
+    else {
+        ll_free(ll, node);
+    }
+}
+
+/* Read-mostly mode (linked_list_rcu_enable()). A store that makes a new
+   node reachable is a release, so a reader that follows the link sees the
+   node fully initialized. Readers load links once into a local with an
+   acquire load, the pairing half; that's a plain load on x86 and a single
+   ldar on arm64. A store that only routes readers around a node is a
+   release as well: the reader that loads it may not have passed through
+   the store that first published the node it now points to. */
+#define PUBLISH(_link, _node)   __atomic_store_n(&(_link), (_node), __ATOMIC_RELEASE)
+#define READ_LINK(_link)        __atomic_load_n(&(_link), __ATOMIC_ACQUIRE)
+
+/* Readers also read the length (linked_list_size()), so the operations a
+   read-mostly list allows store it atomically. Only the writer stores it,
+   so the writer itself can still read it plainly. */
+#define SET_LEN(_ll, _len)      __atomic_store_n(&(_ll)->len, (_len), __ATOMIC_RELAXED)
+#define READ_LEN(_ll)           __atomic_load_n(&(_ll)->len, __ATOMIC_RELAXED)
+
+/* Operations that relink many nodes at once can't be made safe for
+   concurrent readers one store at a time, so read-mostly lists refuse them */
+#define RCU_UNSUPPORTED_CHECK(_ll, _ret_val) \
+do { \
+    if ((_ll)->rcu_writer != NULL) { \
+        return _ret_val; \
+    } \
+} while (0)
+
+/* Membership filter (linked_list_filter_enable()). Values are added as
+   their node is created, before it is published, and removed as it is
+   retired, after it is unlinked, so the filter never misses a value a
+   reader could still find. */
+static inline void filter_add(struct linked_list * ll, unsigned int data) {
+    if (ll->filter != NULL) {
+        counting_bloom_add(ll->filter, data);
+    }
+}
+
+static inline void filter_remove(struct linked_list * ll, unsigned int data) {
+    if (ll->filter != NULL) {
+        counting_bloom_remove(ll->filter, data);
+    }
+}
+
+/* Move the values of the chain first..last from src's filter to dst's */
+static void filter_move(struct linked_list * dst, struct linked_list * src,
+                        struct node * first, struct node * last) {
+    if (dst->filter == NULL && src->filter == NULL) {
+        return;
+    }
+    for (struct node * current = first; ; current = current->next) {
+        filter_remove(src, current->data);
+        filter_add(dst, current->data);
+        if (current == last) {
+            break;
+        }
+    }
+}
+
+/* Epoch reclaim callback for read-mostly lists, ctx is the list */
+static void rcu_reclaim_node(void * ptr, void * ctx) {
+    release_node((struct linked_list *) ctx, (struct node *) ptr);
+}
+
+/* Release a node that has just been unlinked. In read-mostly mode readers
+   may still be on it, so it keeps its links until a grace period has
+   passed. */
+static inline void retire_node(struct linked_list * ll, struct node * node) {
+    filter_remove(ll, node->data);
+    if (node->flags & NODE_FLAG_INLINE) {
+        --ll->inline_live;
+    }
+    if (ll->rcu_writer != NULL) {
+        epoch_retire(ll->rcu_writer, node);
+    }
+    else {
+        release_node(ll, node);
+    }
+}
+
+/* Inline nodes (LINKED_LIST_INLINE_NODES). They are part of the list's
+   own struct, so they can never be handed to another list: operations
+   that move nodes between lists swap them for allocated nodes first. */
+#define INLINE_ALL_FREE     ((1u << LINKED_LIST_INLINE_NODES) - 1)
+
+_Static_assert(LINKED_LIST_INLINE_NODES < 32, "inline_free has a bit per inline node");
+
+static inline unsigned int inline_free_count(const struct linked_list * ll) {
+    return (unsigned int) __builtin_popcount(ll->inline_free);
+}
+
+/* Take an unused inline node; the caller checks there is one */
+static inline struct node * inline_take(struct linked_list * ll) {
+    unsigned int slot = (unsigned int) __builtin_ctz(ll->inline_free);
+    ll->inline_free &= ll->inline_free - 1;
+    ++ll->inline_live;
+    struct node * new = &ll->inline_nodes[slot];
+    new->flags = NODE_FLAG_INLINE;
+    return new;
+}
+
+/* Take a node kept by linked_list_clear(). It is still accounted to the
+   list, so only its marker flags need resetting. */
+static inline struct node * spare_take(struct linked_list * ll) {
+    struct node * new = ll->spare;
+    ll->spare = new->next;
+    --ll->spare_count;
+    new->flags &= ~NODE_FLAG_MARKER;
+    if (new->flags & NODE_FLAG_INLINE) {
+        ll->inline_spare &= ~(1u << (new - ll->inline_nodes));
+        ++ll->inline_live;
+    }
+    return new;
+}
+
+/* Allocate a node outside the list: a free pooled node when one is
+   available, otherwise one from the list's allocator */
+static inline struct node * allocate_node(struct linked_list * ll) {
+    if (ll->allocator == NULL) {
+        struct node * new = node_cache_take(ll);
+        if (new != NULL) {
+            return new;
+        }
+    }
+    struct node * new = (struct node *) ll_malloc(ll, sizeof(struct node));
+    INVALID_PTR_CHECK(new, NULL);
+    new->flags = 0;
+    return new;
+}
+
+/* Inline nodes linked into the list, as opposed to unused or kept on the
+   spare chain */
+static inline unsigned int inline_linked(const struct linked_list * ll) {
+    return INLINE_ALL_FREE & ~(ll->inline_free | ll->inline_spare);
+}
+
+/* Collect the inline nodes among the count nodes from first on into found,
+   returning how many there are. Stops early once every inline node in the
+   list has been seen. */
+static unsigned int inline_find(const struct linked_list * ll, struct node * first, size_t count,
+                                struct node ** found) {
+    unsigned int n = 0;
+    struct node * current = first;
+    for (size_t i = 0; i < count && n != ll->inline_live; i++) {
+        if (current->flags & NODE_FLAG_INLINE) {
+            found[n++] = current;
+        }
+        current = current->next;
+    }
+    return n;
+}
+
+/* Replace the n inline nodes in found with allocated ones, before they
+   move to another list. Every replacement is allocated before any node
+   is swapped, so on failure the list is unchanged. *first is updated if
+   it was replaced. */
+static bool inline_evict(struct linked_list * ll, struct node ** found, unsigned int n,
+                         struct node ** first) {
+    struct node * replacements[LINKED_LIST_INLINE_NODES];
+    for (unsigned int i = 0; i < n; i++) {
+        replacements[i] = allocate_node(ll);
+        if (replacements[i] == NULL) {
+            while (i-- > 0) {
+                release_node(ll, replacements[i]);
+            }
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        struct node * current = found[i];
+        struct node * new = replacements[i];
+        new->data = current->data;
+        new->prev = current->prev;
+        new->next = current->next;
+        if (new->prev == NULL) {
+            ll->head = new;
+        }
+        else {
+            new->prev->next = new;
+        }
+        if (new->next == NULL) {
+            ll->tail = new;
+        }
+        else {
+            new->next->prev = new;
+        }
+        if (current == *first) {
+            *first = new;
+        }
+        --ll->inline_live;
+        release_node(ll, current);
+    }
+    return true;
+}
+
+/* Create a new linked list node. Reuses a node kept by linked_list_clear(),
+   then an unused inline node, before allocating one */
+static inline struct node * create_node(struct linked_list * ll, unsigned int data) {
+    struct node * new;
+    if (ll->spare != NULL) {
+        new = spare_take(ll);
+    }
+    else if (ll->inline_free != 0) {
+        new = inline_take(ll);
+    }
+    else {
+        new = allocate_node(ll);
+        INVALID_PTR_CHECK(new, NULL);
+    }
     new->data = data;
     new->next = NULL;
     new->prev = NULL;
+    filter_add(ll, data);
     return new;
 }
 
+/* Software prefetch for traversals. Nodes allocated together (bulk inserts,
+   compaction, consecutive slab allocations) sit at consecutive addresses, so
+   when a hop lands on the neighbouring node in memory, the node distance
+   hops ahead most likely sits distance nodes further along in the same
+   direction. A prefetch never faults, so a wrong guess only costs
+   bandwidth, and hops that jump elsewhere in memory issue nothing. */
+static inline void prefetch_ahead(const struct node * current, const struct node * next,
+                                  unsigned int distance) {
+    intptr_t stride = (intptr_t) next - (intptr_t) current;
+    if (distance != 0 && (stride == (intptr_t) sizeof(struct node) ||
+                          stride == -(intptr_t) sizeof(struct node))) {
+        __builtin_prefetch((const void *) ((intptr_t) current + stride * (intptr_t) distance));
+    }
+}
+
+/* Release a chain of unlinked nodes, linked by next. Pooled nodes go
+   back to the pool together under a single lock rather than through the
+   list's cache. */
+static void release_chain(struct linked_list * ll, struct node * chain) {
+    unsigned int distance = ll->prefetch_distance;
+    struct node * pooled = NULL;
+    while (chain != NULL) {
+        struct node * next = chain->next;
+        prefetch_ahead(chain, next, distance);
+        if (chain->flags & NODE_FLAG_POOLED) {
+            chain->next = pooled;
+            pooled = chain;
+        }
+        else {
+            release_node(ll, chain);
+        }
+        chain = next;
+    }
+    node_pool_release_chain(pooled);
+}
+
+/* Release every node kept by linked_list_clear() */
+static void spare_release(struct linked_list * ll) {
+    release_chain(ll, ll->spare);
+    ll->spare = NULL;
+    ll->spare_count = 0;
+    ll->inline_spare = 0;
+}
+
 /* Determine if it's quicker to reach the desired index from the head or the tail and
    return a pointer to the node at the provided index */
 static inline struct node * linked_list_traverse_to_index(struct linked_list * ll, unsigned int index) {
-    // Check edges and bad inputs
+    // Check edges and bad inputs. Index 0 is how read-mostly readers
+    // start a traversal.
     if (index == 0) {
-        return ll->head;
+        return READ_LINK(ll->head);
     }
     else if (index == ll->len-1) {
         return ll->tail;
@@ -59,16 +619,19 @@ static inline struct node * linked_list_traverse_to_index(struct linked_list * l
     }
 
     // Determine if it's quicker to iterate to the desired index from the head or tail
+    unsigned int distance = ll->prefetch_distance;
     struct node * current;
     if (index >= ll->len/2) {  // If the index is in the tail half of the list, iterate from the tail
         current = ll->tail->prev; // iterate from tail->prev rather than tail to save some cycles
         for (unsigned int i = ll->len-2; i > index && current != NULL; i--) {
+            prefetch_ahead(current, current->prev, distance);
             current = current->prev;
         }
     }
     else {  // If the index is in the head half of the list, iterate from the head
         current = ll->head->next; // iterate from tail->prev rather than tail to save some cycles
         for (unsigned int i = 1; i < index && current != NULL; i++) {
+            prefetch_ahead(current, current->next, distance);
             current = current->next;
         }
     }
@@ -81,13 +644,225 @@ static inline struct node * linked_list_traverse_to_index(struct linked_list * l
     return current;
 }
 
-/* Create a new linked list */
+/* Link a new node in front of pos, or at the tail if pos is NULL */
+static inline void link_before(struct linked_list * ll, struct node * pos, struct node * new) {
+    new->next = pos;
+    new->prev = (pos == NULL) ? ll->tail : pos->prev;
+    if (new->prev == NULL) {
+        PUBLISH(ll->head, new);
+    }
+    else {
+        PUBLISH(new->prev->next, new);
+    }
+    if (pos == NULL) {
+        PUBLISH(ll->tail, new);
+    }
+    else {
+        PUBLISH(pos->prev, new);
+    }
+    SET_LEN(ll, ll->len + 1);
+}
+
+/* Unlink a node from the list without releasing it */
+static inline void unlink_node(struct linked_list * ll, struct node * node) {
+    if (node->prev == NULL) {
+        PUBLISH(ll->head, node->next);
+    }
+    else {
+        PUBLISH(node->prev->next, node->next);
+    }
+    if (node->next == NULL) {
+        PUBLISH(ll->tail, node->prev);
+    }
+    else {
+        PUBLISH(node->next->prev, node->prev);
+    }
+    SET_LEN(ll, ll->len - 1);
+}
+
+/* Segment table for parallel scans. entries[i] marks the node that starts
+   segment i + 1; segment 0 starts at the head. Stored indices are relative
+   to base, so an insert or remove in front of every marker, which includes
+   everything at the head of the list, shifts them all by updating base. */
+struct segment_marker {
+    struct node * node;
+    ptrdiff_t index;
+};
+
+struct segment_table {
+    size_t count;
+    size_t capacity;
+    ptrdiff_t base;
+    struct segment_marker entries[];
+};
+
+static inline size_t segment_index(const struct segment_table * t, size_t i) {
+    return (size_t) (t->entries[i].index + t->base);
+}
+
+/* First entry whose node sits at index or later */
+static size_t segments_lower_bound(const struct segment_table * t, size_t index) {
+    size_t lo = 0;
+    size_t hi = t->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (segment_index(t, mid) < index) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Shift every marker at index from or later by delta */
+static void segments_shift(struct segment_table * t, size_t from, ptrdiff_t delta) {
+    size_t j = segments_lower_bound(t, from);
+    if (j == 0) {
+        t->base += delta;
+        return;
+    }
+    for (; j < t->count; j++) {
+        t->entries[j].index += delta;
+    }
+}
+
+/* Drop a list's segment table; the next parallel scan rebuilds it */
+static void segments_drop(struct linked_list * ll) {
+    struct segment_table * t = ll->segments;
+    if (t == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < t->count; i++) {
+        t->entries[i].node->flags &= ~NODE_FLAG_MARKER;
+    }
+    ll_free(ll, t);
+    ll->segments = NULL;
+}
+
+/* Add a marker after the last one, growing the table by doubling */
+static bool segments_append(struct linked_list * ll, struct node * node, size_t index) {
+    struct segment_table * t = ll->segments;
+    if (t->count == t->capacity) {
+        size_t capacity = t->capacity * 2;
+        struct segment_table * grown = (struct segment_table *) ll_malloc(ll, sizeof(struct segment_table) +
+                                                                              capacity * sizeof(struct segment_marker));
+        if (grown == NULL) {
+            segments_drop(ll);
+            return false;
+        }
+        memcpy(grown, t, sizeof(struct segment_table) + t->count * sizeof(struct segment_marker));
+        grown->capacity = capacity;
+        ll_free(ll, t);
+        ll->segments = t = grown;
+    }
+    t->entries[t->count].node = node;
+    t->entries[t->count].index = (ptrdiff_t) index - t->base;
+    ++t->count;
+    node->flags |= NODE_FLAG_MARKER;
+    return true;
+}
+
+/* Index the next marker belongs at, once the list grows that far */
+static inline size_t segments_next_index(const struct segment_table * t) {
+    return ((t->count == 0) ? 0 : segment_index(t, t->count - 1)) + LINKED_LIST_SEGMENT_NODES;
+}
+
+/* Mark every LINKED_LIST_SEGMENT_NODES-th node of a chain starting at
+   index, until the table fails to grow */
+static void segments_extend(struct linked_list * ll, struct node * current, size_t index) {
+    while (current != NULL && ll->segments != NULL) {
+        size_t next = segments_next_index(ll->segments);
+        while (index < next && current != NULL) {
+            current = current->next;
+            ++index;
+        }
+        if (current != NULL) {
+            segments_append(ll, current, index);
+        }
+    }
+}
+
+/* Build a list's segment table with one walk */
+static bool segments_build(struct linked_list * ll) {
+    size_t capacity = ll->len / LINKED_LIST_SEGMENT_NODES + 1;
+    struct segment_table * t = (struct segment_table *) ll_malloc(ll, sizeof(struct segment_table) +
+                                                                  capacity * sizeof(struct segment_marker));
+    INVALID_PTR_CHECK(t, false);
+    t->count = 0;
+    t->capacity = capacity;
+    t->base = 0;
+    ll->segments = t;
+    segments_extend(ll, ll->head, 0);
+    return ll->segments != NULL;
+}
+
+/* Keep the segment table in step with a node just linked in at index */
+static inline void segments_on_insert(struct linked_list * ll, struct node * node, size_t index) {
+    struct segment_table * t = ll->segments;
+    if (t == NULL) {
+        return;
+    }
+    if (index == ll->len - 1) {
+        if (index >= segments_next_index(t)) {
+            segments_append(ll, node, index);
+        }
+        return;
+    }
+    segments_shift(t, index, 1);
+}
+
+/* Keep the segment table in step with the node at index about to be
+   unlinked. A marker moves to the following node, which takes over its
+   index, unless that node is already a marker or there isn't one. */
+static inline void segments_on_remove(struct linked_list * ll, struct node * node, size_t index) {
+    struct segment_table * t = ll->segments;
+    if (t == NULL) {
+        return;
+    }
+    if (node->flags & NODE_FLAG_MARKER) {
+        size_t j = segments_lower_bound(t, index);
+        struct node * next = node->next;
+        if (next != NULL && !(next->flags & NODE_FLAG_MARKER)) {
+            t->entries[j].node = next;
+            next->flags |= NODE_FLAG_MARKER;
+        }
+        else {
+            memmove(&t->entries[j], &t->entries[j + 1], (t->count - j - 1) * sizeof(struct segment_marker));
+            --t->count;
+        }
+        node->flags &= ~NODE_FLAG_MARKER;
+    }
+    segments_shift(t, index + 1, -1);
+}
+
+/* Create a new linked list on the registered malloc/free functions */
 struct linked_list * linked_list_create(void) {
-    struct linked_list * ll = (struct linked_list *) malloc_fptr(sizeof(struct linked_list));
+    return linked_list_create_with_allocator(NULL, NULL);
+}
+
+/* Create a new linked list on its own allocator */
+struct linked_list * linked_list_create_with_allocator(const struct ll_allocator * ops, void * ctx) {
+    struct linked_list * ll = (struct linked_list *) ((ops != NULL) ? ops->malloc(ctx, sizeof(struct linked_list))
+                                                                    : malloc_fptr(sizeof(struct linked_list)));
     if (ll != NULL) {
+        ll->allocator = ops;
+        ll->allocator_ctx = ctx;
         ll->head = NULL;
         ll->tail = NULL;
         ll->len = 0;
+        ll->prefetch_distance = 0;
+        ll->rcu_writer = NULL;
+        ll->segments = NULL;
+        ll->spare = NULL;
+        ll->spare_count = 0;
+        ll->node_cache = NULL;
+        ll->node_cache_count = 0;
+        ll->filter = NULL;
+        ll->inline_free = INLINE_ALL_FREE;
+        ll->inline_spare = 0;
+        ll->inline_live = 0;
     }
     return ll;
 }
@@ -96,28 +871,133 @@ struct linked_list * linked_list_create(void) {
 bool linked_list_delete(struct linked_list * ll) {
     INVALID_PTR_CHECK(ll, false);
 
-    // Iterate through the list, freeing each node. Faster than calling linked_list_remove() 
-    // repeatedly since we avoid jumping and populating new stack frames
-    struct node * current = ll->head;
-    struct node * next;
-    while(current != NULL) {
-        next = current->next;
-        free_fptr(current);
-        current = next;
+    // Nodes still waiting on a grace period are released first
+    if (ll->rcu_writer != NULL) {
+        struct epoch_domain * domain = ll->rcu_writer->domain;
+        epoch_domain_destroy(domain);
+        ll_free(ll, domain);
+        ll->rcu_writer = NULL;
+    }
+
+    if (ll->segments != NULL) {
+        ll_free(ll, ll->segments);
+        ll->segments = NULL;
+    }
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+        ll->filter = NULL;
     }
 
+    // Release the nodes as one chain. Faster than calling linked_list_remove()
+    // repeatedly since we avoid jumping, populating new stack frames and
+    // taking the pool lock per node
+    release_chain(ll, ll->head);
+    spare_release(ll);
+    node_cache_flush(ll);
+
     // Free the containing ll struct
     ll->head = NULL;
-    free_fptr(ll);
+    ll_free(ll, ll);
+    return true;
+}
+
+/* Empty the list. Retained nodes are spliced onto the spare chain as a
+   whole, so this is O(1) however long the list is. A read-mostly list
+   can't hand its nodes straight to new inserts while readers may still be
+   on them, so it retires them one by one instead. */
+bool linked_list_clear(struct linked_list * ll, bool retain_nodes) {
+    INVALID_PTR_CHECK(ll, false);
+
+    // Marker flags left on retained nodes are reset by spare_take()
+    if (ll->segments != NULL) {
+        ll_free(ll, ll->segments);
+        ll->segments = NULL;
+    }
+
+    struct node * current = ll->head;
+    PUBLISH(ll->head, NULL);
+    if (ll->rcu_writer != NULL) {
+        unsigned int distance = ll->prefetch_distance;
+        while (current != NULL) {
+            struct node * next = current->next;
+            prefetch_ahead(current, next, distance);
+            retire_node(ll, current);
+            current = next;
+        }
+    }
+    else if (!retain_nodes) {
+        release_chain(ll, current);
+        ll->inline_live = 0;
+    }
+    else if (current != NULL) {
+        ll->tail->next = ll->spare;
+        ll->spare = current;
+        ll->spare_count += ll->len;
+        ll->inline_spare = INLINE_ALL_FREE & ~ll->inline_free;
+        ll->inline_live = 0;
+    }
+    if (!retain_nodes) {
+        spare_release(ll);
+        node_cache_flush(ll);
+    }
+    if (ll->filter != NULL) {
+        counting_bloom_reset(ll->filter);
+    }
+
+    PUBLISH(ll->tail, NULL);
+    SET_LEN(ll, 0);
+    return true;
+}
+
+/* Enable or resize the membership filter, filling it from the list.
+   Readers of a read-mostly list may be checking the filter, so it can only
+   be swapped before linked_list_rcu_enable(). */
+bool linked_list_filter_enable(struct linked_list * ll, size_t expected_elements, double false_positive_rate) {
+    INVALID_PTR_CHECK(ll, false);
+    RCU_UNSUPPORTED_CHECK(ll, false);
+    size_t bytes = counting_bloom_size(expected_elements, false_positive_rate);
+    if (bytes == 0) {
+        return false;
+    }
+    struct counting_bloom * filter = (struct counting_bloom *) ll_malloc(ll, bytes);
+    INVALID_PTR_CHECK(filter, false);
+    counting_bloom_init(filter, expected_elements, false_positive_rate);
+    for (struct node * current = ll->head; current != NULL; current = current->next) {
+        counting_bloom_add(filter, current->data);
+    }
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+    }
+    ll->filter = filter;
+    return true;
+}
+
+/* Remove the membership filter */
+bool linked_list_filter_disable(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    RCU_UNSUPPORTED_CHECK(ll, false);
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+        ll->filter = NULL;
+    }
     return true;
 }
 
+/* Get the memory used by the membership filter */
+size_t linked_list_filter_bytes(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter == NULL) {
+        return 0;
+    }
+    return counting_bloom_bytes(ll->filter);
+}
+
 /* Return the size of the linked list. Cache the size as part of the linked_list struct 
    to improve performance */
 size_t linked_list_size(struct linked_list * ll) {
     // Invalid list
     INVALID_PTR_CHECK(ll, SIZE_MAX);
-    return ll->len;
+    return READ_LEN(ll);
 }
 
 /* Insert a new node at the tail of the list */
@@ -125,19 +1005,21 @@ bool linked_list_insert_end(struct linked_list * ll, unsigned int data) {
     INVALID_PTR_CHECK(ll, false);
 
     // Create a new node with the provided data
-    struct node * new = create_node(data);
+    struct node * new = create_node(ll, data);
+    INVALID_PTR_CHECK(new, false);
 
     // Handle empty linked list case
     if (ll->head == NULL) {
-        ll->head = new;
-        ll->tail = ll->head;
-        ++ll->len;
+        PUBLISH(ll->head, new);
+        PUBLISH(ll->tail, new);
+        SET_LEN(ll, ll->len + 1);
         return true;
     }
     new->prev = ll->tail;
-    ll->tail->next = new;
-    ll->tail = new;
-    ++ll->len;
+    PUBLISH(ll->tail->next, new);
+    PUBLISH(ll->tail, new);
+    SET_LEN(ll, ll->len + 1);
+    segments_on_insert(ll, new, ll->len - 1);
     return true; 
 }
 
@@ -146,20 +1028,22 @@ bool linked_list_insert_front(struct linked_list * ll, unsigned int data) {
     INVALID_PTR_CHECK(ll, false);
 
     // Create a new node with the provided data
-    struct node * new = create_node(data);
+    struct node * new = create_node(ll, data);
+    INVALID_PTR_CHECK(new, false);
     new->next = ll->head;
 
     // Handle empty linked list case
     if (ll->head == NULL) {
-        ll->head = new;
-        ll->tail = ll->head;
-        ++ll->len;
+        PUBLISH(ll->head, new);
+        PUBLISH(ll->tail, new);
+        SET_LEN(ll, ll->len + 1);
         return true;
     }
 
-    ll->head->prev = new;
-    ll->head = new;
-    ++ll->len;
+    PUBLISH(ll->head->prev, new);
+    PUBLISH(ll->head, new);
+    SET_LEN(ll, ll->len + 1);
+    segments_on_insert(ll, new, 0);
     return true; 
 }
 
@@ -182,30 +1066,38 @@ bool linked_list_insert(struct linked_list * ll, size_t index, unsigned int data
     }
 
     // Create a new node
-    struct node * new = create_node(data);
+    struct node * new = create_node(ll, data);
+    INVALID_PTR_CHECK(new, false);
 
     // Insert the new node before current, tying up all prev and next pointers
     new->prev = current->prev;
     new->next = current;
-    current->prev->next = new;
-    current->prev = new;
-    ++ll->len;
+    PUBLISH(current->prev->next, new);
+    PUBLISH(current->prev, new);
+    SET_LEN(ll, ll->len + 1);
+    segments_on_insert(ll, new, index);
     return true;
 }
 
 /* Find the first occurrence of a value in the list */
 size_t linked_list_find(struct linked_list * ll, unsigned int data) {
     INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter != NULL && !counting_bloom_maybe_contains(ll->filter, data)) {
+        return SIZE_MAX;
+    }
 
     // Iterate through the list
-    int index = 0;
-    struct node * current = ll->head;
+    unsigned int distance = ll->prefetch_distance;
+    size_t index = 0;
+    struct node * current = READ_LINK(ll->head);
     while(current != NULL) {
         if (current->data == data) {
             return index;
         }
         ++index;
-        current = current->next;
+        struct node * next = READ_LINK(current->next);
+        prefetch_ahead(current, next, distance);
+        current = next;
     }
     return SIZE_MAX;
 }
@@ -220,29 +1112,33 @@ bool linked_list_remove(struct linked_list * ll, size_t index) {
     // Deleting the last node in the list
     if (ll->len == 1) {
         struct node * tmp = ll->head;
-        ll->head = NULL;
-        free_fptr(tmp);
-        --ll->len;
+        segments_on_remove(ll, tmp, 0);
+        PUBLISH(ll->head, NULL);
+        PUBLISH(ll->tail, NULL);
+        retire_node(ll, tmp);
+        SET_LEN(ll, ll->len - 1);
         return true;
     }
 
     // Deleting the head of the linked list
     if (index == 0) {
         struct node * tmp = ll->head;
-        ll->head = tmp->next;
-        ll->head->prev = NULL;
-        free_fptr(tmp);
-        --ll->len;
+        segments_on_remove(ll, tmp, 0);
+        PUBLISH(ll->head, tmp->next);
+        PUBLISH(ll->head->prev, NULL);
+        retire_node(ll, tmp);
+        SET_LEN(ll, ll->len - 1);
         return true;
     }
 
     // Deleting the tail of the linked list
     if (index == ll->len-1) {
         struct node * tmp = ll->tail;
-        ll->tail = tmp->prev;
-        ll->tail->next = NULL;
-        free_fptr(tmp);
-        --ll->len;
+        segments_on_remove(ll, tmp, index);
+        PUBLISH(ll->tail, tmp->prev);
+        PUBLISH(ll->tail->next, NULL);
+        retire_node(ll, tmp);
+        SET_LEN(ll, ll->len - 1);
         return true;
     }
 
@@ -252,30 +1148,689 @@ bool linked_list_remove(struct linked_list * ll, size_t index) {
     }
 
     // otherwise, current points to the index for deletion
-    current->prev->next = current->next;
-    current->next->prev = current->prev;
-    free_fptr(current);
-    --ll->len;
+    segments_on_remove(ll, current, index);
+    PUBLISH(current->prev->next, current->next);
+    PUBLISH(current->next->prev, current->prev);
+    retire_node(ll, current);
+    SET_LEN(ll, ll->len - 1);
     return true;
 }
 
-/* Create an iterator to conveniently traverse nodes and access their members */
-struct iterator * linked_list_create_iterator(struct linked_list * ll, size_t index) {
+/* Get n nodes ready for a bulk insert, so it can't fail half way. Lists on
+   the registered allocator take them from the node pool, lists on their
+   own allocator allocate them, both up front and chained through next. */
+static bool bulk_reserve(struct linked_list * ll, size_t n, struct node ** chain) {
+    *chain = NULL;
+    n -= (n < ll->spare_count) ? n : ll->spare_count;
+    n -= (n < inline_free_count(ll)) ? n : inline_free_count(ll);
+    if (ll->allocator == NULL) {
+        return node_pool_take_chain(n, chain);
+    }
+    for (size_t i = 0; i < n; i++) {
+        struct node * new = (struct node *) ll_malloc(ll, sizeof(struct node));
+        if (new == NULL) {
+            while (*chain != NULL) {
+                struct node * next = (*chain)->next;
+                ll_free(ll, *chain);
+                *chain = next;
+            }
+            return false;
+        }
+        new->flags = 0;
+        new->next = *chain;
+        *chain = new;
+    }
+    return true;
+}
+
+/* Take one of the nodes readied by bulk_reserve() */
+static inline struct node * bulk_take(struct linked_list * ll, struct node ** chain) {
+    if (ll->spare != NULL) {
+        return spare_take(ll);
+    }
+    if (ll->inline_free != 0) {
+        return inline_take(ll);
+    }
+    struct node * new = *chain;
+    *chain = new->next;
+    return new;
+}
+
+/* Insert an array of values at the tail of the list in one pass */
+bool linked_list_insert_end_bulk(struct linked_list * ll, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(ll, false);
+    if (n == 0) {
+        return true;
+    }
+    INVALID_PTR_CHECK(vals, false);
+    struct node * chain;
+    if (!bulk_reserve(ll, n, &chain)) {
+        return false;
+    }
+
+    // Chain the new nodes together behind the current tail, which may be
+    // NULL, then publish the finished chain with a single store
+    struct node * first = NULL;
+    struct node * prev = ll->tail;
+    for (size_t i = 0; i < n; i++) {
+        struct node * new = bulk_take(ll, &chain);
+        new->data = vals[i];
+        filter_add(ll, vals[i]);
+        new->prev = prev;
+        if (first == NULL) {
+            first = new;
+        }
+        else {
+            prev->next = new;
+        }
+        prev = new;
+    }
+    prev->next = NULL;
+    if (ll->tail == NULL) {
+        PUBLISH(ll->head, first);
+    }
+    else {
+        PUBLISH(ll->tail->next, first);
+    }
+    PUBLISH(ll->tail, prev);
+    SET_LEN(ll, ll->len + n);
+    if (ll->segments != NULL) {
+        segments_extend(ll, first, ll->len - n);
+    }
+    return true;
+}
+
+/* Insert an array of values at the head of the list in one pass */
+bool linked_list_insert_front_bulk(struct linked_list * ll, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(ll, false);
+    if (n == 0) {
+        return true;
+    }
+    INVALID_PTR_CHECK(vals, false);
+    struct node * chain;
+    if (!bulk_reserve(ll, n, &chain)) {
+        return false;
+    }
+
+    // Chain the new nodes in front of the current head, back to front so
+    // vals[0] ends up as the head, then publish the finished chain
+    struct node * last = NULL;
+    struct node * next = ll->head;
+    for (size_t i = n; i > 0; i--) {
+        struct node * new = bulk_take(ll, &chain);
+        new->data = vals[i-1];
+        filter_add(ll, vals[i-1]);
+        new->next = next;
+        if (last == NULL) {
+            last = new;
+        }
+        else {
+            next->prev = new;
+        }
+        next = new;
+    }
+    next->prev = NULL;
+    if (ll->head == NULL) {
+        PUBLISH(ll->tail, last);
+    }
+    else {
+        PUBLISH(ll->head->prev, last);
+    }
+    PUBLISH(ll->head, next);
+    SET_LEN(ll, ll->len + n);
+    if (ll->segments != NULL) {
+        segments_shift(ll->segments, 0, (ptrdiff_t) n);
+    }
+    return true;
+}
+
+/* Remove a contiguous range of nodes, releasing them in one pass */
+bool linked_list_remove_range(struct linked_list * ll, size_t start, size_t count) {
+    INVALID_PTR_CHECK(ll, false);
+    if (start > ll->len || count > ll->len - start) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    struct node * current = linked_list_traverse_to_index(ll, start);
+    if (current == NULL) {
+        return false;
+    }
+
+    // Markers inside the range go, the ones after it shift down
+    struct segment_table * t = ll->segments;
+    if (t != NULL) {
+        size_t lo = segments_lower_bound(t, start);
+        size_t hi = segments_lower_bound(t, start + count);
+        for (size_t j = lo; j < hi; j++) {
+            t->entries[j].node->flags &= ~NODE_FLAG_MARKER;
+        }
+        memmove(&t->entries[lo], &t->entries[hi], (t->count - hi) * sizeof(struct segment_marker));
+        t->count -= hi - lo;
+        segments_shift(t, start + count, -(ptrdiff_t) count);
+    }
+
+    // Find the node after the range
+    struct node * first = current;
+    struct node * before = current->prev;
+    for (size_t i = 0; i < count; i++) {
+        current = current->next;
+    }
+
+    // Tie the two sides together, then release the range. The range keeps
+    // its links until it is released, for any reader still walking it.
+    if (before == NULL) {
+        PUBLISH(ll->head, current);
+    }
+    else {
+        PUBLISH(before->next, current);
+    }
+    if (current == NULL) {
+        PUBLISH(ll->tail, before);
+    }
+    else {
+        PUBLISH(current->prev, before);
+    }
+    SET_LEN(ll, ll->len - count);
+
+    for (size_t i = 0; i < count; i++) {
+        struct node * next = first->next;
+        retire_node(ll, first);
+        first = next;
+    }
+    return true;
+}
+
+/* Unlink every node for which pred() returns match, in one walk. Each
+   node is unlinked on its own, so a reader never reaches a removed node
+   it could not have reached before. The removed nodes are released
+   together at the end, so the pool lock is taken once, unless readers may
+   still be on them. Updating the segment table per removal would cost
+   more than the rebuild, so it is dropped. */
+static size_t remove_matching(struct linked_list * ll, bool (*pred)(unsigned int, void *),
+                              void * ctx, bool match) {
+    segments_drop(ll);
+    unsigned int distance = ll->prefetch_distance;
+    size_t removed = 0;
+    struct node * unlinked = NULL;
+    struct node * current = ll->head;
+    while (current != NULL) {
+        struct node * next = current->next;
+        prefetch_ahead(current, next, distance);
+        if (pred(current->data, ctx) == match) {
+            unlink_node(ll, current);
+            if (ll->rcu_writer != NULL) {
+                retire_node(ll, current);
+            }
+            else {
+                filter_remove(ll, current->data);
+                if (current->flags & NODE_FLAG_INLINE) {
+                    --ll->inline_live;
+                }
+                current->next = unlinked;
+                unlinked = current;
+            }
+            ++removed;
+        }
+        current = next;
+    }
+    release_chain(ll, unlinked);
+    return removed;
+}
+
+/* Remove every node matching pred */
+size_t linked_list_remove_if(struct linked_list * ll, bool (*pred)(unsigned int, void *), void * ctx) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    INVALID_PTR_CHECK(pred, SIZE_MAX);
+    return remove_matching(ll, pred, ctx, true);
+}
+
+/* Remove every node not matching pred */
+size_t linked_list_retain_if(struct linked_list * ll, bool (*pred)(unsigned int, void *), void * ctx) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    INVALID_PTR_CHECK(pred, SIZE_MAX);
+    return remove_matching(ll, pred, ctx, false);
+}
+
+/* Append all of src to dst by relinking the two chains */
+bool linked_list_concat(struct linked_list * dst, struct linked_list * src) {
+    INVALID_PTR_CHECK(dst, false);
+    INVALID_PTR_CHECK(src, false);
+    RCU_UNSUPPORTED_CHECK(dst, false);
+    RCU_UNSUPPORTED_CHECK(src, false);
+    if (dst == src || !same_allocator(dst, src)) {
+        return false;
+    }
+    if (src->head == NULL) {
+        return true;
+    }
+    // Every linked inline node moves, so they are found by slot rather
+    // than by walking src
+    struct node * inline_nodes[LINKED_LIST_INLINE_NODES];
+    unsigned int inline_count = 0;
+    for (unsigned int linked = inline_linked(src); linked != 0; linked &= linked - 1) {
+        inline_nodes[inline_count++] = &src->inline_nodes[__builtin_ctz(linked)];
+    }
+    struct node * first = src->head;
+    if (!inline_evict(src, inline_nodes, inline_count, &first)) {
+        return false;
+    }
+    segments_drop(dst);
+    segments_drop(src);
+    filter_move(dst, src, src->head, src->tail);
+
+    if (dst->head == NULL) {
+        dst->head = src->head;
+    }
+    else {
+        dst->tail->next = src->head;
+        src->head->prev = dst->tail;
+    }
+    dst->tail = src->tail;
+    dst->len += src->len;
+
+    src->head = NULL;
+    src->tail = NULL;
+    src->len = 0;
+    return true;
+}
+
+/* Move a range of nodes from src into dst by relinking them */
+bool linked_list_splice(struct linked_list * dst, size_t index,
+                        struct linked_list * src, size_t start, size_t count) {
+    INVALID_PTR_CHECK(dst, false);
+    INVALID_PTR_CHECK(src, false);
+    RCU_UNSUPPORTED_CHECK(dst, false);
+    RCU_UNSUPPORTED_CHECK(src, false);
+    if (dst == src || !same_allocator(dst, src) || index > dst->len ||
+            start > src->len || count > src->len - start) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    // Find both ends of the range, each from whichever end of src is closer.
+    // Inline nodes in the range are swapped out before anything else
+    // changes, so a failed allocation leaves both lists as they were.
+    struct node * first = linked_list_traverse_to_index(src, start);
+    struct node * inline_nodes[LINKED_LIST_INLINE_NODES];
+    unsigned int inline_count = inline_find(src, first, count, inline_nodes);
+    if (!inline_evict(src, inline_nodes, inline_count, &first)) {
+        return false;
+    }
+    segments_drop(dst);
+    segments_drop(src);
+    struct node * last  = linked_list_traverse_to_index(src, start + count - 1);
+    filter_move(dst, src, first, last);
+
+    // Cut the range out of src
+    if (first->prev == NULL) {
+        src->head = last->next;
+    }
+    else {
+        first->prev->next = last->next;
+    }
+    if (last->next == NULL) {
+        src->tail = first->prev;
+    }
+    else {
+        last->next->prev = first->prev;
+    }
+    src->len -= count;
+
+    // Stitch it into dst in front of the node at index, or at the tail
+    struct node * pos = (index == dst->len) ? NULL : linked_list_traverse_to_index(dst, index);
+    first->prev = (pos == NULL) ? dst->tail : pos->prev;
+    last->next = pos;
+    if (first->prev == NULL) {
+        dst->head = first;
+    }
+    else {
+        first->prev->next = first;
+    }
+    if (pos == NULL) {
+        dst->tail = last;
+    }
+    else {
+        pos->prev = last;
+    }
+    dst->len += count;
+    return true;
+}
+
+/* Split off the nodes from index onwards into a new list */
+struct linked_list * linked_list_split(struct linked_list * ll, size_t index) {
     INVALID_PTR_CHECK(ll, NULL);
+    RCU_UNSUPPORTED_CHECK(ll, NULL);
+    if (index > ll->len) {
+        return NULL;
+    }
+
+    struct linked_list * rest = linked_list_create_with_allocator(ll->allocator, ll->allocator_ctx);
+    INVALID_PTR_CHECK(rest, NULL);
+    rest->prefetch_distance = ll->prefetch_distance;
+    if (index == ll->len) {
+        return rest;
+    }
+    struct node * first = linked_list_traverse_to_index(ll, index);
+    struct node * inline_nodes[LINKED_LIST_INLINE_NODES];
+    unsigned int inline_count = inline_find(ll, first, ll->len - index, inline_nodes);
+    if (!inline_evict(ll, inline_nodes, inline_count, &first)) {
+        linked_list_delete(rest);
+        return NULL;
+    }
+    segments_drop(ll);
+    filter_move(rest, ll, first, ll->tail);
+    rest->head = first;
+    rest->tail = ll->tail;
+    rest->len = ll->len - index;
+
+    ll->tail = first->prev;
+    if (ll->tail == NULL) {
+        ll->head = NULL;
+    }
+    else {
+        ll->tail->next = NULL;
+    }
+    first->prev = NULL;
+    ll->len = index;
+    return rest;
+}
+
+/* Merge two sorted chains linked by next only. Ties take from a first,
+   which keeps the sort stable when a holds the earlier nodes. */
+static struct node * merge_sorted_chains(struct node * a, struct node * b) {
+    struct node head;
+    struct node * tail = &head;
+    while (a != NULL && b != NULL) {
+        if (b->data < a->data) {
+            tail->next = b;
+            b = b->next;
+        }
+        else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = (a != NULL) ? a : b;
+    return head.next;
+}
+
+/* Rebuild the prev links and tail of a list whose chain was relinked
+   through next only */
+static void relink_prev(struct linked_list * ll) {
+    struct node * prev = NULL;
+    for (struct node * current = ll->head; current != NULL; current = current->next) {
+        current->prev = prev;
+        prev = current;
+    }
+    ll->tail = prev;
+}
+
+/* Bottom-up merge sort. bins[i] holds a sorted run of 2^i nodes, so nodes
+   are merged like carries in a binary counter. Runs stay small while they
+   are hot in cache, and only one pointer per bit of the length is needed. */
+bool linked_list_sort(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    RCU_UNSUPPORTED_CHECK(ll, false);
+    if (ll->len < 2) {
+        return true;
+    }
+    segments_drop(ll);
+
+    struct node * bins[64] = {0};
+    size_t max_bin = 0;
+    struct node * current = ll->head;
+    while (current != NULL) {
+        struct node * next = current->next;
+        current->next = NULL;
+
+        // Carry the single node run up through the occupied bins
+        struct node * run = current;
+        size_t i = 0;
+        while (bins[i] != NULL) {
+            run = merge_sorted_chains(bins[i], run);
+            bins[i] = NULL;
+            ++i;
+        }
+        bins[i] = run;
+        if (i > max_bin) {
+            max_bin = i;
+        }
+        current = next;
+    }
+
+    // Higher bins hold earlier nodes, so they go on the left of each merge
+    struct node * sorted = NULL;
+    for (size_t i = 0; i <= max_bin; i++) {
+        if (bins[i] != NULL) {
+            sorted = merge_sorted_chains(bins[i], sorted);
+        }
+    }
+    ll->head = sorted;
+    relink_prev(ll);
+    return true;
+}
+
+/* LSD radix sort on 8-bit digits */
+bool linked_list_radix_sort(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    RCU_UNSUPPORTED_CHECK(ll, false);
+    if (ll->len < 2) {
+        return true;
+    }
+    segments_drop(ll);
+
+#define RADIX_BITS     (8)
+#define RADIX_BUCKETS  (1u << RADIX_BITS)
+
+    // Digits where every key agrees leave the order unchanged, skip them
+    unsigned int all_and = ~0u;
+    unsigned int all_or  = 0;
+    for (struct node * current = ll->head; current != NULL; current = current->next) {
+        all_and &= current->data;
+        all_or  |= current->data;
+    }
+    unsigned int varying = all_and ^ all_or;
+
+    struct node * heads[RADIX_BUCKETS];
+    struct node * tails[RADIX_BUCKETS];
+    for (unsigned int shift = 0; shift < sizeof(unsigned int) * 8; shift += RADIX_BITS) {
+        if (((varying >> shift) & (RADIX_BUCKETS - 1)) == 0) {
+            continue;
+        }
+
+        // Scatter nodes onto the tail of their digit's bucket
+        for (unsigned int b = 0; b < RADIX_BUCKETS; b++) {
+            heads[b] = NULL;
+        }
+        for (struct node * current = ll->head; current != NULL; current = current->next) {
+            unsigned int b = (current->data >> shift) & (RADIX_BUCKETS - 1);
+            if (heads[b] == NULL) {
+                heads[b] = current;
+            }
+            else {
+                tails[b]->next = current;
+            }
+            tails[b] = current;
+        }
+
+        // Gather the buckets back into one chain
+        struct node * last = NULL;
+        for (unsigned int b = 0; b < RADIX_BUCKETS; b++) {
+            if (heads[b] == NULL) {
+                continue;
+            }
+            if (last == NULL) {
+                ll->head = heads[b];
+            }
+            else {
+                last->next = heads[b];
+            }
+            last = tails[b];
+        }
+        last->next = NULL;
+    }
+    relink_prev(ll);
+    return true;
+
+#undef RADIX_BITS
+#undef RADIX_BUCKETS
+}
+
+/* Move up to max_nodes nodes, starting at the iterator's node, into a
+   freshly allocated block in list order. Each old node is replaced by its
+   copy in place in the chain and then released. */
+bool linked_list_compact_step(struct iterator * iter, size_t max_nodes) {
+    INVALID_PTR_CHECK(iter, false);
+    RCU_UNSUPPORTED_CHECK(iter->ll, false);
+    if (iter->ll->allocator != NULL) {
+        return false;  // Blocks come from the shared node pool
+    }
+    if (iter->current_node == NULL || max_nodes == 0) {
+        return true;
+    }
+
+    // Size the block to what's actually left, so the final step of an
+    // incremental pass doesn't overshoot
+    struct linked_list * ll = iter->ll;
+    size_t remaining = ll->len - iter->current_index;
+    size_t count = (max_nodes < remaining) ? max_nodes : remaining;
+    if (count > compact_block_nodes) {
+        count = compact_block_nodes;
+    }
+    struct node_block * block = node_block_create(count);
+    INVALID_PTR_CHECK(block, false);
+    segments_drop(ll);
+    node_cache_flush(ll);
+
+    struct node * old = iter->current_node;
+    struct node * pooled = NULL;
+    size_t moved = 0;
+    for (; moved < count && old != NULL; moved++) {
+        struct node * new = &block->nodes[moved];
+        new->flags = ((unsigned int) moved << NODE_POOL_INDEX_SHIFT) | NODE_FLAG_POOLED;
+        new->data = old->data;
+        new->prev = old->prev;
+        new->next = old->next;
+        if (new->prev == NULL) {
+            ll->head = new;
+        }
+        else {
+            new->prev->next = new;
+        }
+        if (new->next == NULL) {
+            ll->tail = new;
+        }
+        else {
+            new->next->prev = new;
+        }
+
+        struct node * next = old->next;
+        if (old->flags & NODE_FLAG_INLINE) {
+            --ll->inline_live;
+        }
+        if (old->flags & NODE_FLAG_POOLED) {
+            old->next = pooled;
+            pooled = old;
+        }
+        else {
+            release_node(ll, old);
+        }
+        old = next;
+    }
+    node_pool_release_chain(pooled);
+
+    // A stale iterator index can overestimate what's left; keep any unused
+    // tail of the block for later inserts
+    pthread_mutex_lock(&node_pool_lock);
+    block->bump = moved;
+    block->live = moved;
+    if (moved != count) {
+        node_block_link(block);
+        atomic_fetch_add_explicit(&node_pool_available, count - moved, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&node_pool_lock);
+
+    // Leave the iterator on the first node that hasn't been moved
+    iter->current_node = old;
+    iter->current_index += moved;
+    if (old != NULL) {
+        iter->data = old->data;
+    }
+    return true;
+}
+
+/* Move every node into one contiguous block in list order */
+bool linked_list_compact(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    RCU_UNSUPPORTED_CHECK(ll, false);
+    struct iterator iter;
+    if (!linked_list_iterator_init(&iter, ll, 0)) {
+        return true;
+    }
+    // A step moves at most one block's worth
+    while (iter.current_node != NULL) {
+        if (!linked_list_compact_step(&iter, ll->len)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Set the most nodes compaction moves into one block */
+bool linked_list_set_compact_block_nodes(size_t nodes) {
+    if (nodes > NODE_BLOCK_MAX_NODES) {
+        return false;
+    }
+    compact_block_nodes = (nodes == 0) ? NODE_BLOCK_MAX_NODES : nodes;
+    return true;
+}
+
+/* Set how many nodes ahead traversals prefetch */
+bool linked_list_set_prefetch_distance(struct linked_list * ll, unsigned int distance) {
+    INVALID_PTR_CHECK(ll, false);
+    ll->prefetch_distance = distance;
+    return true;
+}
+
+/* Initialize a caller-owned iterator at the specified index */
+bool linked_list_iterator_init(struct iterator * iter, struct linked_list * ll, size_t index) {
+    INVALID_PTR_CHECK(iter, false);
+    INVALID_PTR_CHECK(ll, false);
+
+    // Out of range, before the index is narrowed for the traversal
+    if (index >= READ_LEN(ll)) {
+        return false;
+    }
 
     // Traverse to the specified node
     struct node * current = linked_list_traverse_to_index(ll, index);
     if (current == NULL) {
-        return NULL;
+        return false;
     }
-    else {
-        struct iterator * it = (struct iterator *) malloc_fptr(sizeof(struct iterator));
-        it->ll = ll;
-        it->current_index = index;
-        it->current_node = current;
-        it->data = current->data;
-        return it;
+    iter->ll = ll;
+    iter->current_index = index;
+    iter->current_node = current;
+    iter->data = current->data;
+    return true;
+}
+
+/* Create an iterator to conveniently traverse nodes and access their members */
+struct iterator * linked_list_create_iterator(struct linked_list * ll, size_t index) {
+    INVALID_PTR_CHECK(ll, NULL);
+
+    // Traverse to the specified node before allocating anything
+    if (index >= ll->len) {
+        return NULL;
     }
+    struct iterator * it = (struct iterator *) malloc_fptr(sizeof(struct iterator));
+    INVALID_PTR_CHECK(it, NULL);
+    linked_list_iterator_init(it, ll, index);
+    return it;
 }
 
 /* Delete an iterator */
@@ -288,12 +1843,353 @@ bool linked_list_delete_iterator(struct iterator * iter) {
 /* Iterate forward through the list */
 bool linked_list_iterate(struct iterator * iter) {
     INVALID_PTR_CHECK(iter, false);
-    if (iter->current_node->next == NULL) {
+    if (iter->current_node == NULL) {
+        return false;
+    }
+    struct node * next = READ_LINK(iter->current_node->next);
+    if (next == NULL) {
         return false;
     } 
     iter->current_index++;
-    iter->current_node = iter->current_node->next;
-    iter->data = iter->current_node->data;    
+    iter->current_node = next;
+    iter->data = next->data;    
+    return true;
+}
+
+/* Iterate backward through the list */
+bool linked_list_iterate_prev(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NULL) {
+        return false;
+    }
+    struct node * prev = READ_LINK(iter->current_node->prev);
+    if (prev == NULL) {
+        return false;
+    }
+    iter->current_index--;
+    iter->current_node = prev;
+    iter->data = prev->data;
+    return true;
+}
+
+/* Insert a new node in front of the iterator's node. The iterator stays on
+   its node, which is now one index further along. */
+bool linked_list_insert_before(struct iterator * iter, unsigned int data) {
+    INVALID_PTR_CHECK(iter, false);
+    INVALID_PTR_CHECK(iter->current_node, false);
+
+    struct node * new = create_node(iter->ll, data);
+    INVALID_PTR_CHECK(new, false);
+    link_before(iter->ll, iter->current_node, new);
+    segments_on_insert(iter->ll, new, iter->current_index);
+    iter->current_index++;
+    return true;
+}
+
+/* Insert a new node after the iterator's node. The iterator stays put. */
+bool linked_list_insert_after(struct iterator * iter, unsigned int data) {
+    INVALID_PTR_CHECK(iter, false);
+    INVALID_PTR_CHECK(iter->current_node, false);
+
+    struct node * new = create_node(iter->ll, data);
+    INVALID_PTR_CHECK(new, false);
+    link_before(iter->ll, iter->current_node->next, new);
+    segments_on_insert(iter->ll, new, iter->current_index + 1);
+    return true;
+}
+
+/* Remove the iterator's node and move the iterator onto the node that
+   followed it, which takes over the same index */
+bool linked_list_remove_at(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    INVALID_PTR_CHECK(iter->current_node, false);
+
+    struct node * node = iter->current_node;
+    segments_on_remove(iter->ll, node, iter->current_index);
+    iter->current_node = node->next;
+    if (iter->current_node != NULL) {
+        iter->data = iter->current_node->data;
+    }
+    unlink_node(iter->ll, node);
+    retire_node(iter->ll, node);
+    return true;
+}
+
+/* Switch a list into read-mostly mode */
+bool linked_list_rcu_enable(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    if (ll->rcu_writer != NULL) {
+        return true;
+    }
+    struct epoch_domain * domain = (struct epoch_domain *) ll_malloc(ll, sizeof(struct epoch_domain));
+    INVALID_PTR_CHECK(domain, false);
+    epoch_domain_init(domain, rcu_reclaim_node, ll);
+    ll->rcu_writer = epoch_register(domain);
+    return true;
+}
+
+/* Register a reader thread */
+struct epoch_thread * linked_list_rcu_register_reader(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, NULL);
+    INVALID_PTR_CHECK(ll->rcu_writer, NULL);
+    return epoch_register(ll->rcu_writer->domain);
+}
+
+/* Unregister a reader thread */
+bool linked_list_rcu_unregister_reader(struct epoch_thread * reader) {
+    return epoch_unregister(reader);
+}
+
+/* Start a read section */
+void linked_list_rcu_read_lock(struct epoch_thread * reader) {
+    epoch_enter(reader);
+}
+
+/* End a read section */
+void linked_list_rcu_read_unlock(struct epoch_thread * reader) {
+    epoch_exit(reader);
+}
+
+/* Wait for every removed node to be released */
+bool linked_list_rcu_synchronize(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    INVALID_PTR_CHECK(ll->rcu_writer, false);
+    return epoch_barrier(ll->rcu_writer);
+}
+
+/* Parallel scans. A job is split into the segments of the list's segment
+   table; every thread taking part claims the next unscanned segment until
+   none are left. */
+enum parallel_op {
+    PARALLEL_FIND,
+    PARALLEL_COUNT,
+    PARALLEL_SUM,
+};
+
+struct parallel_job {
+    struct linked_list * ll;
+    enum parallel_op op;
+    unsigned int data;
+    size_t segments;                 // Segment table entries + 1
+    _Atomic size_t next_segment;
+    _Atomic size_t found;            // Smallest matching index so far, PARALLEL_FIND
+    _Atomic uint64_t total;          // PARALLEL_COUNT and PARALLEL_SUM
+};
+
+/* Scan nodes [current, end) starting at index */
+static void parallel_scan(struct parallel_job * job, struct node * current, struct node * end, size_t index) {
+    unsigned int distance = job->ll->prefetch_distance;
+    uint64_t total = 0;
+    switch (job->op) {
+    case PARALLEL_FIND:
+        // Stop once past a match some other thread already found
+        for (; current != end && index < atomic_load_explicit(&job->found, memory_order_relaxed); index++) {
+            if (current->data == job->data) {
+                size_t found = atomic_load_explicit(&job->found, memory_order_relaxed);
+                while (index < found &&
+                       !atomic_compare_exchange_weak_explicit(&job->found, &found, index,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+                }
+                return;
+            }
+            prefetch_ahead(current, current->next, distance);
+            current = current->next;
+        }
+        return;
+    case PARALLEL_COUNT:
+        for (; current != end; current = current->next) {
+            total += (current->data == job->data);
+            prefetch_ahead(current, current->next, distance);
+        }
+        break;
+    case PARALLEL_SUM:
+        for (; current != end; current = current->next) {
+            total += current->data;
+            prefetch_ahead(current, current->next, distance);
+        }
+        break;
+    }
+    atomic_fetch_add_explicit(&job->total, total, memory_order_relaxed);
+}
+
+/* Claim and scan segments until none are left */
+static void parallel_job_run(struct parallel_job * job) {
+    struct linked_list * ll = job->ll;
+    struct segment_table * t = ll->segments;
+    for (;;) {
+        size_t k = atomic_fetch_add_explicit(&job->next_segment, 1, memory_order_relaxed);
+        if (k >= job->segments) {
+            return;
+        }
+        size_t index = (k == 0) ? 0 : segment_index(t, k - 1);
+        if (job->op == PARALLEL_FIND && index >= atomic_load_explicit(&job->found, memory_order_relaxed)) {
+            return;  // Segments are claimed in order, so every later one is too far along
+        }
+        struct node * start = (k == 0) ? ll->head : t->entries[k - 1].node;
+        struct node * end = (k + 1 == job->segments) ? NULL : t->entries[k].node;
+        parallel_scan(job, start, end, index);
+    }
+}
+
+/* Worker pool. pool_call_lock lets one parallel scan use the pool at a
+   time; pool_lock guards handing a job to the workers. */
+static pthread_mutex_t pool_call_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake       = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done       = PTHREAD_COND_INITIALIZER;
+static pthread_t pool_threads[LINKED_LIST_MAX_WORKERS];
+static unsigned int pool_thread_count = 0;
+static bool pool_configured           = false;
+static bool pool_stop                 = false;
+static struct parallel_job * pool_job = NULL;
+static unsigned long pool_generation  = 0;
+static unsigned int pool_running      = 0;
+
+/* Pool thread. arg is the generation at the time the thread was created,
+   so a job posted before the thread first runs isn't missed. */
+static void * pool_worker(void * arg) {
+    unsigned long seen = (unsigned long) (uintptr_t) arg;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (!pool_stop && pool_generation == seen) {
+            pthread_cond_wait(&pool_wake, &pool_lock);
+        }
+        if (pool_stop) {
+            break;
+        }
+        seen = pool_generation;
+        struct parallel_job * job = pool_job;
+        pthread_mutex_unlock(&pool_lock);
+        parallel_job_run(job);
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_running == 0) {
+            pthread_cond_signal(&pool_done);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+/* Stop and join every pool thread. Called with pool_call_lock held. */
+static void pool_stop_threads(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_stop = true;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+    for (unsigned int i = 0; i < pool_thread_count; i++) {
+        pthread_join(pool_threads[i], NULL);
+    }
+    pool_thread_count = 0;
+    pool_stop = false;
+}
+
+/* Start workers - 1 pool threads. Called with pool_call_lock held. */
+static void pool_start_threads(unsigned int workers) {
+    if (workers > LINKED_LIST_MAX_WORKERS) {
+        workers = LINKED_LIST_MAX_WORKERS;
+    }
+    while (pool_thread_count + 1 < workers &&
+           pthread_create(&pool_threads[pool_thread_count], NULL, pool_worker,
+                          (void *) (uintptr_t) pool_generation) == 0) {
+        ++pool_thread_count;
+    }
+}
+
+/* Run a job on the pool and the calling thread */
+static void parallel_job_execute(struct parallel_job * job) {
+    pthread_mutex_lock(&pool_call_lock);
+    if (!pool_configured) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        pool_start_threads((cpus < 1) ? 1 : (unsigned int) cpus);
+        pool_configured = true;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    pool_job = job;
+    pool_running = pool_thread_count;
+    ++pool_generation;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+
+    parallel_job_run(job);
+
+    pthread_mutex_lock(&pool_lock);
+    while (pool_running != 0) {
+        pthread_cond_wait(&pool_done, &pool_lock);
+    }
+    pool_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&pool_call_lock);
+}
+
+/* Scan a list, in parallel once it is large enough */
+static void parallel_job_start(struct parallel_job * job) {
+    struct linked_list * ll = job->ll;
+    atomic_init(&job->next_segment, 0);
+    atomic_init(&job->found, SIZE_MAX);
+    atomic_init(&job->total, 0);
+
+    if (ll->len < LINKED_LIST_PARALLEL_MIN_NODES) {
+        parallel_scan(job, ll->head, NULL, 0);
+        return;
+    }
+
+    // Rebuild the table if it was dropped, or if inserts in the middle of
+    // the list have left its segments far larger than intended
+    if (ll->segments != NULL &&
+            (ll->segments->count + 1) * 4 * (size_t) LINKED_LIST_SEGMENT_NODES < ll->len) {
+        segments_drop(ll);
+    }
+    if (ll->segments == NULL && !segments_build(ll)) {
+        parallel_scan(job, ll->head, NULL, 0);
+        return;
+    }
+    job->segments = ll->segments->count + 1;
+    parallel_job_execute(job);
+}
+
+/* Find the first occurrence of a value, scanning segments in parallel */
+size_t linked_list_parallel_find(struct linked_list * ll, unsigned int data) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter != NULL && !counting_bloom_maybe_contains(ll->filter, data)) {
+        return SIZE_MAX;
+    }
+    struct parallel_job job = {.ll = ll, .op = PARALLEL_FIND, .data = data};
+    parallel_job_start(&job);
+    return atomic_load(&job.found);
+}
+
+/* Count the occurrences of a value, scanning segments in parallel */
+size_t linked_list_parallel_count(struct linked_list * ll, unsigned int data) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter != NULL && !counting_bloom_maybe_contains(ll->filter, data)) {
+        return 0;
+    }
+    struct parallel_job job = {.ll = ll, .op = PARALLEL_COUNT, .data = data};
+    parallel_job_start(&job);
+    return (size_t) atomic_load(&job.total);
+}
+
+/* Sum every value, scanning segments in parallel */
+bool linked_list_parallel_sum(struct linked_list * ll, uint64_t * sum) {
+    INVALID_PTR_CHECK(ll, false);
+    INVALID_PTR_CHECK(sum, false);
+    struct parallel_job job = {.ll = ll, .op = PARALLEL_SUM};
+    parallel_job_start(&job);
+    *sum = atomic_load(&job.total);
+    return true;
+}
+
+/* Resize the worker pool */
+bool linked_list_set_parallel_workers(unsigned int workers) {
+    if (workers > LINKED_LIST_MAX_WORKERS) {
+        return false;
+    }
+    pthread_mutex_lock(&pool_call_lock);
+    pool_stop_threads();
+    pool_start_threads(workers);
+    pool_configured = true;
+    pthread_mutex_unlock(&pool_call_lock);
     return true;
 }
 
@@ -31,6 +31,7 @@ SOFTWARE.
 
 // Some rules for Pointer Wars 2025:
 // 0. Implement all functions in linked_list.c
+//    (or linked_list_index.c when built with LINKED_LIST_INDEX_LAYOUT).
 // 1. Feel free to add members to the structures, but please do not remove 
 //    any or rename any. Doing so will cause test infrastructure to fail
 //    to link against your shared library.
@@ -48,34 +49,134 @@ do { \
     } \
 } while (0) 
 
+struct counting_bloom;
+
+// Allocator for a single linked_list or queue instance, see
+// linked_list_create_with_allocator(). ctx is passed back on every call,
+// so one set of functions can serve many arenas, pools or heaps.
+//
+struct ll_allocator {
+    void * (*malloc)(void * ctx, size_t size);
+    void   (*free)(void * ctx, void * addr);
+};
+
+// Nodes stored inline in struct linked_list. A list that never holds more
+// than this many values at once makes no allocation beyond its own struct.
+//
+#define LINKED_LIST_INLINE_NODES   (8)
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+
+// A node in the linked_list structure.
+// Feel free to change as desired.
+// The flags word sits in what would otherwise be padding, so it does
+// not grow the node.
+//
+struct node {
+    struct node * next;
+    struct node * prev;
+    unsigned int data;
+    unsigned int flags;
+};
+
+// Node flags.
+// NODE_FLAG_POOLED : Node was carved out of a bulk-allocated block and is
+//                    returned to the node pool rather than to free_fptr().
+// NODE_FLAG_MARKER : Node starts a segment of the list's segment table.
+// NODE_FLAG_INLINE : Node is one of its list's inline_nodes.
+//
+#define NODE_FLAG_POOLED   (1u << 0)
+#define NODE_FLAG_MARKER   (1u << 1)
+#define NODE_FLAG_INLINE   (1u << 2)
+
+// A pooled node keeps its index in its block in the flags bits from
+// NODE_POOL_INDEX_SHIFT up.
+//
+#define NODE_POOL_INDEX_SHIFT   (8)
+
 // Declaration of the linked_list data structure.
 // Feel free to change as desired.
 //
-struct node;
+struct epoch_thread;
+struct segment_table;
 struct linked_list {
     struct node * head;
     struct node * tail;
     unsigned int len;
+    unsigned int prefetch_distance;  // See linked_list_set_prefetch_distance()
+    struct epoch_thread * rcu_writer;  // See linked_list_rcu_enable(), NULL if not enabled
+    struct segment_table * segments;   // See linked_list_parallel_find(), NULL until first needed
+    const struct ll_allocator * allocator;  // NULL for the registered malloc/free functions
+    void * allocator_ctx;
+    struct node * spare;               // Nodes kept by linked_list_clear(), linked by next
+    size_t spare_count;
+    struct node * node_cache;          // Pooled nodes kept for this list's inserts, linked by next
+    unsigned int node_cache_count;
+    struct counting_bloom * filter;    // See linked_list_filter_enable(), NULL if not enabled
+    unsigned int inline_free;          // Bit i set while inline_nodes[i] is unused
+    unsigned int inline_spare;         // Bit i set while inline_nodes[i] is on the spare chain
+    unsigned int inline_live;          // Inline nodes linked into the list
+    struct node inline_nodes[LINKED_LIST_INLINE_NODES];  // Taken before any other allocation
 };
 
-// A node in the linked_list structure.
-// Feel free to change as desired.
+// Value of a node link (head, tail, next, prev, current_node) that refers
+// to no node.
+//
+#define LINKED_LIST_NO_NODE   NULL
+
+// Very simple, not thread safe, iterator.
+// May live on the stack, see linked_list_iterator_init(). An iterator whose
+// current_node is LINKED_LIST_NO_NODE has run off the end of the list.
+//
+struct iterator {
+    struct linked_list * ll;
+    struct node * current_node;
+    size_t current_index;
+    unsigned int data;
+};
+
+#else
+
+// Compact layout, see linked_list_index.c. Nodes live in a growable
+// per-list arena and link to each other with 32-bit arena indices,
+// so a node is 12 bytes rather than 24 on 64-bit targets.
 //
+#define LINKED_LIST_NO_NODE   UINT32_MAX
+
 struct node {
-    struct node * next;
-    struct node * prev;
+    uint32_t next;
+    uint32_t prev;
     unsigned int data;
 };
 
+struct linked_list {
+    struct node * nodes;     // Arena, grown by doubling
+    uint32_t capacity;       // Slots in the arena
+    uint32_t used;           // Slots handed out at least once
+    uint32_t free_head;      // Chain of released slots, linked by next
+    uint32_t free_count;
+    uint32_t head;
+    uint32_t tail;
+    unsigned int len;
+    const struct ll_allocator * allocator;  // NULL for the registered malloc/free functions
+    void * allocator_ctx;
+    struct counting_bloom * filter;  // See linked_list_filter_enable(), NULL if not enabled
+    struct node inline_nodes[LINKED_LIST_INLINE_NODES];  // The arena until it first grows
+};
+
 // Very simple, not thread safe, iterator.
+// current_node is an arena index, so the iterator stays valid when the
+// arena grows.
 //
 struct iterator {
     struct linked_list * ll;
-    struct node * current_node;
+    uint32_t current_node;
     size_t current_index;
     unsigned int data;
 };
 
+#endif
+
 // Creates a new linked_list.
 // PRECONDITION: Register malloc() and free() functions via the
 //               linked_list_register_malloc() and 
@@ -85,6 +186,19 @@ struct iterator {
 //
 struct linked_list * linked_list_create(void);
 
+// Creates a new linked_list that allocates from its own allocator instead
+// of the registered malloc() and free() functions. The list structure and
+// everything the list allocates later come from ops, except heap
+// iterators, which may outlive the list and so stay on the registered
+// functions.
+// \param ops : Allocator, must outlive the list. NULL for the registered
+//              functions, like linked_list_create().
+// \param ctx : Passed to every ops call.
+// Returns a new linked_list on success, NULL on failure.
+//
+struct linked_list * linked_list_create_with_allocator(const struct ll_allocator * ops,
+                                                       void * ctx);
+
 // Deletes a linked_list.
 // \param ll : Pointer to linked_list to delete
 // POSTCONDITION : An empty linked_list has its head point to NULL.
@@ -92,6 +206,17 @@ struct linked_list * linked_list_create(void);
 //
 bool linked_list_delete(struct linked_list * ll);
 
+// Empties a linked_list without deleting it.
+// \param ll           : Pointer to linked_list to empty.
+// \param retain_nodes : TRUE to keep the nodes for later inserts, which
+//                       then take them before allocating. The whole chain
+//                       is kept in O(1). FALSE to release every node,
+//                       including any kept by an earlier call.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_clear(struct linked_list * ll,
+                       bool retain_nodes);
+
 // Returns the size of a linked_list.
 // \param ll : Pointer to linked_list.
 // Returns size on success, SIZE_MAX on failure.
@@ -132,6 +257,40 @@ bool linked_list_insert(struct linked_list * ll,
 size_t linked_list_find(struct linked_list * ll,
                         unsigned int data);
 
+// Enables a membership filter on a linked_list, a counting Bloom filter
+// (counting_bloom.h) kept up to date by every insert and remove, so that
+// linked_list_find() of a value that is not in the list returns without
+// walking it. Enabling it again resizes it. The filter is built from the
+// current contents and allocated like the list's nodes.
+// \param ll                  : Pointer to linked_list.
+// \param expected_elements   : Length the filter is sized for. Past it the
+//                              false positive rate rises, but answers stay
+//                              correct.
+// \param false_positive_rate : Fraction of misses that still walk the
+//                              list, between 0 and 1 exclusive. Memory per
+//                              expected element is about 5.5 bytes at 1%
+//                              and 9.5 bytes at 0.1%, see
+//                              linked_list_filter_bytes().
+// Returns TRUE on success, FALSE otherwise (the list keeps any filter it
+// had). Fails on a read-mostly list: enable the filter before
+// linked_list_rcu_enable().
+//
+bool linked_list_filter_enable(struct linked_list * ll,
+                               size_t expected_elements,
+                               double false_positive_rate);
+
+// Removes a linked_list's membership filter, if it has one.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise (including a read-mostly list).
+//
+bool linked_list_filter_disable(struct linked_list * ll);
+
+// Gets the memory used by a linked_list's membership filter.
+// \param ll : Pointer to linked_list.
+// Returns the size in bytes, 0 if it has no filter, SIZE_MAX on failure.
+//
+size_t linked_list_filter_bytes(struct linked_list * ll);
+
 // Removes a node from the linked_list at a specific index.
 // \param ll    : Pointer to linked_list.
 // \param index : Index to remove node.
@@ -140,6 +299,61 @@ size_t linked_list_find(struct linked_list * ll,
 bool linked_list_remove(struct linked_list * ll,
                         size_t index);
 
+// Inserts n elements at the end of the linked_list, in array order.
+// Nodes are allocated as a single block and linked in one pass.
+// \param ll   : Pointer to linked_list.
+// \param vals : Array of data to insert.
+// \param n    : Number of elements in vals.
+// Returns TRUE on success, FALSE otherwise. On failure the list is unchanged.
+//
+bool linked_list_insert_end_bulk(struct linked_list * ll,
+                                 const unsigned int * vals,
+                                 size_t n);
+
+// Inserts n elements at the front of the linked_list, in array order,
+// such that vals[0] becomes the new head.
+// Nodes are allocated as a single block and linked in one pass.
+// \param ll   : Pointer to linked_list.
+// \param vals : Array of data to insert.
+// \param n    : Number of elements in vals.
+// Returns TRUE on success, FALSE otherwise. On failure the list is unchanged.
+//
+bool linked_list_insert_front_bulk(struct linked_list * ll,
+                                   const unsigned int * vals,
+                                   size_t n);
+
+// Removes count nodes starting at index start.
+// \param ll    : Pointer to linked_list.
+// \param start : Index of the first node to remove.
+// \param count : Number of nodes to remove.
+// Returns TRUE on success, FALSE otherwise (including a range that runs
+// past the end of the list, in which case nothing is removed).
+//
+bool linked_list_remove_range(struct linked_list * ll,
+                              size_t start,
+                              size_t count);
+
+// Removes every node whose data matches a predicate, in a single pass.
+// \param ll   : Pointer to linked_list.
+// \param pred : Called once per node, in list order, with the node's data
+//               and ctx. Must not modify the list.
+// \param ctx  : Passed through to pred.
+// Returns the number of nodes removed on success, SIZE_MAX otherwise.
+//
+size_t linked_list_remove_if(struct linked_list * ll,
+                             bool (*pred)(unsigned int data, void * ctx),
+                             void * ctx);
+
+// Keeps only the nodes whose data matches a predicate, in a single pass.
+// \param ll   : Pointer to linked_list.
+// \param pred : As for linked_list_remove_if().
+// \param ctx  : Passed through to pred.
+// Returns the number of nodes removed on success, SIZE_MAX otherwise.
+//
+size_t linked_list_retain_if(struct linked_list * ll,
+                             bool (*pred)(unsigned int data, void * ctx),
+                             void * ctx);
+
 // Creates an iterator struct at a particular index.
 // \param linked_list : Pointer to linked_list.
 // \param index       : Index of the linked list to start at.
@@ -148,6 +362,17 @@ bool linked_list_remove(struct linked_list * ll,
 struct iterator * linked_list_create_iterator(struct linked_list * ll,
                                               size_t index);
 
+// Initializes a caller-owned iterator at a particular index. Nothing is
+// allocated, so the iterator may live on the stack.
+// \param iter  : Iterator to initialize.
+// \param ll    : Pointer to linked_list.
+// \param index : Index of the linked list to start at.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_iterator_init(struct iterator * iter,
+                               struct linked_list * ll,
+                               size_t index);
+
 // Deletes an iterator struct.
 // \param iterator : Iterator to delete.
 // Returns TRUE on success, FALSE otherwise.
@@ -160,6 +385,38 @@ bool linked_list_delete_iterator(struct iterator * iter);
 //
 bool linked_list_iterate(struct iterator * iter);
 
+// Iterates to the previous node in the linked_list.
+// \param iterator: Iterator to iterate on.
+// Returns TRUE when previous node is present, FALSE at the head of the list.
+//
+bool linked_list_iterate_prev(struct iterator * iter);
+
+// Inserts an element in front of the iterator's node in O(1).
+// The iterator stays on its node, whose index grows by one.
+// \param iter : Iterator marking the insertion point.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_before(struct iterator * iter,
+                               unsigned int data);
+
+// Inserts an element after the iterator's node in O(1).
+// The iterator stays on its node.
+// \param iter : Iterator marking the insertion point.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_after(struct iterator * iter,
+                              unsigned int data);
+
+// Removes the iterator's node in O(1). The iterator moves onto the node
+// that followed it, at the same index. Removing the tail leaves the
+// iterator with a current_node of LINKED_LIST_NO_NODE.
+// \param iter : Iterator on the node to remove.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_at(struct iterator * iter);
+
 // Registers malloc() function.
 // \param malloc : Function pointer to malloc()-like function.
 // Returns TRUE on success, FALSE otherwise.
@@ -172,4 +429,229 @@ bool linked_list_register_malloc(void * (*malloc)(size_t));
 //
 bool linked_list_register_free(void (*free)(void*));
 
+// The functions below are only provided by the pointer layout in
+// linked_list.c; the index layout keeps to the core set above.
+//
+#ifndef LINKED_LIST_INDEX_LAYOUT
+
+// Appends every node of src to the end of dst in O(1). Nodes are relinked,
+// not copied, except for src's inline nodes (at most
+// LINKED_LIST_INLINE_NODES), which are copied into allocated nodes first.
+// If either list has a membership filter, each value also moves between
+// the filters. src is left empty but is not deleted. Both lists must use
+// the same allocator.
+// \param dst : Pointer to linked_list to append to.
+// \param src : Pointer to linked_list to take nodes from, must not be dst.
+// Returns TRUE on success, FALSE otherwise. On failure neither list
+// changes.
+//
+bool linked_list_concat(struct linked_list * dst,
+                        struct linked_list * src);
+
+// Moves count nodes starting at index start of src in front of index
+// index of dst. Nodes are relinked, not copied; the cost is the traversal
+// to the two positions, plus a walk over the moved nodes while src still
+// has inline nodes that could be among them, which are copied into
+// allocated nodes.
+// \param dst   : Pointer to linked_list to move nodes into.
+// \param index : Index of dst to insert at, may equal the size of dst.
+// \param src   : Pointer to linked_list to move nodes out of, must not be dst.
+// \param start : Index of the first node of src to move.
+// \param count : Number of nodes to move.
+// Returns TRUE on success, FALSE otherwise, including when the lists use
+// different allocators. On failure neither list changes.
+//
+bool linked_list_splice(struct linked_list * dst,
+                        size_t index,
+                        struct linked_list * src,
+                        size_t start,
+                        size_t count);
+
+// Splits a linked_list in two. The nodes from index onwards are relinked
+// into a new linked_list.
+// \param ll    : Pointer to linked_list to split.
+// \param index : Index of the first node of the new list, may equal the
+//                size of ll.
+// Returns the new linked_list on success, NULL otherwise, in which case
+// ll is unchanged.
+//
+struct linked_list * linked_list_split(struct linked_list * ll,
+                                       size_t index);
+
+// Sorts a linked_list in ascending order with a bottom-up merge sort.
+// Nodes are relinked in place; the sort is stable, O(n log n) and
+// allocates nothing.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_sort(struct linked_list * ll);
+
+// Sorts a linked_list in ascending order with an LSD radix sort on 8-bit
+// digits, scattering nodes into 256 buckets per pass. Digits that are the
+// same in every key are skipped. Stable, O(n) per pass and allocates nothing.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_radix_sort(struct linked_list * ll);
+
+// Moves every node of a linked_list into freshly allocated, contiguous
+// blocks in list order, so that traversal walks memory sequentially again
+// after insert/remove churn has scattered the nodes. A block holds up to
+// 2^24 nodes, so a longer list gets one block per 2^24 nodes (fewer per
+// block after linked_list_set_compact_block_nodes()). The blocks come from
+// the shared node pool, so lists with their own allocator are not
+// compacted. The old nodes are released as they are moved, along with the
+// pooled nodes the list keeps for its own inserts, and any pool block left
+// with none in use is freed, so compaction doesn't keep the old memory
+// around.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise. On failure the contents of
+// the list are unchanged, though the nodes of its first blocks may
+// already have been moved.
+//
+bool linked_list_compact(struct linked_list * ll);
+
+// Incremental form of linked_list_compact(). Moves up to max_nodes nodes,
+// starting at the iterator's node, into a fresh contiguous block and
+// advances the iterator to the first node not yet moved. The pass is done
+// once the iterator's current_node is LINKED_LIST_NO_NODE. The list may be
+// modified between steps, under the usual rule that the iterator's own
+// node must not be removed.
+// \param iter      : Iterator marking where to continue compacting.
+// \param max_nodes : Maximum number of nodes to move in this call.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_compact_step(struct iterator * iter,
+                              size_t max_nodes);
+
+// Sets the most nodes compaction moves into one block, which bounds the
+// size of each allocation it makes. Applies to every list.
+// \param nodes : Nodes per block, at most 2^24. 0 for the default, 2^24.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_compact_block_nodes(size_t nodes);
+
+// Sets how far ahead linked_list_find(), linked_list_delete() and indexed
+// traversals issue software prefetches. Whenever a hop lands on the node
+// adjacent in memory, the node distance positions further along in memory
+// is prefetched. Hops that jump elsewhere issue nothing, and no jump
+// pointers are kept, so this only helps lists whose nodes still sit in
+// list order: recently bulk-built or compacted ones. Call
+// linked_list_compact() on a list scattered by inserts and removes first.
+// 0, the default, disables prefetching.
+// \param ll       : Pointer to linked_list.
+// \param distance : Prefetch distance in nodes.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_prefetch_distance(struct linked_list * ll,
+                                       unsigned int distance);
+
+// Read-mostly mode, for lists that many threads read while a single
+// writer occasionally updates them.
+//
+// Readers register with the list once, then wrap each traversal in
+// linked_list_rcu_read_lock() / linked_list_rcu_read_unlock(). Inside a
+// read section they may call linked_list_size(), linked_list_find(),
+// linked_list_iterator_init() at index 0 and linked_list_iterate() on a
+// stack iterator. None of these take locks; following a link is an
+// acquire load, which costs nothing extra on x86.
+//
+// The writer uses the ordinary insert and remove functions, one update at
+// a time, and never from inside its own read section. New nodes are
+// published with release stores once fully linked, and removed nodes keep
+// their links and are only released once every reader that might be on
+// them has left its read section (see epoch.h). Operations that relink
+// many nodes at once (concat, splice, split, sorting and compaction)
+// return FALSE on a list in read-mostly mode.
+
+// Switches a linked_list into read-mostly mode. There is no way back.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_rcu_enable(struct linked_list * ll);
+
+// Registers a reader thread with a read-mostly list.
+// \param ll : Pointer to linked_list in read-mostly mode.
+// Returns the reader's handle on success, NULL otherwise.
+//
+struct epoch_thread * linked_list_rcu_register_reader(struct linked_list * ll);
+
+// Unregisters a reader thread.
+// \param reader : Handle from linked_list_rcu_register_reader().
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_rcu_unregister_reader(struct epoch_thread * reader);
+
+// Starts a read section. Nodes reached inside it stay valid until
+// the matching linked_list_rcu_read_unlock().
+// \param reader : Handle from linked_list_rcu_register_reader().
+//
+void linked_list_rcu_read_lock(struct epoch_thread * reader);
+
+// Ends a read section.
+// \param reader : Handle from linked_list_rcu_register_reader().
+//
+void linked_list_rcu_read_unlock(struct epoch_thread * reader);
+
+// Waits until every node the writer has removed so far has been released.
+// Called by the writer.
+// \param ll : Pointer to linked_list in read-mostly mode.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_rcu_synchronize(struct linked_list * ll);
+
+// Parallel scans, for lists of hundreds of millions of nodes.
+//
+// Once a list reaching LINKED_LIST_PARALLEL_MIN_NODES is first scanned in
+// parallel, it gets a segment table: a marker on roughly every
+// LINKED_LIST_SEGMENT_NODES-th node, with that node's index. Inserts and
+// removes keep the table up to date; appends add markers as the list
+// grows. Concat, splice, split, sorting and compaction drop the table and
+// the next parallel scan rebuilds it. Segments are scanned by a process
+// wide worker pool, started on first use. Smaller lists are scanned on
+// the calling thread.
+//
+// The parallel scans don't change the list, but they do update its segment
+// table, so they follow the same threading rules as inserts and removes.
+//
+#define LINKED_LIST_SEGMENT_NODES        (64u * 1024u)
+#define LINKED_LIST_PARALLEL_MIN_NODES   (16u * LINKED_LIST_SEGMENT_NODES)
+
+// Finds the first occurrence of data, like linked_list_find().
+// \param ll   : Pointer to linked_list.
+// \param data : Data to search for.
+// Returns the smallest index holding data, SIZE_MAX if it is not present
+// or on failure.
+//
+size_t linked_list_parallel_find(struct linked_list * ll,
+                                 unsigned int data);
+
+// Counts the occurrences of data.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to count.
+// Returns the number of nodes holding data, SIZE_MAX on failure.
+//
+size_t linked_list_parallel_count(struct linked_list * ll,
+                                  unsigned int data);
+
+// Sums every value in a linked_list.
+// \param ll  : Pointer to linked_list.
+// \param sum : Pointer to the sum (provided by caller).
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_parallel_sum(struct linked_list * ll,
+                              uint64_t * sum);
+
+// Sets the number of threads that take part in a parallel scan, the
+// calling thread included. Until this is called, the pool sizes itself to
+// the number of online CPUs. 0 or 1 stops the pool threads, and later scans
+// run on the calling thread alone.
+// \param workers : Number of threads, at most LINKED_LIST_MAX_WORKERS.
+// Returns TRUE on success, FALSE otherwise.
+//
+#define LINKED_LIST_MAX_WORKERS   (64u)
+bool linked_list_set_parallel_workers(unsigned int workers);
+
+#endif
+
 #endif
@@ -0,0 +1,652 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Compact linked_list layout. Built in place of linked_list.c when
+   LINKED_LIST_INDEX_LAYOUT is defined (see LINKED_LIST_LAYOUT in the Makefile).
+
+   Every list owns an arena of 12-byte nodes that link to each other by
+   32-bit index instead of by pointer, so five nodes fit in a 64 byte cache
+   line rather than two and a half. The arena grows by doubling, copying
+   the nodes across; since links are indices nothing needs rewriting.
+   Released slots are chained through next and reused before the arena
+   grows again. The arena starts out as the list's inline_nodes, so a list
+   that never outgrows them makes no allocation beyond its struct. */
+
+#include "counting_bloom.h"
+#include "linked_list.h"
+#include "stdlib.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+#define NIL                  LINKED_LIST_NO_NODE
+#define NODE(_ll, _idx)      (&(_ll)->nodes[_idx])
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+/* Per-list allocation, see linked_list_create_with_allocator() */
+static inline void * ll_malloc(struct linked_list * ll, size_t size) {
+    if (ll->allocator != NULL) {
+        return ll->allocator->malloc(ll->allocator_ctx, size);
+    }
+    return malloc_fptr(size);
+}
+
+static inline void ll_free(struct linked_list * ll, void * addr) {
+    if (ll->allocator != NULL) {
+        ll->allocator->free(ll->allocator_ctx, addr);
+    }
+    else {
+        free_fptr(addr);
+    }
+}
+
+/* Make sure at least n slots can be handed out without growing */
+static bool arena_reserve(struct linked_list * ll, size_t n) {
+    size_t avail = (size_t) ll->free_count + (ll->capacity - ll->used);
+    if (avail >= n) {
+        return true;
+    }
+
+    // Double until the request fits, staying clear of the NIL index
+    size_t needed = (size_t) ll->used + (n - avail);
+    size_t capacity = ll->capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    if (capacity >= NIL) {
+        capacity = NIL - 1;
+        if (capacity < needed) {
+            return false;
+        }
+    }
+
+    struct node * nodes = (struct node *) ll_malloc(ll, capacity * sizeof(struct node));
+    INVALID_PTR_CHECK(nodes, false);
+    memcpy(nodes, ll->nodes, ll->used * sizeof(struct node));
+    if (ll->nodes != ll->inline_nodes) {
+        ll_free(ll, ll->nodes);
+    }
+    ll->nodes = nodes;
+    ll->capacity = (uint32_t) capacity;
+    return true;
+}
+
+/* Take a slot. The caller must have reserved it first. */
+static inline uint32_t arena_take(struct linked_list * ll, unsigned int data) {
+    uint32_t idx;
+    if (ll->free_head != NIL) {
+        idx = ll->free_head;
+        ll->free_head = NODE(ll, idx)->next;
+        --ll->free_count;
+    }
+    else {
+        idx = ll->used++;
+    }
+    NODE(ll, idx)->data = data;
+    if (ll->filter != NULL) {
+        counting_bloom_add(ll->filter, data);
+    }
+    return idx;
+}
+
+/* Return a slot to the arena */
+static inline void arena_release(struct linked_list * ll, uint32_t idx) {
+    if (ll->filter != NULL) {
+        counting_bloom_remove(ll->filter, NODE(ll, idx)->data);
+    }
+    NODE(ll, idx)->next = ll->free_head;
+    ll->free_head = idx;
+    ++ll->free_count;
+}
+
+/* Create a new node, or NIL if the arena can't grow */
+static inline uint32_t create_node(struct linked_list * ll, unsigned int data) {
+    if (!arena_reserve(ll, 1)) {
+        return NIL;
+    }
+    return arena_take(ll, data);
+}
+
+/* Link a new node in front of pos, or at the tail if pos is NIL */
+static inline void link_before(struct linked_list * ll, uint32_t pos, uint32_t new) {
+    struct node * n = NODE(ll, new);
+    n->next = pos;
+    n->prev = (pos == NIL) ? ll->tail : NODE(ll, pos)->prev;
+    if (n->prev == NIL) {
+        ll->head = new;
+    }
+    else {
+        NODE(ll, n->prev)->next = new;
+    }
+    if (pos == NIL) {
+        ll->tail = new;
+    }
+    else {
+        NODE(ll, pos)->prev = new;
+    }
+    ++ll->len;
+}
+
+/* Unlink a node from the list without releasing it */
+static inline void unlink_node(struct linked_list * ll, uint32_t idx) {
+    struct node * n = NODE(ll, idx);
+    if (n->prev == NIL) {
+        ll->head = n->next;
+    }
+    else {
+        NODE(ll, n->prev)->next = n->next;
+    }
+    if (n->next == NIL) {
+        ll->tail = n->prev;
+    }
+    else {
+        NODE(ll, n->next)->prev = n->prev;
+    }
+    --ll->len;
+}
+
+/* Determine if it's quicker to reach the desired index from the head or the tail and
+   return the node at the provided index */
+static inline uint32_t linked_list_traverse_to_index(struct linked_list * ll, size_t index) {
+    if (index >= ll->len) {
+        return NIL;
+    }
+
+    uint32_t current;
+    if (index >= ll->len/2) {
+        current = ll->tail;
+        for (size_t i = ll->len-1; i > index; i--) {
+            current = NODE(ll, current)->prev;
+        }
+    }
+    else {
+        current = ll->head;
+        for (size_t i = 0; i < index; i++) {
+            current = NODE(ll, current)->next;
+        }
+    }
+    return current;
+}
+
+/* Create a new linked list. The arena is allocated once it outgrows the
+   inline nodes. */
+struct linked_list * linked_list_create(void) {
+    return linked_list_create_with_allocator(NULL, NULL);
+}
+
+/* Create a new linked list whose struct and arena come from its own allocator */
+struct linked_list * linked_list_create_with_allocator(const struct ll_allocator * ops, void * ctx) {
+    struct linked_list * ll = (struct linked_list *) ((ops != NULL) ? ops->malloc(ctx, sizeof(struct linked_list))
+                                                                    : malloc_fptr(sizeof(struct linked_list)));
+    if (ll != NULL) {
+        ll->allocator = ops;
+        ll->allocator_ctx = ctx;
+        ll->nodes = ll->inline_nodes;
+        ll->capacity = LINKED_LIST_INLINE_NODES;
+        ll->used = 0;
+        ll->free_head = NIL;
+        ll->free_count = 0;
+        ll->head = NIL;
+        ll->tail = NIL;
+        ll->len = 0;
+        ll->filter = NULL;
+    }
+    return ll;
+}
+
+/* Delete an entire linked list. The arena goes in one free call. */
+bool linked_list_delete(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    if (ll->nodes != ll->inline_nodes) {
+        ll_free(ll, ll->nodes);
+    }
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+    }
+    ll->head = NIL;
+    ll_free(ll, ll);
+    return true;
+}
+
+/* Empty the list. Retained nodes go onto the arena's free list in one
+   splice; otherwise the arena itself is released, back to the inline
+   nodes. */
+bool linked_list_clear(struct linked_list * ll, bool retain_nodes) {
+    INVALID_PTR_CHECK(ll, false);
+    if (!retain_nodes) {
+        if (ll->nodes != ll->inline_nodes) {
+            ll_free(ll, ll->nodes);
+        }
+        ll->nodes = ll->inline_nodes;
+        ll->capacity = LINKED_LIST_INLINE_NODES;
+        ll->used = 0;
+        ll->free_head = NIL;
+        ll->free_count = 0;
+    }
+    else if (ll->head != NIL) {
+        NODE(ll, ll->tail)->next = ll->free_head;
+        ll->free_head = ll->head;
+        ll->free_count += ll->len;
+    }
+    if (ll->filter != NULL) {
+        counting_bloom_reset(ll->filter);
+    }
+    ll->head = NIL;
+    ll->tail = NIL;
+    ll->len = 0;
+    return true;
+}
+
+/* Return the size of the linked list */
+size_t linked_list_size(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    return ll->len;
+}
+
+/* Insert a new node at the tail of the list */
+bool linked_list_insert_end(struct linked_list * ll, unsigned int data) {
+    INVALID_PTR_CHECK(ll, false);
+    uint32_t new = create_node(ll, data);
+    if (new == NIL) {
+        return false;
+    }
+    link_before(ll, NIL, new);
+    return true;
+}
+
+/* Insert a new node at the head of the list */
+bool linked_list_insert_front(struct linked_list * ll, unsigned int data) {
+    INVALID_PTR_CHECK(ll, false);
+    uint32_t new = create_node(ll, data);
+    if (new == NIL) {
+        return false;
+    }
+    link_before(ll, ll->head, new);
+    return true;
+}
+
+/* Insert a new node at the specified index */
+bool linked_list_insert(struct linked_list * ll, size_t index, unsigned int data) {
+    INVALID_PTR_CHECK(ll, false);
+    if (index > ll->len) {
+        return false;
+    }
+
+    // Reserve before traversing; growing the arena doesn't move indices
+    uint32_t new = create_node(ll, data);
+    if (new == NIL) {
+        return false;
+    }
+    link_before(ll, linked_list_traverse_to_index(ll, index), new);
+    return true;
+}
+
+/* Find the first occurrence of a value in the list */
+size_t linked_list_find(struct linked_list * ll, unsigned int data) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter != NULL && !counting_bloom_maybe_contains(ll->filter, data)) {
+        return SIZE_MAX;
+    }
+
+    size_t index = 0;
+    uint32_t current = ll->head;
+    while (current != NIL) {
+        struct node * n = NODE(ll, current);
+        if (n->data == data) {
+            return index;
+        }
+        ++index;
+        current = n->next;
+    }
+    return SIZE_MAX;
+}
+
+/* Enable or resize the membership filter, filling it from the list */
+bool linked_list_filter_enable(struct linked_list * ll, size_t expected_elements, double false_positive_rate) {
+    INVALID_PTR_CHECK(ll, false);
+    size_t bytes = counting_bloom_size(expected_elements, false_positive_rate);
+    if (bytes == 0) {
+        return false;
+    }
+    struct counting_bloom * filter = (struct counting_bloom *) ll_malloc(ll, bytes);
+    INVALID_PTR_CHECK(filter, false);
+    counting_bloom_init(filter, expected_elements, false_positive_rate);
+    for (uint32_t current = ll->head; current != NIL; current = NODE(ll, current)->next) {
+        counting_bloom_add(filter, NODE(ll, current)->data);
+    }
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+    }
+    ll->filter = filter;
+    return true;
+}
+
+/* Remove the membership filter */
+bool linked_list_filter_disable(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, false);
+    if (ll->filter != NULL) {
+        ll_free(ll, ll->filter);
+        ll->filter = NULL;
+    }
+    return true;
+}
+
+/* Get the memory used by the membership filter */
+size_t linked_list_filter_bytes(struct linked_list * ll) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    if (ll->filter == NULL) {
+        return 0;
+    }
+    return counting_bloom_bytes(ll->filter);
+}
+
+/* Remove a node at the specified index */
+bool linked_list_remove(struct linked_list * ll, size_t index) {
+    INVALID_PTR_CHECK(ll, false);
+    uint32_t current = linked_list_traverse_to_index(ll, index);
+    if (current == NIL) {
+        return false;
+    }
+    unlink_node(ll, current);
+    arena_release(ll, current);
+    return true;
+}
+
+/* Insert an array of values at the tail of the list in one pass */
+bool linked_list_insert_end_bulk(struct linked_list * ll, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(ll, false);
+    if (n == 0) {
+        return true;
+    }
+    INVALID_PTR_CHECK(vals, false);
+    if (!arena_reserve(ll, n)) {
+        return false;
+    }
+
+    uint32_t prev = ll->tail;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t new = arena_take(ll, vals[i]);
+        NODE(ll, new)->prev = prev;
+        if (prev == NIL) {
+            ll->head = new;
+        }
+        else {
+            NODE(ll, prev)->next = new;
+        }
+        prev = new;
+    }
+    NODE(ll, prev)->next = NIL;
+    ll->tail = prev;
+    ll->len += n;
+    return true;
+}
+
+/* Insert an array of values at the head of the list in one pass */
+bool linked_list_insert_front_bulk(struct linked_list * ll, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(ll, false);
+    if (n == 0) {
+        return true;
+    }
+    INVALID_PTR_CHECK(vals, false);
+    if (!arena_reserve(ll, n)) {
+        return false;
+    }
+
+    uint32_t next = ll->head;
+    for (size_t i = n; i > 0; i--) {
+        uint32_t new = arena_take(ll, vals[i-1]);
+        NODE(ll, new)->next = next;
+        if (next == NIL) {
+            ll->tail = new;
+        }
+        else {
+            NODE(ll, next)->prev = new;
+        }
+        next = new;
+    }
+    NODE(ll, next)->prev = NIL;
+    ll->head = next;
+    ll->len += n;
+    return true;
+}
+
+/* Remove a contiguous range of nodes, releasing them in one pass */
+bool linked_list_remove_range(struct linked_list * ll, size_t start, size_t count) {
+    INVALID_PTR_CHECK(ll, false);
+    if (start > ll->len || count > ll->len - start) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    uint32_t current = linked_list_traverse_to_index(ll, start);
+    uint32_t before = NODE(ll, current)->prev;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t next = NODE(ll, current)->next;
+        arena_release(ll, current);
+        current = next;
+    }
+
+    if (before == NIL) {
+        ll->head = current;
+    }
+    else {
+        NODE(ll, before)->next = current;
+    }
+    if (current == NIL) {
+        ll->tail = before;
+    }
+    else {
+        NODE(ll, current)->prev = before;
+    }
+    ll->len -= count;
+    return true;
+}
+
+/* Release every node for which pred() returns match, in one walk */
+static size_t remove_matching(struct linked_list * ll, bool (*pred)(unsigned int, void *),
+                              void * ctx, bool match) {
+    size_t removed = 0;
+    uint32_t kept = NIL;
+    uint32_t current = ll->head;
+    while (current != NIL) {
+        uint32_t next = NODE(ll, current)->next;
+        if (pred(NODE(ll, current)->data, ctx) == match) {
+            arena_release(ll, current);
+            ++removed;
+        }
+        else {
+            // Link back to the last kept node, skipping anything released
+            NODE(ll, current)->prev = kept;
+            if (kept == NIL) {
+                ll->head = current;
+            }
+            else {
+                NODE(ll, kept)->next = current;
+            }
+            kept = current;
+        }
+        current = next;
+    }
+    if (kept == NIL) {
+        ll->head = NIL;
+    }
+    else {
+        NODE(ll, kept)->next = NIL;
+    }
+    ll->tail = kept;
+    ll->len -= removed;
+    return removed;
+}
+
+/* Remove every node matching pred */
+size_t linked_list_remove_if(struct linked_list * ll, bool (*pred)(unsigned int, void *), void * ctx) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    INVALID_PTR_CHECK(pred, SIZE_MAX);
+    return remove_matching(ll, pred, ctx, true);
+}
+
+/* Remove every node not matching pred */
+size_t linked_list_retain_if(struct linked_list * ll, bool (*pred)(unsigned int, void *), void * ctx) {
+    INVALID_PTR_CHECK(ll, SIZE_MAX);
+    INVALID_PTR_CHECK(pred, SIZE_MAX);
+    return remove_matching(ll, pred, ctx, false);
+}
+
+/* Initialize a caller-owned iterator at the specified index */
+bool linked_list_iterator_init(struct iterator * iter, struct linked_list * ll, size_t index) {
+    INVALID_PTR_CHECK(iter, false);
+    INVALID_PTR_CHECK(ll, false);
+
+    // Out of range, before the index is narrowed for the traversal
+    if (index >= ll->len) {
+        return false;
+    }
+    uint32_t current = linked_list_traverse_to_index(ll, index);
+    if (current == NIL) {
+        return false;
+    }
+    iter->ll = ll;
+    iter->current_index = index;
+    iter->current_node = current;
+    iter->data = NODE(ll, current)->data;
+    return true;
+}
+
+/* Create an iterator to conveniently traverse nodes and access their members */
+struct iterator * linked_list_create_iterator(struct linked_list * ll, size_t index) {
+    INVALID_PTR_CHECK(ll, NULL);
+    if (index >= ll->len) {
+        return NULL;
+    }
+    struct iterator * it = (struct iterator *) malloc_fptr(sizeof(struct iterator));
+    INVALID_PTR_CHECK(it, NULL);
+    linked_list_iterator_init(it, ll, index);
+    return it;
+}
+
+/* Delete an iterator */
+bool linked_list_delete_iterator(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    free_fptr(iter);
+    return true;
+}
+
+/* Iterate forward through the list */
+bool linked_list_iterate(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NIL) {
+        return false;
+    }
+    uint32_t next = NODE(iter->ll, iter->current_node)->next;
+    if (next == NIL) {
+        return false;
+    }
+    iter->current_index++;
+    iter->current_node = next;
+    iter->data = NODE(iter->ll, next)->data;
+    return true;
+}
+
+/* Iterate backward through the list */
+bool linked_list_iterate_prev(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NIL) {
+        return false;
+    }
+    uint32_t prev = NODE(iter->ll, iter->current_node)->prev;
+    if (prev == NIL) {
+        return false;
+    }
+    iter->current_index--;
+    iter->current_node = prev;
+    iter->data = NODE(iter->ll, prev)->data;
+    return true;
+}
+
+/* Insert a new node in front of the iterator's node */
+bool linked_list_insert_before(struct iterator * iter, unsigned int data) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NIL) {
+        return false;
+    }
+    uint32_t new = create_node(iter->ll, data);
+    if (new == NIL) {
+        return false;
+    }
+    link_before(iter->ll, iter->current_node, new);
+    iter->current_index++;
+    return true;
+}
+
+/* Insert a new node after the iterator's node */
+bool linked_list_insert_after(struct iterator * iter, unsigned int data) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NIL) {
+        return false;
+    }
+    uint32_t new = create_node(iter->ll, data);
+    if (new == NIL) {
+        return false;
+    }
+    link_before(iter->ll, NODE(iter->ll, iter->current_node)->next, new);
+    return true;
+}
+
+/* Remove the iterator's node and move onto the node that followed it */
+bool linked_list_remove_at(struct iterator * iter) {
+    INVALID_PTR_CHECK(iter, false);
+    if (iter->current_node == NIL) {
+        return false;
+    }
+    struct linked_list * ll = iter->ll;
+    uint32_t idx = iter->current_node;
+    iter->current_node = NODE(ll, idx)->next;
+    if (iter->current_node != NIL) {
+        iter->data = NODE(ll, iter->current_node)->data;
+    }
+    unlink_node(ll, idx);
+    arena_release(ll, idx);
+    return true;
+}
+
+/* Register a malloc function */
+bool linked_list_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register a free function */
+bool linked_list_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
@@ -0,0 +1,577 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "concurrent_list.h"
+#include "linked_list.h"
+
+// Microbenchmarks for linked_list traversal. Lists are sized to be
+// well beyond the last level cache, so the numbers reflect memory latency
+// rather than cache hits.
+//
+#define GRAB_CLOCK(x) clock_gettime(CLOCK_MONOTONIC, &x);
+
+// Number of nodes in each benchmark list, 8M nodes is 192 MB of nodes.
+//
+#define BENCH_NODES      (8u * 1024u * 1024u)
+#define FIND_ITERATIONS  (5)
+
+long compute_timespec_diff(struct timespec start,
+                           struct timespec stop) {
+    long nanoseconds;
+    nanoseconds = (stop.tv_sec - start.tv_sec) * 1000000000L;
+
+    if (start.tv_nsec > stop.tv_nsec) {
+        nanoseconds -= 1000000000L;
+        nanoseconds += (start.tv_nsec - stop.tv_nsec);
+    } else {
+        nanoseconds += (stop.tv_nsec - start.tv_nsec);
+    }
+
+    return nanoseconds;
+}
+
+// Simple LCG, good enough to scatter values.
+//
+static unsigned int bench_seed = 12345;
+unsigned int bench_rand(void) {
+    bench_seed = bench_seed * 1103515245u + 12345u;
+    return bench_seed >> 1;
+}
+
+// Builds a list of n random values, one malloc() per node. Random values
+// never equal UINT_MAX, which benchmarks use as a value that is never found.
+//
+struct linked_list * build_list(size_t n) {
+    struct linked_list * ll = linked_list_create();
+    if (ll == NULL) {
+        printf("Failed to create linked_list.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!linked_list_insert_end(ll, bench_rand())) {
+            printf("Failed to insert into linked_list.\n");
+            exit(1);
+        }
+    }
+    return ll;
+}
+
+// Times linked_list_find() misses, each of which walks the whole list,
+// after one untimed warm-up walk.
+// Returns average nanoseconds per node visited.
+//
+double time_find_miss(struct linked_list * ll) {
+    linked_list_find(ll, ~0u);
+
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    for (size_t i = 0; i < FIND_ITERATIONS; i++) {
+        if (linked_list_find(ll, ~0u) != SIZE_MAX) {
+            printf("Found a value that was never inserted.\n");
+            exit(1);
+        }
+    }
+    GRAB_CLOCK(stop)
+    long nanoseconds = compute_timespec_diff(start, stop);
+    return (double)nanoseconds / ((double)FIND_ITERATIONS * (double)linked_list_size(ll));
+}
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+// Find throughput on a churned list, before and after linked_list_compact().
+// Sorting the random values relinks the nodes into an order unrelated to
+// where they sit in memory, which is what heavy insert/remove churn does
+// over time.
+//
+void compact_benchmark(void) {
+    printf("Compaction benchmark, %u nodes\n", BENCH_NODES);
+    struct linked_list * ll = build_list(BENCH_NODES);
+    printf("Find miss, allocation order [ns/node]: %0.3f\n", time_find_miss(ll));
+
+    linked_list_radix_sort(ll);
+    printf("Find miss, churned          [ns/node]: %0.3f\n", time_find_miss(ll));
+
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    bool status = linked_list_compact(ll);
+    GRAB_CLOCK(stop)
+    if (!status) {
+        printf("linked_list_compact() failed.\n");
+        exit(1);
+    }
+    printf("Compaction time [s]: %0.3f\n", (float)compute_timespec_diff(start, stop) / 1000000000.0f);
+    printf("Find miss, compacted        [ns/node]: %0.3f\n\n", time_find_miss(ll));
+
+    linked_list_delete(ll);
+}
+#endif
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+// Builds a list out of runs of RUN_NODES nodes that are contiguous in
+// memory, with the runs linked together in a random order.
+//
+#define RUN_NODES (256)
+struct linked_list * build_run_list(size_t n) {
+    size_t run_count = n / RUN_NODES;
+    struct linked_list ** runs = malloc(run_count * sizeof(struct linked_list *));
+    unsigned int * vals = malloc(RUN_NODES * sizeof(unsigned int));
+    if (runs == NULL || vals == NULL) {
+        printf("Failed to allocate runs.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < run_count; i++) {
+        for (size_t j = 0; j < RUN_NODES; j++) {
+            vals[j] = bench_rand();
+        }
+        runs[i] = linked_list_create();
+        if (runs[i] == NULL || !linked_list_insert_end_bulk(runs[i], vals, RUN_NODES)) {
+            printf("Failed to build run.\n");
+            exit(1);
+        }
+    }
+
+    // Fisher-Yates shuffle the runs, then chain them together
+    for (size_t i = run_count - 1; i > 0; i--) {
+        size_t j = bench_rand() % (i + 1);
+        struct linked_list * tmp = runs[i];
+        runs[i] = runs[j];
+        runs[j] = tmp;
+    }
+    for (size_t i = 1; i < run_count; i++) {
+        linked_list_concat(runs[0], runs[i]);
+        linked_list_delete(runs[i]);
+    }
+
+    struct linked_list * ll = runs[0];
+    free(runs);
+    free(vals);
+    return ll;
+}
+
+// Find throughput with and without software prefetching, on a fully
+// contiguous list, a list of contiguous runs in random order and a list
+// scattered node by node.
+//
+void prefetch_benchmark(void) {
+    const unsigned int distances[] = {0, 4, 8, 16, 32};
+    const char * names[] = {"contiguous", "runs", "scattered"};
+    struct linked_list * lists[3];
+
+    printf("Prefetch benchmark, %u nodes, runs of %u nodes\n", BENCH_NODES, RUN_NODES);
+    lists[0] = build_list(BENCH_NODES);
+    linked_list_compact(lists[0]);
+    lists[1] = build_run_list(BENCH_NODES);
+    lists[2] = build_list(BENCH_NODES);
+    linked_list_radix_sort(lists[2]);
+
+    for (size_t l = 0; l < 3; l++) {
+        for (size_t d = 0; d < sizeof(distances) / sizeof(distances[0]); d++) {
+            linked_list_set_prefetch_distance(lists[l], distances[d]);
+            printf("Find miss, %-10s distance %2u [ns/node]: %0.3f\n",
+                   names[l], distances[d], time_find_miss(lists[l]));
+        }
+        linked_list_delete(lists[l]);
+    }
+    printf("\n");
+}
+#endif
+
+// Concurrent list scaling. Each thread runs a read-mostly mix of 80%
+// finds, 10% inserts and 10% removes on random keys, against a list kept
+// around half full.
+//
+#define CONCURRENT_KEYS           (2048u)
+#define CONCURRENT_OPS_PER_THREAD (200000u)
+#define CONCURRENT_MIN_THREADS    (4u)
+#define CONCURRENT_MAX_THREADS    (16u)
+
+struct concurrent_worker {
+    pthread_t thread;
+    struct concurrent_list * list;
+    pthread_barrier_t * start;
+    unsigned int seed;
+};
+
+void * concurrent_worker_run(void * arg) {
+    struct concurrent_worker * worker = arg;
+    struct epoch_thread * thread = concurrent_list_register_thread(worker->list);
+    if (thread == NULL) {
+        printf("Failed to register with concurrent_list.\n");
+        exit(1);
+    }
+    unsigned int seed = worker->seed;
+    pthread_barrier_wait(worker->start);
+    for (size_t i = 0; i < CONCURRENT_OPS_PER_THREAD; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int r = seed >> 1;
+        unsigned int key = (r >> 4) % CONCURRENT_KEYS;
+        unsigned int op = r % 10;
+        if (op == 0) {
+            concurrent_list_insert(worker->list, thread, key);
+        } else if (op == 1) {
+            concurrent_list_remove(worker->list, thread, key);
+        } else {
+            concurrent_list_find(worker->list, thread, key);
+        }
+    }
+    concurrent_list_unregister_thread(thread);
+    return NULL;
+}
+
+void concurrent_benchmark(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    // Always go a little past one thread, so contention is exercised even
+    // on small machines.
+    unsigned int max_threads = (cpus < CONCURRENT_MIN_THREADS) ? CONCURRENT_MIN_THREADS : (unsigned int)cpus;
+    if (max_threads > CONCURRENT_MAX_THREADS) {
+        max_threads = CONCURRENT_MAX_THREADS;
+    }
+    printf("Concurrent list benchmark, %u keys, %u ops per thread, %ld CPUs\n",
+           CONCURRENT_KEYS, CONCURRENT_OPS_PER_THREAD, cpus);
+
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        struct concurrent_list * list = concurrent_list_create();
+        struct epoch_thread * self = concurrent_list_register_thread(list);
+        if (list == NULL || self == NULL) {
+            printf("Failed to create concurrent_list.\n");
+            exit(1);
+        }
+        for (unsigned int key = 0; key < CONCURRENT_KEYS; key += 2) {
+            concurrent_list_insert(list, self, key);
+        }
+        concurrent_list_unregister_thread(self);
+
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, threads + 1);
+        struct concurrent_worker workers[CONCURRENT_MAX_THREADS];
+        for (unsigned int i = 0; i < threads; i++) {
+            workers[i].list = list;
+            workers[i].start = &start;
+            workers[i].seed = bench_rand();
+            pthread_create(&workers[i].thread, NULL, concurrent_worker_run, &workers[i]);
+        }
+
+        struct timespec begin, stop;
+        pthread_barrier_wait(&start);
+        GRAB_CLOCK(begin)
+        for (unsigned int i = 0; i < threads; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        GRAB_CLOCK(stop)
+        pthread_barrier_destroy(&start);
+
+        double seconds = (double)compute_timespec_diff(begin, stop) / 1000000000.0;
+        double mops = (double)threads * CONCURRENT_OPS_PER_THREAD / seconds / 1000000.0;
+        printf("Threads %2u [Mops/s]: %0.3f\n", threads, mops);
+        concurrent_list_delete(list);
+    }
+    printf("\n");
+}
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+// Read-mostly list scaling. Reader threads run find misses over a cache
+// resident list inside read sections, while the main thread writes to it
+// every RCU_WRITE_INTERVAL_NS.
+//
+#define RCU_NODES                (4096u)
+#define RCU_FINDS_PER_READER     (2000u)
+#define RCU_WRITE_INTERVAL_NS    (20000L)
+
+struct rcu_reader {
+    pthread_t thread;
+    struct linked_list * ll;
+    pthread_barrier_t * start;
+};
+
+void * rcu_reader_run(void * arg) {
+    struct rcu_reader * reader = arg;
+    struct epoch_thread * handle = linked_list_rcu_register_reader(reader->ll);
+    if (handle == NULL) {
+        printf("Failed to register a reader.\n");
+        exit(1);
+    }
+    pthread_barrier_wait(reader->start);
+    for (size_t i = 0; i < RCU_FINDS_PER_READER; i++) {
+        linked_list_rcu_read_lock(handle);
+        linked_list_find(reader->ll, ~0u);
+        linked_list_rcu_read_unlock(handle);
+    }
+    linked_list_rcu_unregister_reader(handle);
+    return NULL;
+}
+
+void rcu_benchmark(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int max_threads = (cpus < CONCURRENT_MIN_THREADS) ? CONCURRENT_MIN_THREADS : (unsigned int)cpus;
+    if (max_threads > CONCURRENT_MAX_THREADS) {
+        max_threads = CONCURRENT_MAX_THREADS;
+    }
+    printf("Read-mostly list benchmark, %u nodes, %u finds per reader, %ld CPUs\n",
+           RCU_NODES, RCU_FINDS_PER_READER, cpus);
+
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        struct linked_list * ll = build_list(RCU_NODES);
+        if (!linked_list_rcu_enable(ll)) {
+            printf("linked_list_rcu_enable() failed.\n");
+            exit(1);
+        }
+
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, threads + 1);
+        struct rcu_reader readers[CONCURRENT_MAX_THREADS];
+        for (unsigned int i = 0; i < threads; i++) {
+            readers[i].ll = ll;
+            readers[i].start = &start;
+            pthread_create(&readers[i].thread, NULL, rcu_reader_run, &readers[i]);
+        }
+
+        // Occasional writes: replace a random node until the readers finish
+        struct timespec begin, stop;
+        struct timespec interval = {0, RCU_WRITE_INTERVAL_NS};
+        size_t writes = 0;
+        pthread_barrier_wait(&start);
+        GRAB_CLOCK(begin)
+        for (unsigned int i = 0; i < threads; i++) {
+            while (pthread_tryjoin_np(readers[i].thread, NULL) != 0) {
+                linked_list_remove(ll, bench_rand() % RCU_NODES);
+                linked_list_insert(ll, bench_rand() % RCU_NODES, bench_rand());
+                ++writes;
+                nanosleep(&interval, NULL);
+            }
+        }
+        GRAB_CLOCK(stop)
+        pthread_barrier_destroy(&start);
+
+        double seconds = (double)compute_timespec_diff(begin, stop) / 1000000000.0;
+        double nodes = (double)threads * RCU_FINDS_PER_READER * RCU_NODES;
+        printf("Readers %2u [Mnodes/s]: %0.3f, writes: %zu\n", threads, nodes / seconds / 1000000.0, writes);
+        linked_list_delete(ll);
+    }
+    printf("\n");
+}
+#endif
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+// Parallel find miss and sum against the serial find, for 1..N threads.
+// The first parallel scan builds the segment table and isn't timed.
+//
+void parallel_benchmark(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int max_threads = (cpus < CONCURRENT_MIN_THREADS) ? CONCURRENT_MIN_THREADS : (unsigned int)cpus;
+    if (max_threads > CONCURRENT_MAX_THREADS) {
+        max_threads = CONCURRENT_MAX_THREADS;
+    }
+    printf("Parallel scan benchmark, %u nodes, %ld CPUs\n", BENCH_NODES, cpus);
+    struct linked_list * ll = build_list(BENCH_NODES);
+    printf("Serial find miss            [ns/node]: %0.3f\n", time_find_miss(ll));
+    linked_list_parallel_find(ll, ~0u);
+
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        linked_list_set_parallel_workers(threads);
+        struct timespec start, stop;
+        GRAB_CLOCK(start)
+        for (size_t i = 0; i < FIND_ITERATIONS; i++) {
+            if (linked_list_parallel_find(ll, ~0u) != SIZE_MAX) {
+                printf("Found a value that was never inserted.\n");
+                exit(1);
+            }
+        }
+        GRAB_CLOCK(stop)
+        double find_ns = (double)compute_timespec_diff(start, stop) / ((double)FIND_ITERATIONS * BENCH_NODES);
+
+        uint64_t sum;
+        GRAB_CLOCK(start)
+        for (size_t i = 0; i < FIND_ITERATIONS; i++) {
+            linked_list_parallel_sum(ll, &sum);
+        }
+        GRAB_CLOCK(stop)
+        double sum_ns = (double)compute_timespec_diff(start, stop) / ((double)FIND_ITERATIONS * BENCH_NODES);
+        printf("Threads %2u find miss, sum  [ns/node]: %0.3f, %0.3f\n", threads, find_ns, sum_ns);
+    }
+    linked_list_set_parallel_workers(0);
+    linked_list_delete(ll);
+    printf("\n");
+}
+#endif
+
+// Rebuilding a list of BENCH_NODES values, deleting and re-creating it
+// each round against clearing it with its nodes retained.
+//
+#define CLEAR_ROUNDS    (20)
+void clear_benchmark(void) {
+    printf("Clear benchmark, %u nodes, %u rounds\n", BENCH_NODES, CLEAR_ROUNDS);
+    unsigned int * vals = malloc(BENCH_NODES * sizeof(unsigned int));
+    if (vals == NULL) {
+        printf("Failed to allocate values.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < BENCH_NODES; i++) {
+        vals[i] = bench_rand();
+    }
+
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    for (unsigned int round = 0; round < CLEAR_ROUNDS; round++) {
+        struct linked_list * ll = linked_list_create();
+        for (size_t i = 0; i < BENCH_NODES; i++) {
+            linked_list_insert_end(ll, vals[i]);
+        }
+        linked_list_delete(ll);
+    }
+    GRAB_CLOCK(stop)
+    double delete_ns = (double)compute_timespec_diff(start, stop) / ((double)CLEAR_ROUNDS * BENCH_NODES);
+
+    struct linked_list * ll = linked_list_create();
+    GRAB_CLOCK(start)
+    for (unsigned int round = 0; round < CLEAR_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_NODES; i++) {
+            linked_list_insert_end(ll, vals[i]);
+        }
+        linked_list_clear(ll, true);
+    }
+    GRAB_CLOCK(stop)
+    double clear_ns = (double)compute_timespec_diff(start, stop) / ((double)CLEAR_ROUNDS * BENCH_NODES);
+    linked_list_delete(ll);
+    free(vals);
+
+    printf("Delete and re-create        [ns/node]: %0.3f\n", delete_ns);
+    printf("Clear, retaining nodes      [ns/node]: %0.3f\n", clear_ns);
+    printf("\n");
+}
+
+// linked_list_find() misses with and without a membership filter, and
+// what the filter adds to building the list.
+//
+#define FILTER_LOOKUPS  (2000u)
+void filter_benchmark(void) {
+    printf("Membership filter benchmark, %u nodes\n", BENCH_NODES);
+
+    // Untimed first build, so both timed builds get memory that is already mapped
+    linked_list_delete(build_list(BENCH_NODES));
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    struct linked_list * ll = build_list(BENCH_NODES);
+    GRAB_CLOCK(stop)
+    double build_ns = (double)compute_timespec_diff(start, stop) / BENCH_NODES;
+    double miss_ns = time_find_miss(ll) * BENCH_NODES;
+    linked_list_delete(ll);
+
+    ll = linked_list_create();
+    if (ll == NULL || !linked_list_filter_enable(ll, BENCH_NODES, 0.01)) {
+        printf("Failed to enable the filter.\n");
+        exit(1);
+    }
+    GRAB_CLOCK(start)
+    for (size_t i = 0; i < BENCH_NODES; i++) {
+        linked_list_insert_end(ll, bench_rand());
+    }
+    GRAB_CLOCK(stop)
+    double filtered_build_ns = (double)compute_timespec_diff(start, stop) / BENCH_NODES;
+
+    // Random values have the top bit clear, so these all miss. The ones
+    // the filter can't rule out still walk the whole list.
+    GRAB_CLOCK(start)
+    for (unsigned int i = 0; i < FILTER_LOOKUPS; i++) {
+        if (linked_list_find(ll, bench_rand() | 0x80000000u) != SIZE_MAX) {
+            printf("Found a value that was never inserted.\n");
+            exit(1);
+        }
+    }
+    GRAB_CLOCK(stop)
+    double filtered_miss_ns = (double)compute_timespec_diff(start, stop) / FILTER_LOOKUPS;
+
+    printf("Build, no filter            [ns/node]: %0.3f\n", build_ns);
+    printf("Build, 1%% filter            [ns/node]: %0.3f\n", filtered_build_ns);
+    printf("Filter memory           [bytes/node]: %0.3f\n",
+           (double)linked_list_filter_bytes(ll) / BENCH_NODES);
+    printf("Find miss, no filter       [ns/find]: %0.1f\n", miss_ns);
+    printf("Find miss, 1%% filter       [ns/find]: %0.1f\n", filtered_miss_ns);
+    linked_list_delete(ll);
+    printf("\n");
+}
+
+// Short-lived small lists: create, fill, search and delete, counting the
+// allocations each list makes.
+//
+#define SMALL_LISTS     (1000000u)
+#define SMALL_LENGTHS   (3)
+static size_t small_allocs = 0;
+void * counting_bench_malloc(size_t size) {
+    small_allocs++;
+    return malloc(size);
+}
+
+void small_benchmark(void) {
+    static const unsigned int lengths[SMALL_LENGTHS] = {4, LINKED_LIST_INLINE_NODES, 2 * LINKED_LIST_INLINE_NODES};
+    printf("Small list benchmark, %u lists per length, %u inline nodes\n", SMALL_LISTS, LINKED_LIST_INLINE_NODES);
+    linked_list_register_malloc(counting_bench_malloc);
+    for (unsigned int l = 0; l < SMALL_LENGTHS; l++) {
+        small_allocs = 0;
+        struct timespec start, stop;
+        GRAB_CLOCK(start)
+        for (unsigned int i = 0; i < SMALL_LISTS; i++) {
+            struct linked_list * ll = linked_list_create();
+            for (unsigned int j = 0; j < lengths[l]; j++) {
+                linked_list_insert_end(ll, i + j);
+            }
+            if (linked_list_find(ll, i) != 0) {
+                printf("Lost a value.\n");
+                exit(1);
+            }
+            linked_list_delete(ll);
+        }
+        GRAB_CLOCK(stop)
+        printf("Length %2u                  [ns/list]: %0.1f, %0.2f allocations per list\n", lengths[l],
+               (double)compute_timespec_diff(start, stop) / SMALL_LISTS, (double)small_allocs / SMALL_LISTS);
+    }
+    linked_list_register_malloc(malloc);
+    printf("\n");
+}
+
+struct benchmark {
+    const char * name;
+    void (*run)(void);
+};
+
+struct benchmark benchmarks[] = {
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    {"compact", compact_benchmark},
+    {"prefetch", prefetch_benchmark},
+#endif
+    {"concurrent", concurrent_benchmark},
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    {"rcu", rcu_benchmark},
+    {"parallel", parallel_benchmark},
+#endif
+    {"clear", clear_benchmark},
+    {"filter", filter_benchmark},
+    {"small", small_benchmark},
+    {NULL, NULL},
+};
+
+// Runs the benchmarks named on the command line, or all of them.
+//
+int main(int argc, char ** argv) {
+    linked_list_register_malloc(malloc);
+    linked_list_register_free(free);
+    concurrent_list_register_malloc(malloc);
+    concurrent_list_register_free(free);
+
+    for (struct benchmark * b = benchmarks; b->name != NULL; b++) {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], b->name) == 0) {
+                selected = true;
+            }
+        }
+        if (selected) {
+            b->run();
+        }
+    }
+    return 0;
+}
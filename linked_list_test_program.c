@@ -1,14 +1,24 @@
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "concurrent_list.h"
+#include "counting_bloom.h"
 #include "linked_list.h"
+#include "mpmc_queue.h"
+#include "pqueue.h"
 #include "slab_allocator.h"
 #include "queue.h"
 #include "slab_allocator_test.h"
+#include "spsc_queue.h"
+#include "ws_deque.h"
 
 // Define this is you wish to run with the custom allocator
 #define SLAB_ALLOCATOR_TEST
@@ -199,7 +209,7 @@ void check_empty_list_and_queue_properties(void) {
 
     // Check invariant that head is null when empty.
     //
-    FAIL((ll->head != NULL),
+    FAIL((ll->head != LINKED_LIST_NO_NODE),
          "ll->head is non-null in empty linked_list");
 
     linked_list_delete(ll);
@@ -575,6 +585,2326 @@ void check_linked_list_additional_delete_tests(void) {
 #endif 
 }
 
+// Walks the linked_list and checks it holds exactly the values in expected,
+// both forwards and backwards.
+//
+bool linked_list_matches(struct linked_list * ll,
+                         const unsigned int * expected,
+                         size_t n) {
+    if (linked_list_size(ll) != n) {
+        return false;
+    }
+    if (n == 0) {
+        return ll->head == LINKED_LIST_NO_NODE && ll->tail == LINKED_LIST_NO_NODE;
+    }
+
+    struct iterator iter;
+    if (!linked_list_iterator_init(&iter, ll, 0)) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (iter.data != expected[i] || iter.current_index != i) {
+            return false;
+        }
+        if (linked_list_iterate(&iter) != (i + 1 < n)) {
+            return false;
+        }
+    }
+
+    for (size_t i = n; i > 0; i--) {
+        if (iter.data != expected[i - 1]) {
+            return false;
+        }
+        if (linked_list_iterate_prev(&iter) != (i > 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_linked_list_bulk_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_bulk_functionality)
+
+    SUBTEST(insert_end_bulk)
+    // Bulk insert 3, 4, 5 behind 1, 2.
+    //
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end(ll, 1);
+    linked_list_insert_end(ll, 2);
+    const unsigned int tail_vals[] = {3, 4, 5};
+    bool status = linked_list_insert_end_bulk(ll, tail_vals, 3);
+    FAIL(status == false,
+         "linked_list_insert_end_bulk() failed")
+    const unsigned int expected_1[] = {1, 2, 3, 4, 5};
+    FAIL(!linked_list_matches(ll, expected_1, 5),
+         "linked_list_insert_end_bulk() produced the wrong list")
+
+    SUBTEST(insert_front_bulk)
+    // Bulk insert 7, 8, 9 in front, 7 becoming the head.
+    //
+    const unsigned int front_vals[] = {7, 8, 9};
+    status = linked_list_insert_front_bulk(ll, front_vals, 3);
+    FAIL(status == false,
+         "linked_list_insert_front_bulk() failed")
+    const unsigned int expected_2[] = {7, 8, 9, 1, 2, 3, 4, 5};
+    FAIL(!linked_list_matches(ll, expected_2, 8),
+         "linked_list_insert_front_bulk() produced the wrong list")
+
+    SUBTEST(remove_range_middle)
+    status = linked_list_remove_range(ll, 2, 3);
+    FAIL(status == false,
+         "linked_list_remove_range() failed in the middle of the list")
+    const unsigned int expected_3[] = {7, 8, 3, 4, 5};
+    FAIL(!linked_list_matches(ll, expected_3, 5),
+         "linked_list_remove_range() produced the wrong list")
+
+    SUBTEST(remove_range_out_of_bounds)
+    status = linked_list_remove_range(ll, 3, 3);
+    FAIL(status != false,
+         "linked_list_remove_range() removed a range past the end")
+    FAIL(!linked_list_matches(ll, expected_3, 5),
+         "linked_list_remove_range() modified the list on failure")
+
+    SUBTEST(remove_range_ends)
+    status = linked_list_remove_range(ll, 3, 2);
+    FAIL(status == false,
+         "linked_list_remove_range() failed at the tail")
+    status = linked_list_remove_range(ll, 0, 1);
+    FAIL(status == false,
+         "linked_list_remove_range() failed at the head")
+    const unsigned int expected_4[] = {8, 3};
+    FAIL(!linked_list_matches(ll, expected_4, 2),
+         "linked_list_remove_range() produced the wrong list at the ends")
+
+    SUBTEST(remove_range_all_and_reuse)
+    // Empty the list, then refill it from the recycled nodes.
+    //
+    status = linked_list_remove_range(ll, 0, 2);
+    FAIL(status == false || linked_list_size(ll) != 0 || ll->head != LINKED_LIST_NO_NODE,
+         "linked_list_remove_range() did not empty the list")
+    status = linked_list_insert_end_bulk(ll, tail_vals, 3);
+    FAIL(!linked_list_matches(ll, tail_vals, 3),
+         "linked_list_insert_end_bulk() on an emptied list failed")
+
+    SUBTEST(bulk_null_handling)
+    status = linked_list_insert_end_bulk(NULL, tail_vals, 3);
+    FAIL(status != false,
+         "linked_list_insert_end_bulk(NULL, ...) did not return false")
+    status = linked_list_insert_front_bulk(ll, NULL, 3);
+    FAIL(status != false,
+         "linked_list_insert_front_bulk(ll, NULL, 3) did not return false")
+    status = linked_list_remove_range(NULL, 0, 1);
+    FAIL(status != false,
+         "linked_list_remove_range(NULL, 0, 1) did not return false")
+
+    linked_list_delete(ll);
+    PASS(check_linked_list_bulk_functionality)
+#endif
+}
+
+// Wraps instrumented_malloc()/instrumented_free(), counting the calls, to
+// see what the node pool keeps allocated.
+//
+static size_t pool_test_allocs = 0;
+static size_t pool_test_frees  = 0;
+
+void * pool_test_malloc(size_t size) {
+    void * ptr = instrumented_malloc(size);
+    pool_test_allocs += (ptr != NULL);
+    return ptr;
+}
+
+void pool_test_free(void * addr) {
+    pool_test_frees += (addr != NULL);
+    instrumented_free(addr);
+}
+
+#define POOL_TEST_THREADS  (4)
+#define POOL_TEST_VALUES   (500)
+#define POOL_TEST_ROUNDS   (50)
+
+struct pool_test_worker {
+    pthread_t thread;
+    unsigned int id;
+    bool ok;
+};
+
+// Fills and empties a list of its own, over and over, while the other
+// workers do the same with theirs through the shared pool.
+//
+void * pool_test_worker_run(void * arg) {
+    struct pool_test_worker * worker = arg;
+    unsigned int vals[POOL_TEST_VALUES];
+    for (unsigned int i = 0; i < POOL_TEST_VALUES; i++) {
+        vals[i] = worker->id * POOL_TEST_VALUES + i;
+    }
+    struct linked_list * ll = linked_list_create();
+    worker->ok = (ll != NULL);
+    for (unsigned int round = 0; worker->ok && round < POOL_TEST_ROUNDS; round++) {
+        worker->ok = linked_list_insert_end_bulk(ll, vals, POOL_TEST_VALUES) &&
+                     linked_list_matches(ll, vals, POOL_TEST_VALUES);
+        for (unsigned int i = 0; worker->ok && i < POOL_TEST_VALUES / 2; i++) {
+            worker->ok = linked_list_remove(ll, 0);
+        }
+        worker->ok = worker->ok && linked_list_clear(ll, false);
+    }
+    linked_list_delete(ll);
+    return NULL;
+}
+
+void check_linked_list_pool_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_pool_functionality)
+
+    SUBTEST(pool_concurrent_lists)
+    // The slab allocator isn't thread safe.
+    //
+    linked_list_register_malloc(malloc);
+    linked_list_register_free(free);
+    struct pool_test_worker workers[POOL_TEST_THREADS];
+    for (unsigned int i = 0; i < POOL_TEST_THREADS; i++) {
+        workers[i].id = i;
+        pthread_create(&workers[i].thread, NULL, pool_test_worker_run, &workers[i]);
+    }
+    for (unsigned int i = 0; i < POOL_TEST_THREADS; i++) {
+        pthread_join(workers[i].thread, NULL);
+        FAIL(!workers[i].ok,
+             "Bulk inserts into separate lists from separate threads corrupted a list")
+    }
+    linked_list_register_malloc(&instrumented_malloc);
+    linked_list_register_free(&instrumented_free);
+
+    SUBTEST(pool_frees_empty_block)
+    // a's nodes fill a block of their own, which has to go back to the
+    // allocator when a is deleted, though b still holds pooled nodes.
+    //
+    linked_list_register_malloc(&pool_test_malloc);
+    linked_list_register_free(&pool_test_free);
+    unsigned int vals[200];
+    for (unsigned int i = 0; i < 200; i++) {
+        vals[i] = i;
+    }
+    struct linked_list * b = linked_list_create();
+    linked_list_insert_end_bulk(b, vals, 200);
+    size_t outstanding = pool_test_allocs - pool_test_frees;
+    size_t allocs = pool_test_allocs;
+    struct linked_list * a = linked_list_create();
+    linked_list_insert_end_bulk(a, vals, 200);
+    FAIL(pool_test_allocs - allocs != 2,
+         "Bulk insert reused pool nodes nothing should have left spare")
+    linked_list_delete(a);
+    FAIL(pool_test_allocs - pool_test_frees != outstanding,
+         "Deleting a list kept its emptied pool block allocated")
+    FAIL(!linked_list_matches(b, vals, 200),
+         "Freeing a pool block changed another list")
+    linked_list_delete(b);
+    FAIL(pool_test_allocs != pool_test_frees,
+         "Deleting every list left pool blocks allocated")
+
+    SUBTEST(pool_nodes_cached_per_list)
+    // Pooled nodes a removes one at a time stay with a for its next
+    // inserts rather than going to whichever list allocates next.
+    //
+    a = linked_list_create();
+    linked_list_insert_end_bulk(a, vals, 200);
+    struct node * removed[8];
+    for (unsigned int i = 0; i < 8; i++) {
+        removed[i] = a->tail;
+        linked_list_remove(a, linked_list_size(a) - 1);
+    }
+    b = linked_list_create();
+    for (unsigned int i = 0; i <= LINKED_LIST_INLINE_NODES; i++) {
+        linked_list_insert_end(b, i);
+    }
+    for (unsigned int i = 0; i < 8; i++) {
+        FAIL(b->tail == removed[i],
+             "A node removed from one list was handed to another")
+    }
+    for (unsigned int i = 0; i < 8; i++) {
+        linked_list_insert_end(a, 192 + i);
+        bool reused = false;
+        for (unsigned int j = 0; j < 8; j++) {
+            reused |= (a->tail == removed[j]);
+        }
+        FAIL(!reused,
+             "An insert did not reuse a node the list had just removed")
+    }
+    FAIL(!linked_list_matches(a, vals, 200),
+         "Reinserting into cached nodes produced the wrong list")
+    linked_list_remove(a, 199);
+    linked_list_delete(a);
+    linked_list_delete(b);
+    FAIL(pool_test_allocs != pool_test_frees,
+         "Deleting a list kept the pooled nodes it had cached")
+    linked_list_register_malloc(&instrumented_malloc);
+    linked_list_register_free(&instrumented_free);
+
+    PASS(check_linked_list_pool_functionality)
+#endif
+}
+
+void check_linked_list_iterator_mutation(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_iterator_mutation)
+
+    const unsigned int vals[] = {1, 2, 3, 4, 5, 6};
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, 6);
+
+    SUBTEST(iterator_init_on_stack)
+    struct iterator iter;
+    bool status = linked_list_iterator_init(&iter, ll, 6);
+    FAIL(status != false,
+         "linked_list_iterator_init() accepted an out of bounds index")
+#if SIZE_MAX > UINT_MAX
+    // Wraps to 2 if narrowed to unsigned int before the bounds check.
+    //
+    status = linked_list_iterator_init(&iter, ll, (size_t) UINT_MAX + 3);
+    FAIL(status != false,
+         "linked_list_iterator_init() accepted an index past UINT_MAX")
+#endif
+    status = linked_list_iterator_init(&iter, ll, 5);
+    FAIL(status == false || iter.data != 6 || iter.current_index != 5,
+         "linked_list_iterator_init() did not land on the tail")
+
+    SUBTEST(iterate_prev)
+    for (size_t i = 5; i > 0; i--) {
+        status = linked_list_iterate_prev(&iter);
+        FAIL(status == false || iter.data != i || iter.current_index != i - 1,
+             "linked_list_iterate_prev() returned the wrong node")
+    }
+    status = linked_list_iterate_prev(&iter);
+    FAIL(status != false,
+         "linked_list_iterate_prev() moved past the head")
+
+    SUBTEST(remove_odd_values_in_one_pass)
+    // Filter out odd values: 2, 4, 6 remain.
+    //
+    while (iter.current_node != LINKED_LIST_NO_NODE) {
+        if (iter.data % 2) {
+            status = linked_list_remove_at(&iter);
+            FAIL(status == false,
+                 "linked_list_remove_at() failed")
+        } else if (!linked_list_iterate(&iter)) {
+            break;
+        }
+    }
+    const unsigned int expected_1[] = {2, 4, 6};
+    FAIL(!linked_list_matches(ll, expected_1, 3),
+         "Filtering with linked_list_remove_at() produced the wrong list")
+
+    SUBTEST(insert_before_and_after)
+    // Re-insert the odd values around each even one.
+    //
+    linked_list_iterator_init(&iter, ll, 0);
+    do {
+        status = linked_list_insert_before(&iter, iter.data - 1);
+        FAIL(status == false,
+             "linked_list_insert_before() failed")
+    } while (linked_list_iterate(&iter));
+    status = linked_list_insert_after(&iter, 7);
+    FAIL(status == false || iter.current_index != 5 || iter.data != 6,
+         "linked_list_insert_after() moved the iterator")
+    const unsigned int expected_2[] = {1, 2, 3, 4, 5, 6, 7};
+    FAIL(!linked_list_matches(ll, expected_2, 7),
+         "Inserting with an iterator produced the wrong list")
+
+    SUBTEST(remove_tail_exhausts_iterator)
+    linked_list_iterator_init(&iter, ll, 6);
+    status = linked_list_remove_at(&iter);
+    FAIL(status == false || iter.current_node != LINKED_LIST_NO_NODE,
+         "Removing the tail did not exhaust the iterator")
+    FAIL(linked_list_iterate(&iter) != false,
+         "linked_list_iterate() advanced an exhausted iterator")
+    FAIL(linked_list_remove_at(&iter) != false,
+         "linked_list_remove_at() removed through an exhausted iterator")
+
+    linked_list_delete(ll);
+    PASS(check_linked_list_iterator_mutation)
+#endif
+}
+
+void check_linked_list_splice_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_splice_functionality)
+
+    const unsigned int vals_a[] = {1, 2, 3};
+    const unsigned int vals_b[] = {4, 5, 6, 7};
+    struct linked_list * a = linked_list_create();
+    struct linked_list * b = linked_list_create();
+    linked_list_insert_end_bulk(a, vals_a, 3);
+    linked_list_insert_end_bulk(b, vals_b, 4);
+
+    SUBTEST(concat)
+    bool status = linked_list_concat(a, b);
+    const unsigned int expected_1[] = {1, 2, 3, 4, 5, 6, 7};
+    FAIL(status == false || !linked_list_matches(a, expected_1, 7),
+         "linked_list_concat() produced the wrong list")
+    FAIL(!linked_list_matches(b, NULL, 0),
+         "linked_list_concat() did not empty the source list")
+    FAIL(linked_list_concat(a, a) != false,
+         "linked_list_concat() accepted the same list twice")
+
+    SUBTEST(concat_into_empty)
+    status = linked_list_concat(b, a);
+    FAIL(status == false || !linked_list_matches(b, expected_1, 7) ||
+         !linked_list_matches(a, NULL, 0),
+         "linked_list_concat() into an empty list failed")
+
+    SUBTEST(split)
+    struct linked_list * rest = linked_list_split(b, 3);
+    const unsigned int expected_2[] = {4, 5, 6, 7};
+    FAIL(rest == NULL || !linked_list_matches(b, vals_a, 3) ||
+         !linked_list_matches(rest, expected_2, 4),
+         "linked_list_split() produced the wrong lists")
+    FAIL(linked_list_split(b, 4) != NULL,
+         "linked_list_split() accepted an out of bounds index")
+
+    SUBTEST(splice_middle)
+    // Move 5, 6 between 1 and 2.
+    //
+    status = linked_list_splice(b, 1, rest, 1, 2);
+    const unsigned int expected_3[] = {1, 5, 6, 2, 3};
+    const unsigned int expected_4[] = {4, 7};
+    FAIL(status == false || !linked_list_matches(b, expected_3, 5) ||
+         !linked_list_matches(rest, expected_4, 2),
+         "linked_list_splice() into the middle produced the wrong lists")
+
+    SUBTEST(splice_ends)
+    // Move 7 to the end and 4 to the front.
+    //
+    status = linked_list_splice(b, 5, rest, 1, 1);
+    FAIL(status == false,
+         "linked_list_splice() to the tail failed")
+    status = linked_list_splice(b, 0, rest, 0, 1);
+    const unsigned int expected_5[] = {4, 1, 5, 6, 2, 3, 7};
+    FAIL(status == false || !linked_list_matches(b, expected_5, 7) ||
+         !linked_list_matches(rest, NULL, 0),
+         "linked_list_splice() to the ends produced the wrong lists")
+
+    SUBTEST(splice_out_of_bounds)
+    FAIL(linked_list_splice(rest, 0, b, 6, 2) != false,
+         "linked_list_splice() accepted a range past the end")
+    FAIL(linked_list_splice(rest, 1, b, 0, 1) != false,
+         "linked_list_splice() accepted an out of bounds index")
+    FAIL(!linked_list_matches(b, expected_5, 7),
+         "linked_list_splice() modified the list on failure")
+
+    linked_list_delete(a);
+    linked_list_delete(b);
+    linked_list_delete(rest);
+    PASS(check_linked_list_splice_functionality)
+#endif
+}
+
+void check_linked_list_sort_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_sort_functionality)
+
+    // Pseudo-random values with plenty of duplicates and some large keys,
+    // sorted by both algorithms and compared against a reference.
+    //
+    enum { SORT_TEST_SIZE = 1000 };
+    unsigned int vals[SORT_TEST_SIZE];
+    unsigned int expected[SORT_TEST_SIZE];
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < SORT_TEST_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        vals[i] = (i % 3) ? (seed % 100) : seed;
+    }
+    memcpy(expected, vals, sizeof(vals));
+    for (size_t i = 1; i < SORT_TEST_SIZE; i++) {
+        unsigned int key = expected[i];
+        size_t j = i;
+        while (j > 0 && expected[j - 1] > key) {
+            expected[j] = expected[j - 1];
+            --j;
+        }
+        expected[j] = key;
+    }
+
+    SUBTEST(merge_sort)
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, SORT_TEST_SIZE);
+    bool status = linked_list_sort(ll);
+    FAIL(status == false || !linked_list_matches(ll, expected, SORT_TEST_SIZE),
+         "linked_list_sort() produced the wrong list")
+    linked_list_delete(ll);
+
+    SUBTEST(radix_sort)
+    ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, SORT_TEST_SIZE);
+    status = linked_list_radix_sort(ll);
+    FAIL(status == false || !linked_list_matches(ll, expected, SORT_TEST_SIZE),
+         "linked_list_radix_sort() produced the wrong list")
+
+    SUBTEST(sort_trivial_lists)
+    linked_list_remove_range(ll, 1, SORT_TEST_SIZE - 1);
+    FAIL(!linked_list_sort(ll) || !linked_list_radix_sort(ll) ||
+         !linked_list_matches(ll, expected, 1),
+         "Sorting a single element list changed it")
+    linked_list_remove(ll, 0);
+    FAIL(!linked_list_sort(ll) || !linked_list_radix_sort(ll) ||
+         !linked_list_matches(ll, NULL, 0),
+         "Sorting an empty list failed")
+    FAIL(linked_list_sort(NULL) != false || linked_list_radix_sort(NULL) != false,
+         "Sorting a NULL list did not return false")
+
+    linked_list_delete(ll);
+    PASS(check_linked_list_sort_functionality)
+#endif
+}
+
+bool is_odd_value(unsigned int data, void * ctx) {
+    (void) ctx;
+    return (data & 1) != 0;
+}
+
+void check_linked_list_compact_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_compact_functionality)
+
+    // Build a list from a mix of single and bulk inserts, with removals in
+    // between, so its nodes come from several places.
+    //
+    const unsigned int vals[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end(ll, 9);
+    linked_list_insert_end_bulk(ll, vals, 8);
+    linked_list_insert_front(ll, 0);
+    linked_list_remove(ll, 1);
+    linked_list_remove_range(ll, 3, 2);
+    linked_list_insert(ll, 3, 10);
+    const unsigned int expected[] = {0, 1, 2, 10, 5, 6, 7, 8};
+
+    SUBTEST(compact_whole_list)
+    bool status = linked_list_compact(ll);
+    FAIL(status == false || !linked_list_matches(ll, expected, 8),
+         "linked_list_compact() changed the contents of the list")
+    struct node * current = ll->head;
+    for (size_t i = 1; i < 8; i++) {
+        FAIL(current->next != current + 1,
+             "linked_list_compact() did not lay the nodes out contiguously")
+        current = current->next;
+    }
+
+    SUBTEST(compact_in_several_blocks)
+    // With 4 nodes per block the 8 nodes take two blocks, each contiguous.
+    //
+    FAIL(linked_list_set_compact_block_nodes((size_t) 1 << 25) != false ||
+         !linked_list_set_compact_block_nodes(4),
+         "linked_list_set_compact_block_nodes() got the limits wrong")
+    struct node * before[8];
+    current = ll->head;
+    for (size_t i = 0; i < 8; i++) {
+        before[i] = current;
+        current = current->next;
+    }
+    status = linked_list_compact(ll);
+    linked_list_set_compact_block_nodes(0);
+    FAIL(status == false || !linked_list_matches(ll, expected, 8),
+         "linked_list_compact() in several blocks changed the list")
+    current = ll->head;
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t j = 0; j < 8; j++) {
+            FAIL(current == before[j],
+                 "linked_list_compact() stopped before the last block")
+        }
+        FAIL(i != 3 && i != 7 && current->next != current + 1,
+             "linked_list_compact() did not lay out each block contiguously")
+        current = current->next;
+    }
+
+    SUBTEST(compact_incrementally)
+    // Three nodes per step, with an insert at the front between steps.
+    //
+    struct iterator iter;
+    linked_list_iterator_init(&iter, ll, 0);
+    status = linked_list_compact_step(&iter, 3);
+    FAIL(status == false || iter.current_index != 3 || iter.data != 10,
+         "linked_list_compact_step() left the iterator in the wrong place")
+    linked_list_insert_front(ll, 11);
+    size_t steps = 1;
+    while (iter.current_node != LINKED_LIST_NO_NODE) {
+        status = linked_list_compact_step(&iter, 3);
+        FAIL(status == false,
+             "linked_list_compact_step() failed")
+        ++steps;
+    }
+    const unsigned int expected_2[] = {11, 0, 1, 2, 10, 5, 6, 7, 8};
+    FAIL(steps != 3 || !linked_list_matches(ll, expected_2, 9),
+         "Incremental compaction changed the contents of the list")
+
+    SUBTEST(compact_empty_list)
+    linked_list_remove_range(ll, 0, 9);
+    FAIL(linked_list_compact(ll) == false || !linked_list_matches(ll, NULL, 0),
+         "linked_list_compact() failed on an empty list")
+
+    linked_list_delete(ll);
+
+    SUBTEST(compact_releases_old_blocks)
+    // Spread a list over blocks shared with another list and thin them
+    // out. Once compacted and the other list is gone, all that should be
+    // left is the list and its one new block.
+    //
+    linked_list_register_malloc(&pool_test_malloc);
+    linked_list_register_free(&pool_test_free);
+    unsigned int many[100];
+    for (unsigned int i = 0; i < 100; i++) {
+        many[i] = i;
+    }
+    size_t outstanding = pool_test_allocs - pool_test_frees;
+    size_t allocs = pool_test_allocs;
+    ll = linked_list_create();
+    struct linked_list * other = linked_list_create();
+    linked_list_insert_end_bulk(ll, many, 100);
+    linked_list_insert_end_bulk(other, many, 100);
+    linked_list_insert_end_bulk(ll, many, 100);
+    FAIL(pool_test_allocs - allocs != 5,
+         "Bulk inserts reused pool nodes nothing should have left spare")
+    linked_list_remove_if(ll, is_odd_value, NULL);
+    status = linked_list_compact(ll);
+    linked_list_delete(other);
+    FAIL(status == false || linked_list_size(ll) != 100,
+         "linked_list_compact() failed on a thinned out list")
+    FAIL(pool_test_allocs - pool_test_frees != outstanding + 2,
+         "linked_list_compact() left the old blocks allocated")
+    linked_list_delete(ll);
+    linked_list_register_malloc(&instrumented_malloc);
+    linked_list_register_free(&instrumented_free);
+
+    PASS(check_linked_list_compact_functionality)
+#endif
+}
+
+// Each worker inserts its own stripe of values, then removes every other
+// one, while the other workers do the same.
+//
+#define CONCURRENT_TEST_THREADS  (4)
+#define CONCURRENT_TEST_VALUES   (2000)
+
+struct concurrent_test_worker {
+    pthread_t thread;
+    struct concurrent_list * list;
+    unsigned int id;
+    bool ok;
+};
+
+void * concurrent_test_worker_run(void * arg) {
+    struct concurrent_test_worker * worker = arg;
+    struct epoch_thread * thread = concurrent_list_register_thread(worker->list);
+    worker->ok = (thread != NULL);
+    for (unsigned int i = 0; worker->ok && i < CONCURRENT_TEST_VALUES; i++) {
+        worker->ok = concurrent_list_insert(worker->list, thread, i * CONCURRENT_TEST_THREADS + worker->id);
+    }
+    for (unsigned int i = 0; worker->ok && i < CONCURRENT_TEST_VALUES; i += 2) {
+        worker->ok = concurrent_list_remove(worker->list, thread, i * CONCURRENT_TEST_THREADS + worker->id);
+    }
+    concurrent_list_unregister_thread(thread);
+    return NULL;
+}
+
+void check_concurrent_list_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_concurrent_list_functionality)
+
+    // The slab allocator isn't thread safe.
+    //
+    concurrent_list_register_malloc(malloc);
+    concurrent_list_register_free(free);
+    struct concurrent_list * list = concurrent_list_create();
+    struct epoch_thread * thread = concurrent_list_register_thread(list);
+    FAIL(list == NULL || thread == NULL,
+         "Failed to create and register with a concurrent_list")
+
+    SUBTEST(concurrent_list_single_thread)
+    const unsigned int vals[] = {5, 1, 9, 3, 7};
+    for (size_t i = 0; i < 5; i++) {
+        FAIL(!concurrent_list_insert(list, thread, vals[i]),
+             "concurrent_list_insert() failed")
+    }
+    FAIL(concurrent_list_insert(list, thread, 3) != false,
+         "concurrent_list_insert() accepted a duplicate")
+    FAIL(concurrent_list_size(list) != 5 || !concurrent_list_find(list, thread, 7) ||
+         concurrent_list_find(list, thread, 4),
+         "concurrent_list_find() or concurrent_list_size() is wrong after inserts")
+    FAIL(!concurrent_list_remove(list, thread, 1) || !concurrent_list_remove(list, thread, 9) ||
+         concurrent_list_remove(list, thread, 9),
+         "concurrent_list_remove() returned the wrong status")
+    FAIL(concurrent_list_size(list) != 3 || concurrent_list_find(list, thread, 1) ||
+         !concurrent_list_find(list, thread, 5),
+         "concurrent_list_find() or concurrent_list_size() is wrong after removes")
+    for (size_t i = 0; i < 5; i++) {
+        concurrent_list_remove(list, thread, vals[i]);
+    }
+    FAIL(concurrent_list_size(list) != 0,
+         "concurrent_list is not empty after removing everything")
+
+    SUBTEST(concurrent_list_retire_ring_full)
+    // Fill the retire ring, so the remove can't retire its node inside the
+    // critical section. The node must still be retired, not leaked.
+    //
+    concurrent_list_insert(list, thread, 4);
+    while (thread->retired_count < EPOCH_RETIRE_CAPACITY) {
+        epoch_retire(thread, malloc(1));
+    }
+    FAIL(!concurrent_list_remove(list, thread, 4) || concurrent_list_size(list) != 0,
+         "concurrent_list_remove() failed with a full retire ring")
+    FAIL(thread->retired_count > EPOCH_RETIRE_CAPACITY / 2,
+         "The retire ring wasn't drained after a remove found it full")
+
+    SUBTEST(concurrent_list_multiple_threads)
+    struct concurrent_test_worker workers[CONCURRENT_TEST_THREADS];
+    for (unsigned int i = 0; i < CONCURRENT_TEST_THREADS; i++) {
+        workers[i].list = list;
+        workers[i].id = i;
+        pthread_create(&workers[i].thread, NULL, concurrent_test_worker_run, &workers[i]);
+    }
+    for (unsigned int i = 0; i < CONCURRENT_TEST_THREADS; i++) {
+        pthread_join(workers[i].thread, NULL);
+        FAIL(!workers[i].ok,
+             "A concurrent_list worker thread failed an insert or remove")
+    }
+    FAIL(concurrent_list_size(list) != CONCURRENT_TEST_THREADS * CONCURRENT_TEST_VALUES / 2,
+         "concurrent_list has the wrong size after concurrent updates")
+    for (unsigned int i = 0; i < CONCURRENT_TEST_THREADS * CONCURRENT_TEST_VALUES; i++) {
+        FAIL(concurrent_list_find(list, thread, i) != ((i / CONCURRENT_TEST_THREADS) % 2 == 1),
+             "concurrent_list has the wrong contents after concurrent updates")
+    }
+
+    concurrent_list_unregister_thread(thread);
+    FAIL(concurrent_list_delete(list) == false,
+         "concurrent_list_delete() failed")
+    PASS(check_concurrent_list_functionality)
+#endif
+}
+
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+// Readers walk the list while a writer appends increasing values at the
+// tail and removes them from the head, so every walk must see strictly
+// increasing values.
+//
+#define RCU_TEST_READERS  (2)
+#define RCU_TEST_UPDATES  (20000)
+
+struct rcu_test_reader {
+    pthread_t thread;
+    struct linked_list * ll;
+    atomic_bool * done;
+    bool ok;
+};
+
+void * rcu_test_reader_run(void * arg) {
+    struct rcu_test_reader * reader = arg;
+    struct epoch_thread * handle = linked_list_rcu_register_reader(reader->ll);
+    reader->ok = (handle != NULL);
+    while (reader->ok && !*reader->done) {
+        linked_list_rcu_read_lock(handle);
+        struct iterator iter;
+        if (linked_list_iterator_init(&iter, reader->ll, 0)) {
+            unsigned int last = iter.data;
+            while (linked_list_iterate(&iter)) {
+                reader->ok = reader->ok && (iter.data > last);
+                last = iter.data;
+            }
+        }
+        linked_list_rcu_read_unlock(handle);
+    }
+    linked_list_rcu_unregister_reader(handle);
+    return NULL;
+}
+#endif
+
+void check_linked_list_rcu_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_rcu_functionality)
+
+    const unsigned int vals[] = {1, 2, 3, 4};
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, 4);
+    FAIL(!linked_list_rcu_enable(ll) || !linked_list_rcu_enable(ll),
+         "linked_list_rcu_enable() failed")
+    struct epoch_thread * reader = linked_list_rcu_register_reader(ll);
+    FAIL(reader == NULL,
+         "linked_list_rcu_register_reader() failed")
+
+    SUBTEST(rcu_reader_survives_removal)
+    // The reader sits on the head while the writer removes it and the node
+    // after it; the reader still walks through both.
+    //
+    struct iterator iter;
+    linked_list_rcu_read_lock(reader);
+    linked_list_iterator_init(&iter, ll, 0);
+    FAIL(!linked_list_remove(ll, 0) || !linked_list_remove_range(ll, 0, 1),
+         "Removing from a read-mostly list failed")
+    linked_list_insert_end(ll, 5);
+    FAIL(!linked_list_iterate(&iter) || iter.data != 2 ||
+         !linked_list_iterate(&iter) || iter.data != 3,
+         "A reader could not walk through removed nodes")
+    linked_list_rcu_read_unlock(reader);
+    const unsigned int expected[] = {3, 4, 5};
+    FAIL(!linked_list_rcu_synchronize(ll) || !linked_list_matches(ll, expected, 3),
+         "Read-mostly list has the wrong contents")
+
+    SUBTEST(rcu_refuses_relinking)
+    struct linked_list * other = linked_list_create();
+    FAIL(linked_list_sort(ll) != false || linked_list_compact(ll) != false ||
+         linked_list_concat(other, ll) != false || linked_list_split(ll, 1) != NULL,
+         "A read-mostly list accepted a relinking operation")
+    linked_list_delete(other);
+
+    SUBTEST(rcu_concurrent_readers)
+    atomic_bool done = false;
+    struct rcu_test_reader readers[RCU_TEST_READERS];
+    for (size_t i = 0; i < RCU_TEST_READERS; i++) {
+        readers[i].ll = ll;
+        readers[i].done = &done;
+        pthread_create(&readers[i].thread, NULL, rcu_test_reader_run, &readers[i]);
+    }
+    for (unsigned int i = 0; i < RCU_TEST_UPDATES; i++) {
+        linked_list_insert_end(ll, 6 + i);
+        if (linked_list_size(ll) > 64) {
+            linked_list_remove(ll, 0);
+        }
+    }
+    done = true;
+    for (size_t i = 0; i < RCU_TEST_READERS; i++) {
+        pthread_join(readers[i].thread, NULL);
+        FAIL(!readers[i].ok,
+             "A reader saw values out of order during concurrent updates")
+    }
+
+    linked_list_rcu_unregister_reader(reader);
+    FAIL(linked_list_delete(ll) == false,
+         "Deleting a read-mostly list failed")
+    PASS(check_linked_list_rcu_functionality)
+#endif
+}
+
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+// Checks the parallel scans against a serial walk of the list.
+//
+bool linked_list_parallel_matches_serial(struct linked_list * ll, const unsigned int * probes, size_t n) {
+    uint64_t sum = 0;
+    uint64_t parallel_sum = 0;
+    struct iterator iter;
+    if (linked_list_iterator_init(&iter, ll, 0)) {
+        do {
+            sum += iter.data;
+        } while (linked_list_iterate(&iter));
+    }
+    if (!linked_list_parallel_sum(ll, &parallel_sum) || parallel_sum != sum) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t count = 0;
+        if (linked_list_iterator_init(&iter, ll, 0)) {
+            do {
+                count += (iter.data == probes[i]);
+            } while (linked_list_iterate(&iter));
+        }
+        if (linked_list_parallel_find(ll, probes[i]) != linked_list_find(ll, probes[i]) ||
+                linked_list_parallel_count(ll, probes[i]) != count) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+void check_linked_list_parallel_functionality(void) {
+#if defined(TEST_LINKED_LIST) && !defined(LINKED_LIST_INDEX_LAYOUT)
+    TEST(check_linked_list_parallel_functionality)
+
+    // Values equal to their index, so every segment boundary is easy to hit.
+    //
+    const size_t n = LINKED_LIST_PARALLEL_MIN_NODES + 1000;
+    unsigned int * vals = malloc(n * sizeof(unsigned int));
+    for (size_t i = 0; i < n; i++) {
+        vals[i] = (unsigned int) i;
+    }
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, n);
+    linked_list_set_parallel_workers(4);
+
+    SUBTEST(parallel_scan_fresh_list)
+    const unsigned int probes[] = {0, 1, LINKED_LIST_SEGMENT_NODES - 1, LINKED_LIST_SEGMENT_NODES,
+                                   3 * LINKED_LIST_SEGMENT_NODES + 7, (unsigned int) n - 1,
+                                   (unsigned int) n, 0xdeadbeef};
+    const size_t probe_count = sizeof(probes) / sizeof(probes[0]);
+    FAIL(linked_list_parallel_find(ll, 3 * LINKED_LIST_SEGMENT_NODES + 7) != 3 * LINKED_LIST_SEGMENT_NODES + 7 ||
+         linked_list_parallel_find(ll, 0xdeadbeef) != SIZE_MAX,
+         "linked_list_parallel_find() returned the wrong index")
+    FAIL(!linked_list_parallel_matches_serial(ll, probes, probe_count),
+         "Parallel scans disagree with a serial walk")
+
+    SUBTEST(parallel_scan_after_updates)
+    // Updates at the head, on and around markers, across segments and at
+    // the tail, with duplicates so find has to pick the smallest index.
+    //
+    linked_list_insert_front(ll, 0xdeadbeef);
+    linked_list_insert(ll, 2 * LINKED_LIST_SEGMENT_NODES, LINKED_LIST_SEGMENT_NODES);
+    linked_list_remove(ll, LINKED_LIST_SEGMENT_NODES + 1);
+    linked_list_remove(ll, 0);
+    linked_list_remove_range(ll, 5 * LINKED_LIST_SEGMENT_NODES - 10, LINKED_LIST_SEGMENT_NODES + 20);
+    linked_list_insert_front_bulk(ll, vals, 10);
+    linked_list_insert_end_bulk(ll, vals, LINKED_LIST_SEGMENT_NODES * 2);
+    struct iterator iter;
+    linked_list_iterator_init(&iter, ll, 7 * LINKED_LIST_SEGMENT_NODES);
+    linked_list_remove_at(&iter);
+    linked_list_insert_before(&iter, 3 * LINKED_LIST_SEGMENT_NODES + 7);
+    linked_list_insert_end(ll, (unsigned int) n);
+    FAIL(!linked_list_parallel_matches_serial(ll, probes, probe_count),
+         "Parallel scans disagree with a serial walk after updates")
+
+    SUBTEST(parallel_scan_after_relinking)
+    linked_list_sort(ll);
+    FAIL(!linked_list_parallel_matches_serial(ll, probes, probe_count),
+         "Parallel scans disagree with a serial walk after sorting")
+
+    SUBTEST(parallel_scan_single_thread)
+    linked_list_set_parallel_workers(0);
+    linked_list_remove_range(ll, 0, LINKED_LIST_SEGMENT_NODES);
+    FAIL(!linked_list_parallel_matches_serial(ll, probes, probe_count),
+         "Parallel scans disagree with a serial walk without pool threads")
+    FAIL(linked_list_parallel_count(NULL, 0) != SIZE_MAX ||
+         linked_list_parallel_sum(ll, NULL) != false ||
+         linked_list_set_parallel_workers(LINKED_LIST_MAX_WORKERS + 1) != false,
+         "Parallel scans accepted bad arguments")
+
+    free(vals);
+    linked_list_delete(ll);
+    PASS(check_linked_list_parallel_functionality)
+#endif
+}
+
+// Allocator context that counts what goes through it.
+//
+struct counting_arena {
+    size_t allocs;
+    size_t frees;
+    size_t fail_at;  // Number of the allocation to fail, 0 for none
+};
+
+void * counting_malloc(void * ctx, size_t size) {
+    struct counting_arena * arena = (struct counting_arena *) ctx;
+    if (arena->fail_at != 0 && arena->allocs + 1 == arena->fail_at) {
+        arena->fail_at = 0;
+        return NULL;
+    }
+    arena->allocs++;
+    return malloc(size);
+}
+
+void counting_free(void * ctx, void * addr) {
+    ((struct counting_arena *) ctx)->frees++;
+    free(addr);
+}
+
+const struct ll_allocator counting_allocator = {
+    .malloc = counting_malloc,
+    .free   = counting_free,
+};
+
+size_t registered_queue_mallocs = 0;
+void * counting_queue_malloc(size_t size) {
+    registered_queue_mallocs++;
+    return instrumented_malloc(size);
+}
+
+void check_allocator_functionality(void) {
+    TEST(check_allocator_functionality)
+
+    SUBTEST(linked_list_create_with_allocator)
+    struct counting_arena arena = {0, 0, 0};
+    struct linked_list * ll = linked_list_create_with_allocator(&counting_allocator, &arena);
+    FAIL(ll == NULL || arena.allocs != 1,
+         "linked_list_create_with_allocator() did not allocate from its allocator")
+    const unsigned int vals[] = {1, 2, 3, 4};
+    linked_list_insert_end(ll, 0);
+    linked_list_insert_end_bulk(ll, vals, 4);
+    linked_list_remove(ll, 2);
+    const unsigned int expected[] = {0, 1, 3, 4};
+    FAIL(!linked_list_matches(ll, expected, 4),
+         "A list on its own allocator has the wrong contents")
+    for (unsigned int i = 0; i < LINKED_LIST_INLINE_NODES; i++) {
+        linked_list_insert_end(ll, 5 + i);
+    }
+    FAIL(arena.allocs < 2,
+         "A list on its own allocator did not allocate its nodes from it")
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    struct linked_list * other = linked_list_create();
+    FAIL(linked_list_concat(other, ll) != false || linked_list_splice(ll, 0, other, 0, 0) != false,
+         "Nodes moved between lists with different allocators")
+    linked_list_delete(other);
+#endif
+    linked_list_delete(ll);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a list did not return everything to its allocator")
+
+#ifdef TEST_QUEUE
+    SUBTEST(queue_create_with_allocator)
+    struct counting_arena queue_arena = {0, 0, 0};
+    struct queue * queue = queue_create_with_allocator(&counting_allocator, &queue_arena);
+    unsigned int popped = 0;
+    FAIL(queue == NULL || !queue_push(queue, 7) || !queue_pop(queue, &popped) || popped != 7,
+         "A queue on its own allocator does not work")
+    for (unsigned int i = 0; i <= QUEUE_INITIAL_CAPACITY; i++) {
+        queue_push(queue, i);
+    }
+    FAIL(queue_arena.allocs < 3,
+         "A queue on its own allocator did not use it for its buffer")
+    queue_delete(queue);
+    FAIL(queue_arena.allocs != queue_arena.frees,
+         "Deleting a queue did not return everything to its allocator")
+
+    SUBTEST(queue_register_malloc_leaves_lists_alone)
+    queue_register_malloc(&counting_queue_malloc);
+    ll = linked_list_create();
+    linked_list_insert_end(ll, 1);
+    FAIL(registered_queue_mallocs != 0,
+         "queue_register_malloc() changed the allocator of a linked_list")
+    linked_list_delete(ll);
+    queue = queue_create();
+    for (unsigned int i = 0; i <= QUEUE_INITIAL_CAPACITY; i++) {
+        queue_push(queue, i);
+    }
+    FAIL(registered_queue_mallocs < 3,
+         "queue_create() did not use the registered queue allocator")
+    queue_delete(queue);
+    queue_register_malloc(&instrumented_malloc);
+#endif
+
+    PASS(check_allocator_functionality)
+}
+
+void check_linked_list_clear_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_clear_functionality)
+
+    SUBTEST(linked_list_clear_retain_nodes)
+    struct counting_arena arena = {0, 0, 0};
+    struct linked_list * ll = linked_list_create_with_allocator(&counting_allocator, &arena);
+    unsigned int vals[64];
+    for (unsigned int i = 0; i < 64; i++) {
+        vals[i] = i;
+    }
+    linked_list_insert_end_bulk(ll, vals, 64);
+    FAIL(!linked_list_clear(ll, true) || linked_list_size(ll) != 0 ||
+         linked_list_find(ll, 0) != SIZE_MAX,
+         "linked_list_clear() did not empty the list")
+    size_t allocs = arena.allocs;
+    linked_list_insert_end_bulk(ll, vals, 32);
+    for (unsigned int i = 32; i < 64; i++) {
+        linked_list_insert_front(ll, i);
+    }
+    FAIL(arena.allocs != allocs || linked_list_size(ll) != 64,
+         "Inserting after linked_list_clear() did not reuse the retained nodes")
+    linked_list_insert_end(ll, 64);
+    FAIL(arena.allocs == allocs || linked_list_size(ll) != 65,
+         "Inserting past the retained nodes did not allocate")
+
+    SUBTEST(linked_list_clear_release_nodes)
+    linked_list_clear(ll, true);
+    linked_list_insert_end(ll, 1);
+    FAIL(!linked_list_clear(ll, false) || linked_list_size(ll) != 0,
+         "linked_list_clear() without retaining did not empty the list")
+    FAIL(arena.allocs - arena.frees > 2,
+         "linked_list_clear() without retaining kept nodes")
+    linked_list_insert_end(ll, 5);
+    FAIL(linked_list_find(ll, 5) != 0 || linked_list_clear(NULL, true) != false,
+         "A cleared list is not usable")
+    linked_list_clear(ll, true);
+    linked_list_delete(ll);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a cleared list did not release its retained nodes")
+
+    SUBTEST(linked_list_clear_registered_allocator)
+    ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, 64);
+    linked_list_clear(ll, true);
+    instrumented_malloc_fail_next = true;
+    FAIL(!linked_list_insert_end(ll, 1),
+         "Inserting after linked_list_clear() allocated")
+    instrumented_malloc_fail_next = false;
+    linked_list_delete(ll);
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    SUBTEST(linked_list_clear_read_mostly)
+    ll = linked_list_create();
+    linked_list_rcu_enable(ll);
+    linked_list_insert_end_bulk(ll, vals, 64);
+    FAIL(!linked_list_clear(ll, true) || linked_list_size(ll) != 0 || ll->spare != NULL,
+         "A read-mostly list kept nodes readers may still be on")
+    linked_list_insert_end(ll, 3);
+    FAIL(linked_list_find(ll, 3) != 0,
+         "A cleared read-mostly list is not usable")
+    linked_list_delete(ll);
+#endif
+
+    PASS(check_linked_list_clear_functionality)
+#endif
+}
+
+// Predicates for linked_list_remove_if() and linked_list_retain_if().
+//
+bool is_multiple_of(unsigned int data, void * ctx) {
+    return data % *(unsigned int *) ctx == 0;
+}
+
+bool count_calls(unsigned int data, void * ctx) {
+    (void) data;
+    ++*(size_t *) ctx;
+    return false;
+}
+
+void check_linked_list_remove_if_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_remove_if_functionality)
+
+    SUBTEST(linked_list_remove_if)
+    struct linked_list * ll = linked_list_create();
+    for (unsigned int i = 0; i < 12; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    unsigned int three = 3;
+    FAIL(linked_list_remove_if(ll, is_multiple_of, &three) != 4,
+         "linked_list_remove_if() removed the wrong number of nodes")
+    const unsigned int expected_1[] = {1, 2, 4, 5, 7, 8, 10, 11};
+    FAIL(!linked_list_matches(ll, expected_1, 8),
+         "linked_list_remove_if() left the wrong nodes")
+    size_t calls = 0;
+    FAIL(linked_list_remove_if(ll, count_calls, &calls) != 0 || calls != 8,
+         "linked_list_remove_if() did not visit each node once")
+
+    SUBTEST(linked_list_retain_if)
+    unsigned int two = 2;
+    FAIL(linked_list_retain_if(ll, is_multiple_of, &two) != 4,
+         "linked_list_retain_if() removed the wrong number of nodes")
+    const unsigned int expected_2[] = {2, 4, 8, 10};
+    FAIL(!linked_list_matches(ll, expected_2, 4),
+         "linked_list_retain_if() left the wrong nodes")
+    linked_list_insert_front(ll, 1);
+    linked_list_insert_end(ll, 13);
+    const unsigned int expected_3[] = {1, 2, 4, 8, 10, 13};
+    FAIL(!linked_list_matches(ll, expected_3, 6),
+         "Inserting after linked_list_retain_if() failed")
+
+    SUBTEST(linked_list_remove_if_all)
+    unsigned int one = 1;
+    FAIL(linked_list_remove_if(ll, is_multiple_of, &one) != 6 || !linked_list_matches(ll, NULL, 0),
+         "linked_list_remove_if() did not empty the list")
+    FAIL(linked_list_retain_if(ll, is_multiple_of, &one) != 0,
+         "linked_list_retain_if() removed from an empty list")
+    FAIL(linked_list_remove_if(NULL, is_multiple_of, &one) != SIZE_MAX ||
+         linked_list_retain_if(ll, NULL, NULL) != SIZE_MAX,
+         "linked_list_remove_if() accepted bad arguments")
+    linked_list_delete(ll);
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    SUBTEST(remove_if_releases_pool_blocks)
+    // The removed nodes go back to the pool together rather than into the
+    // list's own cache, so a block the call empties is freed straight away.
+    //
+    linked_list_register_malloc(&pool_test_malloc);
+    linked_list_register_free(&pool_test_free);
+    unsigned int vals[200];
+    for (unsigned int i = 0; i < 200; i++) {
+        vals[i] = i;
+    }
+    ll = linked_list_create();
+    size_t outstanding = pool_test_allocs - pool_test_frees;
+    linked_list_insert_end_bulk(ll, vals, 200);
+    FAIL(linked_list_remove_if(ll, is_multiple_of, &one) != 200,
+         "linked_list_remove_if() did not empty a bulk-built list")
+    FAIL(pool_test_allocs - pool_test_frees != outstanding,
+         "linked_list_remove_if() kept an emptied pool block allocated")
+    linked_list_delete(ll);
+    linked_list_register_malloc(&instrumented_malloc);
+    linked_list_register_free(&instrumented_free);
+#endif
+
+    PASS(check_linked_list_remove_if_functionality)
+#endif
+}
+
+void check_linked_list_filter_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_filter_functionality)
+
+    SUBTEST(counting_bloom_false_positive_rate)
+    size_t bytes = counting_bloom_size(1000, 0.01);
+    struct counting_bloom * filter = malloc(bytes);
+    FAIL(bytes == 0 || !counting_bloom_init(filter, 1000, 0.01),
+         "counting_bloom_init() failed")
+    for (unsigned int i = 0; i < 1000; i++) {
+        counting_bloom_add(filter, i * 7919u);
+    }
+    size_t false_positives = 0;
+    for (unsigned int i = 0; i < 1000; i++) {
+        FAIL(!counting_bloom_maybe_contains(filter, i * 7919u),
+             "counting_bloom_maybe_contains() missed a value that was added")
+    }
+    for (unsigned int i = 1; i <= 10000; i++) {
+        false_positives += counting_bloom_maybe_contains(filter, i * 7919u + 1);
+    }
+    FAIL(false_positives > 300,
+         "counting_bloom false positive rate is far above what it was sized for")
+    for (unsigned int i = 0; i < 1000; i++) {
+        counting_bloom_remove(filter, i * 7919u);
+    }
+    FAIL(counting_bloom_maybe_contains(filter, 0),
+         "counting_bloom_remove() left a value behind")
+    FAIL(counting_bloom_size(0, 0.01) != 0 || counting_bloom_size(10, 0.0) != 0 ||
+         counting_bloom_size(10, 1.0) != 0,
+         "counting_bloom_size() accepted bad arguments")
+    free(filter);
+
+    SUBTEST(linked_list_filter_enable)
+    struct linked_list * ll = linked_list_create();
+    const unsigned int vals[] = {10, 20, 30, 40, 20};
+    linked_list_insert_end_bulk(ll, vals, 3);
+    FAIL(linked_list_filter_bytes(ll) != 0 || linked_list_filter_enable(ll, 100, 1.5) != false,
+         "A list without a filter reported one")
+    FAIL(!linked_list_filter_enable(ll, 100, 0.01) || linked_list_filter_bytes(ll) < 100,
+         "linked_list_filter_enable() failed")
+    FAIL(linked_list_find(ll, 20) != 1 || linked_list_find(ll, 25) != SIZE_MAX,
+         "The filter changed what linked_list_find() returns")
+
+    SUBTEST(linked_list_filter_tracks_updates)
+    linked_list_insert_front_bulk(ll, &vals[3], 2);
+    linked_list_insert(ll, 2, 50);
+    linked_list_insert_front(ll, 60);
+    FAIL(linked_list_find(ll, 60) != 0 || linked_list_find(ll, 40) != 1 ||
+         linked_list_find(ll, 50) != 3 || linked_list_find(ll, 30) != 6,
+         "The filter missed inserted values")
+    linked_list_remove(ll, 0);
+    linked_list_remove_range(ll, 0, 2);
+    FAIL(linked_list_find(ll, 60) != SIZE_MAX || linked_list_find(ll, 40) != SIZE_MAX ||
+         linked_list_find(ll, 20) != 2,
+         "Removing one of two equal values hid the other")
+    unsigned int ten = 10;
+    linked_list_remove_if(ll, is_multiple_of, &ten);
+    FAIL(linked_list_find(ll, 20) != SIZE_MAX || linked_list_find(ll, 50) != SIZE_MAX,
+         "The filter kept values removed by linked_list_remove_if()")
+    linked_list_insert_end(ll, 70);
+    linked_list_clear(ll, true);
+    FAIL(linked_list_find(ll, 70) != SIZE_MAX,
+         "The filter kept values of a cleared list")
+    linked_list_insert_end(ll, 70);
+    FAIL(linked_list_find(ll, 70) != 0,
+         "The filter missed a value inserted after linked_list_clear()")
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    SUBTEST(linked_list_filter_moves)
+    struct linked_list * other = linked_list_create();
+    linked_list_insert_end_bulk(other, vals, 4);
+    linked_list_filter_enable(other, 100, 0.01);
+    linked_list_concat(ll, other);
+    FAIL(linked_list_find(ll, 40) != 4 || linked_list_find(other, 40) != SIZE_MAX,
+         "The filter did not follow linked_list_concat()")
+    linked_list_splice(other, 0, ll, 1, 2);
+    FAIL(linked_list_find(other, 20) != 1 || linked_list_find(ll, 20) != SIZE_MAX,
+         "The filter did not follow linked_list_splice()")
+    struct linked_list * rest = linked_list_split(other, 1);
+    FAIL(linked_list_find(other, 20) != SIZE_MAX || linked_list_find(rest, 20) != 0,
+         "The filter did not follow linked_list_split()")
+    linked_list_delete(rest);
+    linked_list_delete(other);
+#endif
+
+    FAIL(!linked_list_filter_disable(ll) || linked_list_filter_bytes(ll) != 0 ||
+         linked_list_find(ll, 70) != 0,
+         "linked_list_filter_disable() failed")
+    linked_list_filter_enable(ll, 10, 0.1);
+    linked_list_delete(ll);
+
+    PASS(check_linked_list_filter_functionality)
+#endif
+}
+
+void check_linked_list_inline_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_inline_functionality)
+
+    SUBTEST(linked_list_inline_single_allocation)
+    struct counting_arena arena = {0, 0, 0};
+    struct linked_list * ll = linked_list_create_with_allocator(&counting_allocator, &arena);
+    unsigned int vals[LINKED_LIST_INLINE_NODES + 1];
+    for (unsigned int i = 0; i <= LINKED_LIST_INLINE_NODES; i++) {
+        vals[i] = i;
+    }
+    linked_list_insert_end_bulk(ll, vals, LINKED_LIST_INLINE_NODES - 2);
+    linked_list_insert_front(ll, LINKED_LIST_INLINE_NODES - 2);
+    linked_list_insert(ll, 1, LINKED_LIST_INLINE_NODES - 1);
+    FAIL(arena.allocs != 1 || linked_list_size(ll) != LINKED_LIST_INLINE_NODES,
+         "A small list allocated more than its struct")
+    linked_list_remove(ll, 0);
+    linked_list_remove(ll, 0);
+    linked_list_insert_end(ll, 100);
+    linked_list_insert_front(ll, 101);
+    FAIL(arena.allocs != 1,
+         "A small list did not reuse its inline nodes")
+    linked_list_insert_end(ll, 102);
+    FAIL(arena.allocs != 2 || linked_list_find(ll, 102) != LINKED_LIST_INLINE_NODES ||
+         linked_list_find(ll, 101) != 0,
+         "A list did not grow past its inline nodes")
+    linked_list_delete(ll);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a small list did not release everything")
+
+#ifndef LINKED_LIST_INDEX_LAYOUT
+    SUBTEST(linked_list_inline_nodes_move)
+    ll = linked_list_create();
+    struct linked_list * other = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, 4);
+    linked_list_insert_end_bulk(other, vals, 4);
+    FAIL(!linked_list_concat(other, ll),
+         "linked_list_concat() of a small list failed")
+    linked_list_delete(ll);
+    const unsigned int expected_1[] = {0, 1, 2, 3, 0, 1, 2, 3};
+    FAIL(!linked_list_matches(other, expected_1, 8),
+         "Nodes concatenated from a deleted list are broken")
+
+    ll = linked_list_create();
+    linked_list_insert_end_bulk(ll, &vals[4], 3);
+    FAIL(!linked_list_splice(other, 2, ll, 1, 2),
+         "linked_list_splice() of a small list failed")
+    struct linked_list * rest = linked_list_split(ll, 0);
+    linked_list_delete(ll);
+    const unsigned int expected_2[] = {0, 1, 5, 6, 2, 3, 0, 1, 2, 3};
+    const unsigned int expected_3[] = {4};
+    FAIL(!linked_list_matches(other, expected_2, 10) || !linked_list_matches(rest, expected_3, 1),
+         "Nodes spliced or split from a deleted list are broken")
+    linked_list_delete(rest);
+
+    SUBTEST(linked_list_inline_move_fails_cleanly)
+    // The second copy of an inline node fails. Neither list may change,
+    // and the first copy must not have replaced its inline node.
+    //
+    arena = (struct counting_arena) {0, 0, 0};
+    ll = linked_list_create_with_allocator(&counting_allocator, &arena);
+    rest = linked_list_create_with_allocator(&counting_allocator, &arena);
+    linked_list_insert_end_bulk(ll, vals, 4);
+    linked_list_insert_end_bulk(rest, vals, 2);
+    arena.fail_at = arena.allocs + 2;
+    FAIL(linked_list_splice(rest, 1, ll, 0, 4),
+         "linked_list_splice() succeeded without memory for its inline nodes")
+    FAIL(!linked_list_matches(ll, vals, 4) || !linked_list_matches(rest, vals, 2) ||
+         ll->head != &ll->inline_nodes[0] || arena.allocs != arena.frees + 2,
+         "A failed linked_list_splice() changed a list")
+    arena.fail_at = arena.allocs + 2;
+    FAIL(linked_list_concat(rest, ll),
+         "linked_list_concat() succeeded without memory for its inline nodes")
+    FAIL(!linked_list_matches(ll, vals, 4) || !linked_list_matches(rest, vals, 2) ||
+         ll->head != &ll->inline_nodes[0] || arena.allocs != arena.frees + 2,
+         "A failed linked_list_concat() changed a list")
+    const unsigned int expected_4[] = {0, 1, 0, 1, 2, 3};
+    FAIL(!linked_list_concat(rest, ll) || !linked_list_matches(rest, expected_4, 6),
+         "linked_list_concat() failed once memory was available")
+    linked_list_delete(ll);
+    linked_list_delete(rest);
+    FAIL(arena.allocs != arena.frees,
+         "Moving inline nodes leaked memory")
+
+    SUBTEST(linked_list_inline_concat_after_clear)
+    // Two of the inline nodes are back in the list, two are still kept by
+    // linked_list_clear(); only the first two may be copied out.
+    //
+    ll = linked_list_create();
+    rest = linked_list_create();
+    linked_list_insert_end_bulk(ll, vals, 4);
+    linked_list_clear(ll, true);
+    linked_list_insert_end_bulk(ll, &vals[4], 2);
+    FAIL(!linked_list_concat(rest, ll) || !linked_list_matches(rest, &vals[4], 2),
+         "linked_list_concat() of retained inline nodes failed")
+    linked_list_insert_end_bulk(ll, vals, 2);
+    FAIL(!linked_list_matches(ll, vals, 2) || ll->head != &ll->inline_nodes[2],
+         "linked_list_concat() disturbed the nodes kept by linked_list_clear()")
+    linked_list_delete(ll);
+    linked_list_delete(rest);
+
+    SUBTEST(linked_list_inline_compact)
+    linked_list_remove(other, 0);
+    linked_list_insert_front(other, 0);
+    FAIL(!linked_list_compact(other) || !linked_list_matches(other, expected_2, 10),
+         "linked_list_compact() of inline nodes failed")
+    linked_list_insert_end(other, 7);
+    FAIL(linked_list_find(other, 7) != 10,
+         "Inserting after compacting inline nodes failed")
+    linked_list_delete(other);
+#endif
+
+    PASS(check_linked_list_inline_functionality)
+#endif
+}
+
+void check_queue_ring_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_queue_ring_functionality)
+
+    SUBTEST(queue_wraps_around)
+    struct queue * queue = queue_create();
+    unsigned int next_push = 0;
+    unsigned int next_pop = 0;
+    unsigned int data = 0;
+    for (size_t round = 0; round < 4 * QUEUE_INITIAL_CAPACITY; round++) {
+        queue_push(queue, next_push++);
+        queue_push(queue, next_push++);
+        FAIL(!queue_pop(queue, &data) || data != next_pop++,
+             "queue_pop() returned the wrong entry after wrapping")
+    }
+    FAIL(queue_size(queue) != next_push - next_pop,
+         "queue_size() is wrong after wrapping")
+
+    SUBTEST(queue_grows_while_wrapped)
+    for (size_t i = 0; i < QUEUE_INITIAL_CAPACITY / 2; i++) {
+        queue_pop(queue, &data);
+        ++next_pop;
+    }
+    for (size_t i = 0; i < 3 * QUEUE_INITIAL_CAPACITY; i++) {
+        queue_push(queue, next_push++);
+    }
+    FAIL(!queue_next(queue, &data) || data != next_pop,
+         "queue_next() returned the wrong entry after growing")
+    while (queue_pop(queue, &data)) {
+        FAIL(data != next_pop++,
+             "Entries came out of order after growing a wrapped queue")
+    }
+    FAIL(next_pop != next_push || queue_has_next(queue),
+         "Entries were lost growing a wrapped queue")
+    queue_delete(queue);
+
+    PASS(check_queue_ring_functionality)
+#endif
+}
+
+void check_queue_many_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_queue_many_functionality)
+
+    SUBTEST(queue_push_many)
+    size_t count = 3 * QUEUE_INITIAL_CAPACITY + 5;
+    unsigned int * vals = malloc(4 * count * sizeof(unsigned int));
+    unsigned int * out = malloc(count * sizeof(unsigned int));
+    for (size_t i = 0; i < 4 * count; i++) {
+        vals[i] = i;
+    }
+    struct queue * queue = queue_create();
+    unsigned int data = 0;
+    queue_push(queue, 100);
+    queue_push(queue, 101);
+    queue_pop(queue, &data);
+    FAIL(!queue_push_many(queue, vals, count) || queue_size(queue) != count + 1,
+         "queue_push_many() did not push every value")
+    FAIL(!queue_push_many(queue, vals, 0) || queue_push_many(NULL, vals, 1) != false ||
+         queue_push_many(queue, NULL, 1) != false,
+         "queue_push_many() mishandled an empty run or NULL arguments")
+
+    SUBTEST(queue_pop_many)
+    FAIL(queue_pop_many(queue, out, 1) != 1 || out[0] != 101,
+         "queue_pop_many() did not pop the oldest value first")
+    FAIL(queue_pop_many(queue, out, count + 10) != count || queue_size(queue) != 0,
+         "queue_pop_many() did not stop at the end of the queue")
+    bool in_order = true;
+    for (size_t i = 0; i < count; i++) {
+        in_order = in_order && (out[i] == i);
+    }
+    FAIL(!in_order,
+         "Values pushed with queue_push_many() came out of order")
+    FAIL(queue_pop_many(queue, out, 4) != 0 || queue_pop_many(NULL, out, 1) != SIZE_MAX,
+         "queue_pop_many() on an empty or NULL queue is wrong")
+
+    SUBTEST(queue_many_wrapped)
+    for (size_t round = 0; round < 8; round++) {
+        queue_push_many(queue, vals, QUEUE_INITIAL_CAPACITY / 2 + round);
+        queue_pop_many(queue, out, QUEUE_INITIAL_CAPACITY / 2);
+    }
+    size_t left = queue_size(queue);
+    FAIL(queue_pop_many(queue, out, count) != left,
+         "queue_size() disagrees with queue_pop_many() after wrapping")
+    FAIL(out[left - 1] != QUEUE_INITIAL_CAPACITY / 2 + 6,
+         "The last value is wrong after wrapping batches")
+
+    SUBTEST(queue_push_many_alloc_fail)
+    queue_push(queue, 7);
+    instrumented_malloc_fail_next = true;
+    FAIL(queue_push_many(queue, vals, 4 * count) != false,
+         "queue_push_many() did not report a failed allocation")
+    FAIL(queue_size(queue) != 1 || !queue_next(queue, &data) || data != 7,
+         "A failed queue_push_many() changed the queue")
+    queue_delete(queue);
+    free(vals);
+    free(out);
+
+    PASS(check_queue_many_functionality)
+#endif
+}
+
+#ifdef TEST_QUEUE
+// Consumers block in queue_pop_wait() while a producer pushes
+// WAIT_TEST_VALUES values, some singly and some in runs, with pauses so
+// the consumers park in between.
+//
+#define WAIT_TEST_CONSUMERS  (3u)
+#define WAIT_TEST_VALUES     (3000u)
+#define WAIT_TEST_RUN        (10u)
+
+struct wait_test_consumer {
+    pthread_t thread;
+    struct queue * queue;
+    size_t count;
+    unsigned long long sum;
+};
+
+void * wait_test_consumer_run(void * arg) {
+    struct wait_test_consumer * consumer = arg;
+    unsigned int data;
+    consumer->count = 0;
+    consumer->sum = 0;
+    while (queue_pop_wait(consumer->queue, &data, QUEUE_WAIT_FOREVER) && data != UINT_MAX) {
+        ++consumer->count;
+        consumer->sum += data;
+    }
+    return NULL;
+}
+#endif
+
+void check_queue_wait_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_queue_wait_functionality)
+
+    SUBTEST(queue_pop_wait_single_thread)
+    struct queue * queue = queue_create();
+    unsigned int data = 0;
+    FAIL(queue_pop_wait(queue, &data, 1000000000ull) != false,
+         "queue_pop_wait() waited on a queue that is not in blocking mode")
+    FAIL(!queue_blocking_enable(queue) || queue_blocking_enable(NULL) != false,
+         "queue_blocking_enable() failed")
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    FAIL(queue_pop_wait(queue, &data, 2000000) != false,
+         "queue_pop_wait() on an empty queue did not time out")
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    long waited = (stop.tv_sec - start.tv_sec) * 1000000000L + (stop.tv_nsec - start.tv_nsec);
+    FAIL(waited < 2000000,
+         "queue_pop_wait() returned before its timeout")
+    queue_push(queue, 5);
+    FAIL(!queue_pop_wait(queue, &data, 0) || data != 5 || queue_pop_wait(NULL, &data, 0) != false,
+         "queue_pop_wait() did not pop an available value")
+
+    SUBTEST(queue_pop_wait_threads)
+    struct wait_test_consumer consumers[WAIT_TEST_CONSUMERS];
+    for (unsigned int i = 0; i < WAIT_TEST_CONSUMERS; i++) {
+        consumers[i].queue = queue;
+        pthread_create(&consumers[i].thread, NULL, wait_test_consumer_run, &consumers[i]);
+    }
+    unsigned int run[WAIT_TEST_RUN];
+    for (unsigned int next = 0; next < WAIT_TEST_VALUES; ) {
+        if (next % 100 == 0) {
+            usleep(1000);
+        }
+        if (next % 3 == 0 && WAIT_TEST_VALUES - next >= WAIT_TEST_RUN) {
+            for (unsigned int i = 0; i < WAIT_TEST_RUN; i++) {
+                run[i] = next + i;
+            }
+            queue_push_many(queue, run, WAIT_TEST_RUN);
+            next += WAIT_TEST_RUN;
+        } else {
+            queue_push(queue, next++);
+        }
+    }
+    for (unsigned int i = 0; i < WAIT_TEST_CONSUMERS; i++) {
+        queue_push(queue, UINT_MAX);
+    }
+    size_t count = 0;
+    unsigned long long sum = 0;
+    for (unsigned int i = 0; i < WAIT_TEST_CONSUMERS; i++) {
+        pthread_join(consumers[i].thread, NULL);
+        count += consumers[i].count;
+        sum += consumers[i].sum;
+    }
+    FAIL(count != WAIT_TEST_VALUES || sum != (unsigned long long)WAIT_TEST_VALUES * (WAIT_TEST_VALUES - 1) / 2,
+         "Values were lost or duplicated between waiting consumers")
+    FAIL(queue_size(queue) != 0 || queue->waiters != 0,
+         "The queue is not empty and idle after the consumers finished")
+    queue_delete(queue);
+
+    PASS(check_queue_wait_functionality)
+#endif
+}
+
+#ifdef TEST_QUEUE
+// A producer pushes BOUNDED_TEST_VALUES values through a QUEUE_OVERFLOW_BLOCK
+// queue of BOUNDED_TEST_CAPACITY entries, some in runs longer than the
+// capacity, while a consumer checks they arrive in order.
+//
+#define BOUNDED_TEST_CAPACITY  (4u)
+#define BOUNDED_TEST_VALUES    (5000u)
+#define BOUNDED_TEST_RUN       (10u)
+
+struct bounded_test_consumer {
+    struct queue * queue;
+    bool in_order;
+    bool within_capacity;
+};
+
+void * bounded_test_consumer_run(void * arg) {
+    struct bounded_test_consumer * consumer = arg;
+    consumer->in_order = true;
+    consumer->within_capacity = true;
+    for (unsigned int expected = 0; expected < BOUNDED_TEST_VALUES; expected++) {
+        unsigned int data;
+        if (queue_size(consumer->queue) > BOUNDED_TEST_CAPACITY) {
+            consumer->within_capacity = false;
+        }
+        if (!queue_pop_wait(consumer->queue, &data, QUEUE_WAIT_FOREVER) || data != expected) {
+            consumer->in_order = false;
+        }
+    }
+    return NULL;
+}
+
+struct high_water_record {
+    size_t calls;
+    size_t len;
+};
+
+void record_high_water(struct queue * queue, size_t len, void * ctx) {
+    struct high_water_record * record = ctx;
+    ++record->calls;
+    record->len = len;
+    (void)queue_size(queue);
+}
+#endif
+
+void check_queue_bounded_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_queue_bounded_functionality)
+
+    SUBTEST(queue_bounded_fail)
+    FAIL(queue_create_bounded(0, QUEUE_OVERFLOW_FAIL) != NULL ||
+         queue_create_bounded(4, (enum queue_overflow_policy)7) != NULL,
+         "queue_create_bounded() accepted a bad capacity or policy")
+    struct queue * queue = queue_create_bounded(5, QUEUE_OVERFLOW_FAIL);
+    FAIL(queue == NULL,
+         "queue_create_bounded() failed")
+#ifndef QUEUE_CHUNKED_BACKEND
+    // The ring is sized up front, so filling it must not allocate
+    instrumented_malloc_fail_next = true;
+#endif
+    for (unsigned int i = 0; i < 5; i++) {
+        FAIL(!queue_push(queue, i),
+             "queue_push() failed below the bound")
+    }
+    instrumented_malloc_fail_next = false;
+    const unsigned int vals[] = {10, 11, 12, 13, 14, 15};
+    unsigned int data = 0;
+    FAIL(queue_push(queue, 5) != false || queue_size(queue) != 5,
+         "queue_push() went past the bound")
+    FAIL(!queue_pop(queue, &data) || queue_push_many(queue, vals, 2) != false || queue_size(queue) != 4,
+         "queue_push_many() pushed part of a run that does not fit")
+    FAIL(!queue_push_many(queue, vals, 1) || queue_size(queue) != 5,
+         "queue_push_many() failed on a run that fits")
+    queue_delete(queue);
+
+    SUBTEST(queue_bounded_overwrite)
+    queue = queue_create_bounded(4, QUEUE_OVERFLOW_OVERWRITE);
+    for (unsigned int i = 0; i < 6; i++) {
+        FAIL(!queue_push(queue, i),
+             "queue_push() on an overwriting queue failed")
+    }
+    unsigned int out[8];
+    FAIL(queue_pop_many(queue, out, 8) != 4 || out[0] != 2 || out[3] != 5,
+         "Overwriting did not drop the oldest entries")
+    queue_push(queue, 1);
+    queue_push(queue, 2);
+    FAIL(!queue_push_many(queue, vals, 3) || queue_pop_many(queue, out, 8) != 4 ||
+         out[0] != 2 || out[1] != 10 || out[3] != 12,
+         "queue_push_many() did not overwrite the oldest entries")
+    FAIL(!queue_push_many(queue, vals, 6) || queue_pop_many(queue, out, 8) != 4 ||
+         out[0] != 12 || out[3] != 15,
+         "queue_push_many() of more than the bound did not keep the newest")
+    queue_delete(queue);
+
+    SUBTEST(queue_bounded_with_allocator)
+    struct counting_arena arena = {0, 0, 0};
+    queue = queue_create_bounded_with_allocator(4, QUEUE_OVERFLOW_OVERWRITE, &counting_allocator, &arena);
+    FAIL(queue == NULL || arena.allocs == 0,
+         "queue_create_bounded_with_allocator() did not use its allocator")
+    FAIL(!queue_push_many(queue, vals, 6) || queue_pop_many(queue, out, 8) != 4 || out[0] != 12,
+         "A bounded queue on its own allocator does not work")
+    queue_delete(queue);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a bounded queue did not return everything to its allocator")
+
+    SUBTEST(queue_high_water_mark)
+    queue = queue_create();
+    struct high_water_record record = {0, 0};
+    FAIL(queue_set_high_water_mark(queue, 0, record_high_water, &record) != false ||
+         !queue_set_high_water_mark(queue, 3, record_high_water, &record),
+         "queue_set_high_water_mark() failed")
+    queue_push(queue, 1);
+    queue_push(queue, 2);
+    FAIL(record.calls != 0,
+         "The high water callback ran below the mark")
+    queue_push_many(queue, vals, 2);
+    queue_push(queue, 3);
+    FAIL(record.calls != 1 || record.len != 4,
+         "The high water callback did not run exactly once at the mark")
+    queue_pop_many(queue, out, 3);
+    queue_push(queue, 4);
+    FAIL(record.calls != 1,
+         "The high water callback re-armed above half the mark")
+    queue_pop_many(queue, out, 2);
+    queue_push_many(queue, vals, 3);
+    FAIL(record.calls != 2 || record.len != 4,
+         "The high water callback did not re-arm after draining")
+    queue_set_high_water_mark(queue, 1, NULL, NULL);
+    queue_push(queue, 5);
+    FAIL(record.calls != 2,
+         "The high water callback ran after it was removed")
+    queue_delete(queue);
+
+    SUBTEST(queue_bounded_block)
+    queue = queue_create_bounded(BOUNDED_TEST_CAPACITY, QUEUE_OVERFLOW_BLOCK);
+    struct bounded_test_consumer consumer;
+    consumer.queue = queue;
+    pthread_t thread;
+    pthread_create(&thread, NULL, bounded_test_consumer_run, &consumer);
+    unsigned int run[BOUNDED_TEST_RUN];
+    for (unsigned int next = 0; next < BOUNDED_TEST_VALUES; ) {
+        if (next % 2 == 0 && BOUNDED_TEST_VALUES - next >= BOUNDED_TEST_RUN) {
+            for (unsigned int i = 0; i < BOUNDED_TEST_RUN; i++) {
+                run[i] = next + i;
+            }
+            FAIL(!queue_push_many(queue, run, BOUNDED_TEST_RUN),
+                 "queue_push_many() on a blocking queue failed")
+            next += BOUNDED_TEST_RUN;
+        } else {
+            FAIL(!queue_push(queue, next++),
+                 "queue_push() on a blocking queue failed")
+        }
+    }
+    pthread_join(thread, NULL);
+    FAIL(!consumer.in_order || !consumer.within_capacity || queue_size(queue) != 0,
+         "Values went missing, out of order or past the bound")
+    queue_delete(queue);
+
+    PASS(check_queue_bounded_functionality)
+#endif
+}
+
+#define SHRINK_TEST_VALUES  (20000u)
+
+void check_queue_shrink_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_queue_shrink_functionality)
+
+    SUBTEST(queue_shrink_to_fit)
+    struct counting_arena arena = {0, 0, 0};
+    struct queue * queue = queue_create_with_allocator(&counting_allocator, &arena);
+    unsigned int * vals = malloc(SHRINK_TEST_VALUES * sizeof(unsigned int));
+    unsigned int * out = malloc(SHRINK_TEST_VALUES * sizeof(unsigned int));
+    for (unsigned int i = 0; i < SHRINK_TEST_VALUES; i++) {
+        vals[i] = i;
+    }
+    FAIL(queue_shrink_to_fit(NULL) != false || !queue_shrink_to_fit(queue),
+         "queue_shrink_to_fit() failed")
+    queue_push_many(queue, vals, SHRINK_TEST_VALUES);
+    queue_pop_many(queue, out, SHRINK_TEST_VALUES - 3);
+    FAIL(!queue_shrink_to_fit(queue) || arena.allocs - arena.frees != 2,
+         "queue_shrink_to_fit() kept more than one allocation for three entries")
+    FAIL(queue_pop_many(queue, out, 8) != 3 || out[0] != SHRINK_TEST_VALUES - 3 || out[2] != SHRINK_TEST_VALUES - 1,
+         "queue_shrink_to_fit() lost entries")
+    queue_shrink_to_fit(queue);
+    FAIL(arena.allocs - arena.frees != 1,
+         "queue_shrink_to_fit() did not free everything from an empty queue")
+    FAIL(!queue_push(queue, 9) || !queue_pop(queue, out) || out[0] != 9,
+         "A queue does not work after shrinking to nothing")
+
+    SUBTEST(queue_shrink_policy)
+    FAIL(queue_set_shrink_policy(queue, 101, 1) != false || queue_set_shrink_policy(queue, 50, 0) != false ||
+         !queue_set_shrink_policy(queue, 25, 16),
+         "queue_set_shrink_policy() accepted a bad policy")
+    queue_push_many(queue, vals, SHRINK_TEST_VALUES);
+    queue_pop_many(queue, out, SHRINK_TEST_VALUES - 100);
+    size_t frees = arena.frees;
+    // The pop_many() above is the first pop below the occupancy
+    for (unsigned int i = 0; i < 14; i++) {
+        queue_pop(queue, out);
+    }
+    FAIL(arena.frees != frees,
+         "The queue shrank before the period was up")
+    queue_pop(queue, out);
+    FAIL(arena.frees == frees,
+         "The queue did not shrink after staying below the occupancy")
+#ifndef QUEUE_CHUNKED_BACKEND
+    FAIL(queue->capacity > 4 * queue->len,
+         "The ring did not shrink to twice its length")
+#else
+    FAIL(queue->pool_count != 0,
+         "The chunked queue kept its spare blocks")
+#endif
+    unsigned int data = 0;
+    for (unsigned int expected = SHRINK_TEST_VALUES - 85; expected < SHRINK_TEST_VALUES; expected++) {
+        FAIL(!queue_pop(queue, &data) || data != expected,
+             "Shrinking changed the entries")
+    }
+    queue_set_shrink_policy(queue, 0, 0);
+    queue_push_many(queue, vals, SHRINK_TEST_VALUES);
+    frees = arena.frees;
+    queue_pop_many(queue, out, SHRINK_TEST_VALUES - 1);
+    queue_pop(queue, out);
+#ifndef QUEUE_CHUNKED_BACKEND
+    FAIL(arena.frees != frees,
+         "The queue shrank with the policy cleared")
+#endif
+    queue_delete(queue);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a shrunk queue did not return everything to its allocator")
+
+    SUBTEST(queue_shrink_bounded)
+    queue = queue_create_bounded(100, QUEUE_OVERFLOW_FAIL);
+    queue_push(queue, 1);
+    queue_shrink_to_fit(queue);
+#ifndef QUEUE_CHUNKED_BACKEND
+    FAIL(queue->capacity < 100,
+         "A bounded ring queue gave up the room for its capacity")
+#endif
+    FAIL(!queue_pop(queue, &data) || data != 1,
+         "Shrinking a bounded queue lost its entry")
+    queue_delete(queue);
+    free(vals);
+    free(out);
+
+    PASS(check_queue_shrink_functionality)
+#endif
+}
+
+void check_queue_chunked_functionality(void) {
+#if defined(TEST_QUEUE) && defined(QUEUE_CHUNKED_BACKEND)
+    TEST(check_queue_chunked_functionality)
+
+    SUBTEST(queue_chunked_recycles_blocks)
+    struct counting_arena arena = {0, 0, 0};
+    struct queue * queue = queue_create_with_allocator(&counting_allocator, &arena);
+    unsigned int data = 0;
+    queue_push(queue, 0);
+    size_t allocs = arena.allocs;
+    for (unsigned int i = 1; i < 8 * QUEUE_BLOCK_ENTRIES; i++) {
+        queue_push(queue, i);
+        queue_pop(queue, &data);
+        FAIL(data != i - 1,
+             "queue_pop() returned the wrong entry across blocks")
+    }
+    FAIL(arena.allocs - allocs > QUEUE_BLOCK_POOL,
+         "Crossing block boundaries did not reuse pooled blocks")
+
+    SUBTEST(queue_chunked_releases_spike)
+    for (unsigned int i = 0; i < 16 * QUEUE_BLOCK_ENTRIES; i++) {
+        queue_push(queue, i);
+    }
+    size_t peak = arena.allocs - arena.frees;
+    queue_pop(queue, &data);
+    for (unsigned int i = 0; i < 16 * QUEUE_BLOCK_ENTRIES; i++) {
+        FAIL(!queue_pop(queue, &data) || data != i,
+             "queue_pop() returned the wrong entry draining a spike")
+    }
+    FAIL(queue_has_next(queue) || peak < 16,
+         "A spike was not spread over blocks")
+    FAIL(arena.allocs - arena.frees > 2 + QUEUE_BLOCK_POOL,
+         "Draining a spike kept more than the pooled blocks")
+    queue_delete(queue);
+    FAIL(arena.allocs != arena.frees,
+         "Deleting a chunked queue did not free its blocks")
+
+    PASS(check_queue_chunked_functionality)
+#endif
+}
+
+#ifdef TEST_QUEUE
+// A producer pushes SPSC_TEST_VALUES increasing values through a small
+// ring, alternating single and batch pushes, while the consumer checks
+// they arrive in order.
+//
+#define SPSC_TEST_VALUES   (200000u)
+#define SPSC_TEST_BATCH    (7u)
+
+struct spsc_test_producer {
+    pthread_t thread;
+    struct spsc_queue * queue;
+};
+
+void * spsc_test_producer_run(void * arg) {
+    struct spsc_test_producer * producer = arg;
+    unsigned int next = 0;
+    while (next < SPSC_TEST_VALUES) {
+        if (next % 2 == 0) {
+            unsigned int batch[SPSC_TEST_BATCH];
+            size_t n = SPSC_TEST_VALUES - next < SPSC_TEST_BATCH ? SPSC_TEST_VALUES - next : SPSC_TEST_BATCH;
+            for (size_t i = 0; i < n; i++) {
+                batch[i] = next + i;
+            }
+            size_t pushed = spsc_queue_push_bulk(producer->queue, batch, n);
+            next += pushed;
+            if (pushed == 0) {
+                sched_yield();
+            }
+        } else if (spsc_queue_push(producer->queue, next)) {
+            ++next;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+#endif
+
+void check_spsc_queue_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_spsc_queue_functionality)
+
+    spsc_queue_register_malloc(malloc);
+    spsc_queue_register_free(free);
+
+    SUBTEST(spsc_queue_single_thread)
+    FAIL(spsc_queue_create(0) != NULL,
+         "spsc_queue_create(0) did not fail")
+    struct spsc_queue * queue = spsc_queue_create(5);
+    FAIL(queue == NULL || spsc_queue_capacity(queue) != 8,
+         "spsc_queue_create() did not round its capacity up to a power of two")
+    unsigned int data = 0;
+    FAIL(spsc_queue_pop(queue, &data) != false || spsc_queue_size(queue) != 0,
+         "spsc_queue_pop() on an empty queue did not return false")
+    for (unsigned int i = 0; i < 8; i++) {
+        spsc_queue_push(queue, i);
+    }
+    FAIL(spsc_queue_push(queue, 8) != false || spsc_queue_size(queue) != 8,
+         "spsc_queue_push() on a full queue did not return false")
+    FAIL(!spsc_queue_pop(queue, &data) || data != 0,
+         "spsc_queue_pop() did not return the oldest entry")
+    const unsigned int vals[] = {8, 9, 10};
+    FAIL(spsc_queue_push_bulk(queue, vals, 3) != 1,
+         "spsc_queue_push_bulk() did not stop when the queue filled up")
+    unsigned int out[16];
+    FAIL(spsc_queue_pop_bulk(queue, out, 16) != 8 || out[0] != 1 || out[7] != 8,
+         "spsc_queue_pop_bulk() returned the wrong entries")
+    FAIL(spsc_queue_push_bulk(queue, vals, 3) != 3 || spsc_queue_pop_bulk(queue, out, 2) != 2 ||
+         out[0] != 8 || out[1] != 9 || spsc_queue_size(queue) != 1,
+         "Batches that wrap around the ring are wrong")
+    FAIL(spsc_queue_push_bulk(NULL, vals, 1) != SIZE_MAX || spsc_queue_pop(NULL, &data) != false,
+         "spsc_queue did not reject a NULL queue")
+
+    SUBTEST(spsc_queue_two_threads)
+    spsc_queue_delete(queue);
+    queue = spsc_queue_create(64);
+    struct spsc_test_producer producer = {.queue = queue};
+    pthread_create(&producer.thread, NULL, spsc_test_producer_run, &producer);
+    unsigned int expected = 0;
+    bool in_order = true;
+    while (expected < SPSC_TEST_VALUES) {
+        size_t n = spsc_queue_pop_bulk(queue, out, expected % 3 == 0 ? 16 : 1);
+        for (size_t i = 0; i < n; i++) {
+            in_order = in_order && (out[i] == expected++);
+        }
+        if (n == 0) {
+            sched_yield();
+        }
+    }
+    pthread_join(producer.thread, NULL);
+    FAIL(!in_order || spsc_queue_size(queue) != 0,
+         "Values passed between two threads arrived out of order")
+    FAIL(spsc_queue_delete(queue) == false,
+         "spsc_queue_delete() failed")
+
+    PASS(check_spsc_queue_functionality)
+#endif
+}
+
+#ifdef TEST_QUEUE
+// Producers push MPMC_TEST_VALUES values each, tagged with their id, half
+// one at a time and half in batches, through a small ring. Consumers pop
+// until everything has arrived and check each producer's values reach
+// them in order.
+//
+#define MPMC_TEST_PRODUCERS  (3u)
+#define MPMC_TEST_CONSUMERS  (3u)
+#define MPMC_TEST_VALUES     (50000u)
+#define MPMC_TEST_BATCH      (5u)
+
+struct mpmc_test_worker {
+    pthread_t thread;
+    struct mpmc_queue * queue;
+    unsigned int id;
+    _Atomic unsigned int * received;
+    unsigned long long sum;
+    bool ok;
+};
+
+void * mpmc_test_producer_run(void * arg) {
+    struct mpmc_test_worker * worker = arg;
+    unsigned int next = 0;
+    while (next < MPMC_TEST_VALUES) {
+        unsigned int batch[MPMC_TEST_BATCH];
+        size_t n = (next % 2 == 0 || MPMC_TEST_VALUES - next < MPMC_TEST_BATCH) ? 1 : MPMC_TEST_BATCH;
+        for (size_t i = 0; i < n; i++) {
+            batch[i] = worker->id * MPMC_TEST_VALUES + next + i;
+        }
+        size_t pushed = mpmc_queue_try_push_bulk(worker->queue, batch, n);
+        next += pushed;
+        if (pushed == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void * mpmc_test_consumer_run(void * arg) {
+    struct mpmc_test_worker * worker = arg;
+    unsigned int last[MPMC_TEST_PRODUCERS] = {0};
+    bool seen[MPMC_TEST_PRODUCERS] = {false};
+    worker->ok = true;
+    worker->sum = 0;
+    while (atomic_load(worker->received) < MPMC_TEST_PRODUCERS * MPMC_TEST_VALUES) {
+        unsigned int out[MPMC_TEST_BATCH];
+        size_t n = mpmc_queue_try_pop_bulk(worker->queue, out, (worker->id % 2) ? MPMC_TEST_BATCH : 1);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            unsigned int producer = out[i] / MPMC_TEST_VALUES;
+            worker->ok = worker->ok && producer < MPMC_TEST_PRODUCERS &&
+                         (!seen[producer] || out[i] > last[producer]);
+            if (producer < MPMC_TEST_PRODUCERS) {
+                seen[producer] = true;
+                last[producer] = out[i];
+            }
+            worker->sum += out[i];
+        }
+        atomic_fetch_add(worker->received, n);
+    }
+    return NULL;
+}
+#endif
+
+void check_mpmc_queue_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_mpmc_queue_functionality)
+
+    mpmc_queue_register_malloc(malloc);
+    mpmc_queue_register_free(free);
+
+    SUBTEST(mpmc_queue_single_thread)
+    struct mpmc_queue * queue = mpmc_queue_create(1);
+    FAIL(queue == NULL || mpmc_queue_capacity(queue) != 2,
+         "mpmc_queue_create() did not round its capacity up to 2")
+    mpmc_queue_delete(queue);
+    queue = mpmc_queue_create(6);
+    unsigned int data = 0;
+    FAIL(queue == NULL || mpmc_queue_capacity(queue) != 8 || mpmc_queue_try_pop(queue, &data) != false,
+         "mpmc_queue_try_pop() on an empty queue did not return false")
+    for (unsigned int i = 0; i < 8; i++) {
+        mpmc_queue_try_push(queue, i);
+    }
+    FAIL(mpmc_queue_try_push(queue, 8) != false || mpmc_queue_size(queue) != 8,
+         "mpmc_queue_try_push() on a full queue did not return false")
+    FAIL(!mpmc_queue_try_pop(queue, &data) || data != 0,
+         "mpmc_queue_try_pop() did not return the oldest entry")
+    const unsigned int vals[] = {8, 9, 10};
+    FAIL(mpmc_queue_try_push_bulk(queue, vals, 3) != 1,
+         "mpmc_queue_try_push_bulk() did not stop when the queue filled up")
+    unsigned int out[16];
+    FAIL(mpmc_queue_try_pop_bulk(queue, out, 16) != 8 || out[0] != 1 || out[7] != 8,
+         "mpmc_queue_try_pop_bulk() returned the wrong entries")
+    FAIL(mpmc_queue_try_push_bulk(queue, vals, 3) != 3 || mpmc_queue_try_pop_bulk(queue, out, 2) != 2 ||
+         out[0] != 8 || out[1] != 9 || mpmc_queue_size(queue) != 1,
+         "Batches that wrap around the ring are wrong")
+    FAIL(mpmc_queue_try_push_bulk(queue, vals, 0) != 0 || mpmc_queue_try_push(NULL, 1) != false,
+         "mpmc_queue did not handle an empty batch or a NULL queue")
+    mpmc_queue_delete(queue);
+
+    SUBTEST(mpmc_queue_multiple_threads)
+    queue = mpmc_queue_create(16);
+    _Atomic unsigned int received = 0;
+    struct mpmc_test_worker producers[MPMC_TEST_PRODUCERS];
+    struct mpmc_test_worker consumers[MPMC_TEST_CONSUMERS];
+    for (unsigned int i = 0; i < MPMC_TEST_CONSUMERS; i++) {
+        consumers[i] = (struct mpmc_test_worker){.queue = queue, .id = i, .received = &received};
+        pthread_create(&consumers[i].thread, NULL, mpmc_test_consumer_run, &consumers[i]);
+    }
+    for (unsigned int i = 0; i < MPMC_TEST_PRODUCERS; i++) {
+        producers[i] = (struct mpmc_test_worker){.queue = queue, .id = i};
+        pthread_create(&producers[i].thread, NULL, mpmc_test_producer_run, &producers[i]);
+    }
+    for (unsigned int i = 0; i < MPMC_TEST_PRODUCERS; i++) {
+        pthread_join(producers[i].thread, NULL);
+    }
+    unsigned long long sum = 0;
+    for (unsigned int i = 0; i < MPMC_TEST_CONSUMERS; i++) {
+        pthread_join(consumers[i].thread, NULL);
+        FAIL(!consumers[i].ok,
+             "A consumer saw a producer's values out of order")
+        sum += consumers[i].sum;
+    }
+    unsigned long long total = MPMC_TEST_PRODUCERS * MPMC_TEST_VALUES;
+    FAIL(received != total || sum != total * (total - 1) / 2 || mpmc_queue_size(queue) != 0,
+         "Values were lost or duplicated between threads")
+    FAIL(mpmc_queue_delete(queue) == false,
+         "mpmc_queue_delete() failed")
+
+    PASS(check_mpmc_queue_functionality)
+#endif
+}
+
+#ifdef TEST_QUEUE
+// The owner pushes WS_TEST_VALUES values and pops some of them back while
+// thieves steal from the other end; every value must be taken exactly
+// once. The pool test walks a binary tree of WS_TEST_TREE tasks where each
+// task spawns its children.
+//
+#define WS_TEST_THIEVES   (3u)
+#define WS_TEST_VALUES    (100000u)
+#define WS_TEST_TREE      (100000u)
+
+struct ws_test_thief {
+    pthread_t thread;
+    struct ws_deque * deque;
+    _Atomic unsigned char * taken;
+    _Atomic bool * done;
+};
+
+void * ws_test_thief_run(void * arg) {
+    struct ws_test_thief * thief = arg;
+    for (;;) {
+        unsigned int data;
+        enum ws_steal_result result = ws_deque_steal(thief->deque, &data);
+        if (result == WS_STEAL_SUCCESS) {
+            atomic_fetch_add(&thief->taken[data], 1);
+        } else if (result == WS_STEAL_EMPTY) {
+            if (atomic_load(thief->done)) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void ws_test_tree_task(struct ws_worker * worker, unsigned int item, void * ctx) {
+    _Atomic unsigned char * visits = ctx;
+    atomic_fetch_add(&visits[item], 1);
+    for (unsigned int child = 2 * item + 1; child <= 2 * item + 2; child++) {
+        if (child < WS_TEST_TREE) {
+            ws_pool_spawn(worker, child);
+        }
+    }
+}
+#endif
+
+void check_ws_deque_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_ws_deque_functionality)
+
+    ws_deque_register_malloc(malloc);
+    ws_deque_register_free(free);
+
+    SUBTEST(ws_deque_single_thread)
+    struct ws_deque deque;
+    unsigned int data = 0;
+    FAIL(!ws_deque_init(&deque) || ws_deque_pop(&deque, &data) != false ||
+         ws_deque_steal(&deque, &data) != WS_STEAL_EMPTY,
+         "An empty ws_deque returned data")
+    for (unsigned int i = 0; i < 3 * WS_DEQUE_INITIAL_SIZE; i++) {
+        ws_deque_push(&deque, i);
+    }
+    FAIL(ws_deque_size(&deque) != 3 * WS_DEQUE_INITIAL_SIZE,
+         "ws_deque_size() is wrong after growing")
+    FAIL(!ws_deque_pop(&deque, &data) || data != 3 * WS_DEQUE_INITIAL_SIZE - 1,
+         "ws_deque_pop() did not return the newest entry")
+    FAIL(ws_deque_steal(&deque, &data) != WS_STEAL_SUCCESS || data != 0,
+         "ws_deque_steal() did not return the oldest entry")
+    while (ws_deque_pop(&deque, &data)) {
+    }
+    FAIL(data != 1 || ws_deque_size(&deque) != 0,
+         "Popping everything did not end at the oldest entry")
+    ws_deque_destroy(&deque);
+
+    SUBTEST(ws_deque_thieves)
+    _Atomic unsigned char * taken = calloc(WS_TEST_VALUES, sizeof(*taken));
+    _Atomic bool done = false;
+    ws_deque_init(&deque);
+    struct ws_test_thief thieves[WS_TEST_THIEVES];
+    for (unsigned int i = 0; i < WS_TEST_THIEVES; i++) {
+        thieves[i] = (struct ws_test_thief){.deque = &deque, .taken = taken, .done = &done};
+        pthread_create(&thieves[i].thread, NULL, ws_test_thief_run, &thieves[i]);
+    }
+    for (unsigned int i = 0; i < WS_TEST_VALUES; i++) {
+        ws_deque_push(&deque, i);
+        if (i % 3 == 0 && ws_deque_pop(&deque, &data)) {
+            atomic_fetch_add(&taken[data], 1);
+        }
+    }
+    while (ws_deque_pop(&deque, &data)) {
+        atomic_fetch_add(&taken[data], 1);
+    }
+    atomic_store(&done, true);
+    for (unsigned int i = 0; i < WS_TEST_THIEVES; i++) {
+        pthread_join(thieves[i].thread, NULL);
+    }
+    bool exactly_once = true;
+    for (unsigned int i = 0; i < WS_TEST_VALUES; i++) {
+        exactly_once = exactly_once && (taken[i] == 1);
+    }
+    FAIL(!exactly_once,
+         "A value was lost or taken twice between the owner and thieves")
+    ws_deque_destroy(&deque);
+    free(taken);
+
+    SUBTEST(ws_pool_run)
+    _Atomic unsigned char * visits = calloc(WS_TEST_TREE, sizeof(*visits));
+    struct ws_pool * pool = ws_pool_create(4);
+    FAIL(pool == NULL || ws_pool_create(0) != NULL,
+         "ws_pool_create() failed")
+    const unsigned int root = 0;
+    for (unsigned int run = 1; run <= 2; run++) {
+        FAIL(!ws_pool_run(pool, &root, 1, ws_test_tree_task, (void *)visits),
+             "ws_pool_run() failed")
+        bool all_visited = true;
+        for (unsigned int i = 0; i < WS_TEST_TREE; i++) {
+            all_visited = all_visited && (visits[i] == run);
+        }
+        FAIL(!all_visited,
+             "ws_pool_run() did not run every task exactly once")
+    }
+    FAIL(ws_pool_delete(pool) == false,
+         "ws_pool_delete() failed")
+    free((void *)visits);
+
+    PASS(check_ws_deque_functionality)
+#endif
+}
+
+#define PQUEUE_TEST_ITEMS  (10000u)
+
+void check_pqueue_functionality(void) {
+#ifdef TEST_QUEUE
+    TEST(check_pqueue_functionality)
+
+    pqueue_register_malloc(instrumented_malloc);
+    pqueue_register_free(instrumented_free);
+
+    SUBTEST(pqueue_single_item)
+    FAIL(pqueue_create(0) != NULL,
+         "pqueue_create(0) did not fail")
+    struct pqueue * pqueue = pqueue_create(PQUEUE_TEST_ITEMS);
+    unsigned int item = 0;
+    unsigned int key = 0;
+    FAIL(pqueue == NULL || pqueue_pop(pqueue, &item, &key) != false || pqueue_size(pqueue) != 0,
+         "pqueue_pop() on an empty heap did not return false")
+    FAIL(!pqueue_push(pqueue, 3, 30) || pqueue_push(pqueue, 3, 10) != false ||
+         pqueue_push(pqueue, PQUEUE_TEST_ITEMS, 10) != false,
+         "pqueue_push() accepted a queued or out of range item")
+    FAIL(!pqueue_contains(pqueue, 3) || pqueue_contains(pqueue, 4) || pqueue_contains(pqueue, PQUEUE_TEST_ITEMS),
+         "pqueue_contains() is wrong")
+    FAIL(pqueue_decrease_key(pqueue, 3, 40) != false || pqueue_decrease_key(pqueue, 4, 1) != false,
+         "pqueue_decrease_key() raised a key or changed an absent item")
+    FAIL(!pqueue_decrease_key(pqueue, 3, 20) || !pqueue_peek(pqueue, &item, &key) || item != 3 || key != 20,
+         "pqueue_decrease_key() did not lower the key")
+    FAIL(!pqueue_pop(pqueue, &item, NULL) || item != 3 || pqueue_contains(pqueue, 3) || pqueue_size(pqueue) != 0,
+         "pqueue_pop() did not remove the item")
+
+    SUBTEST(pqueue_ordering)
+    unsigned int * keys = malloc(PQUEUE_TEST_ITEMS * sizeof(unsigned int));
+    srand(48);
+    for (unsigned int i = 0; i < PQUEUE_TEST_ITEMS; i++) {
+        keys[i] = rand() % 100000;
+        FAIL(!pqueue_push(pqueue, i, keys[i]),
+             "pqueue_push() failed")
+    }
+    for (unsigned int i = 0; i < PQUEUE_TEST_ITEMS; i += 3) {
+        keys[i] /= 2;
+        FAIL(!pqueue_decrease_key(pqueue, i, keys[i]),
+             "pqueue_decrease_key() failed")
+    }
+    unsigned int previous = 0;
+    for (unsigned int i = 0; i < PQUEUE_TEST_ITEMS; i++) {
+        FAIL(!pqueue_pop(pqueue, &item, &key) || key < previous || keys[item] != key,
+             "pqueue_pop() returned the items out of key order")
+        previous = key;
+    }
+    FAIL(pqueue_size(pqueue) != 0,
+         "Items were left behind in the heap")
+
+    SUBTEST(pqueue_alloc_fail)
+    pqueue_delete(pqueue);
+    pqueue = pqueue_create(PQUEUE_TEST_ITEMS);
+    for (unsigned int i = 0; i < PQUEUE_INITIAL_CAPACITY; i++) {
+        pqueue_push(pqueue, i, i);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(pqueue_push(pqueue, PQUEUE_INITIAL_CAPACITY, 0) != false ||
+         pqueue_contains(pqueue, PQUEUE_INITIAL_CAPACITY) || pqueue_size(pqueue) != PQUEUE_INITIAL_CAPACITY,
+         "A failed pqueue_push() changed the heap")
+    FAIL(!pqueue_pop(pqueue, &item, &key) || item != 0 || key != 0,
+         "The heap is broken after a failed push")
+    pqueue_delete(pqueue);
+
+    SUBTEST(radix_heap_monotone)
+    struct radix_heap * heap = radix_heap_create();
+    FAIL(heap == NULL || radix_heap_pop(heap, &item, &key) != false,
+         "radix_heap_pop() on an empty heap did not return false")
+    // Dijkstra-like: every push is at or above the last popped key.
+    unsigned int last = 0;
+    size_t popped = 0;
+    for (unsigned int i = 0; i < PQUEUE_TEST_ITEMS; i++) {
+        FAIL(!radix_heap_push(heap, i, last + rand() % 5000),
+             "radix_heap_push() failed")
+        if (i % 2 == 1) {
+            FAIL(!radix_heap_pop(heap, &item, &key) || key < last,
+                 "radix_heap_pop() went backwards")
+            last = key;
+            ++popped;
+        }
+    }
+    FAIL(radix_heap_push(heap, 0, last - 1) != false,
+         "radix_heap_push() accepted a key below the last popped key")
+    FAIL(radix_heap_size(heap) != PQUEUE_TEST_ITEMS - popped,
+         "radix_heap_size() is wrong")
+
+    SUBTEST(radix_heap_alloc_fail)
+    size_t left = radix_heap_size(heap);
+    unsigned int before = last;
+    while (radix_heap_size(heap) != 0) {
+        if (heap->buckets[0].len == 0) {
+            instrumented_malloc_fail_next = true;
+            bool ok = radix_heap_pop(heap, &item, &key);
+            instrumented_malloc_fail_next = false;
+            FAIL(!ok && (radix_heap_size(heap) != left || heap->last != before),
+                 "A failed radix_heap_pop() changed the heap")
+            if (!ok) {
+                continue;
+            }
+        } else {
+            FAIL(!radix_heap_pop(heap, &item, &key),
+                 "radix_heap_pop() failed")
+        }
+        FAIL(key < before,
+             "radix_heap_pop() went backwards")
+        before = key;
+        --left;
+    }
+    FAIL(left != 0,
+         "Entries were lost in the radix heap")
+    radix_heap_delete(heap);
+    free(keys);
+
+    PASS(check_pqueue_functionality)
+#endif
+}
+
 void run_slab_allocator_tests(void) {
     test_basic_alloc_free();
     test_double_alloc_free();
@@ -589,6 +2919,8 @@ int main(void) {
 
     // Setup instrumented memory allocation/deallocation.
     //
+    linked_list_register_malloc(&instrumented_malloc);
+    linked_list_register_free(&instrumented_free);
     queue_register_malloc(&instrumented_malloc);
     queue_register_free(&instrumented_free);
 
@@ -598,6 +2930,30 @@ int main(void) {
     check_linked_list_find_functionality();
 
     check_linked_list_additional_delete_tests();
+    check_linked_list_bulk_functionality();
+    check_linked_list_pool_functionality();
+    check_linked_list_iterator_mutation();
+    check_linked_list_splice_functionality();
+    check_linked_list_sort_functionality();
+    check_linked_list_compact_functionality();
+    check_concurrent_list_functionality();
+    check_linked_list_rcu_functionality();
+    check_linked_list_parallel_functionality();
+    check_allocator_functionality();
+    check_linked_list_clear_functionality();
+    check_linked_list_remove_if_functionality();
+    check_linked_list_filter_functionality();
+    check_linked_list_inline_functionality();
+    check_queue_ring_functionality();
+    check_queue_many_functionality();
+    check_queue_wait_functionality();
+    check_queue_bounded_functionality();
+    check_queue_shrink_functionality();
+    check_queue_chunked_functionality();
+    check_spsc_queue_functionality();
+    check_mpmc_queue_functionality();
+    check_ws_deque_functionality();
+    check_pqueue_functionality();
     run_slab_allocator_tests();
 
     return 0;
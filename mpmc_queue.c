@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "linked_list.h"
+#include "mpmc_queue.h"
+#include "stdint.h"
+#include "stdlib.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+//
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+/* Sequence of the slot for position pos, relative to target. Zero means
+   the slot is ready, negative that it is still a lap behind. */
+static inline intptr_t slot_state(struct mpmc_queue * queue, size_t pos, size_t target) {
+    struct mpmc_queue_slot * slot = &queue->slots[pos & queue->mask];
+    return (intptr_t)(atomic_load_explicit(&slot->sequence, memory_order_acquire) - target);
+}
+
+/* Claim up to n consecutive positions from *position whose slots are
+   ready, that is whose sequence is pos + offset. Returns the first
+   claimed position in *claimed and the number claimed, 0 if the first
+   slot is a lap behind (queue full for producers, empty for consumers). */
+static size_t claim(struct mpmc_queue * queue, _Atomic size_t * position, size_t offset,
+                    size_t n, size_t * claimed) {
+    if (n == 0) {
+        return 0;
+    }
+    size_t pos = atomic_load_explicit(position, memory_order_relaxed);
+    for (;;) {
+        size_t ready = 0;
+        while (ready < n && slot_state(queue, pos + ready, pos + ready + offset) == 0) {
+            ++ready;
+        }
+        if (ready == 0) {
+            if (slot_state(queue, pos, pos + offset) < 0) {
+                return 0;
+            }
+            // Another thread claimed pos first
+            pos = atomic_load_explicit(position, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(position, &pos, pos + ready,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            *claimed = pos;
+            return ready;
+        }
+    }
+}
+
+/* Create a queue */
+struct mpmc_queue * mpmc_queue_create(size_t capacity) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    if (capacity == 0 || capacity > SIZE_MAX / 2 / sizeof(struct mpmc_queue_slot)) {
+        return NULL;
+    }
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    struct mpmc_queue * queue = malloc_fptr(sizeof(struct mpmc_queue));
+    INVALID_PTR_CHECK(queue, NULL);
+    queue->slots = malloc_fptr(size * sizeof(struct mpmc_queue_slot));
+    if (queue->slots == NULL) {
+        free_fptr(queue);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    return queue;
+}
+
+/* Delete a queue */
+bool mpmc_queue_delete(struct mpmc_queue * queue) {
+    INVALID_PTR_CHECK(queue, false);
+    free_fptr(queue->slots);
+    free_fptr(queue);
+    return true;
+}
+
+/* Push one value */
+bool mpmc_queue_try_push(struct mpmc_queue * queue, unsigned int data) {
+    return mpmc_queue_try_push_bulk(queue, &data, 1) == 1;
+}
+
+/* Pop one value */
+bool mpmc_queue_try_pop(struct mpmc_queue * queue, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(popped_data, false);
+    return mpmc_queue_try_pop_bulk(queue, popped_data, 1) == 1;
+}
+
+/* Push a run of values into consecutive positions */
+size_t mpmc_queue_try_push_bulk(struct mpmc_queue * queue, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(vals, SIZE_MAX);
+    size_t pos;
+    n = claim(queue, &queue->enqueue_pos, 0, n, &pos);
+    for (size_t i = 0; i < n; i++) {
+        struct mpmc_queue_slot * slot = &queue->slots[(pos + i) & queue->mask];
+        slot->data = vals[i];
+        atomic_store_explicit(&slot->sequence, pos + i + 1, memory_order_release);
+    }
+    return n;
+}
+
+/* Pop a run of values from consecutive positions */
+size_t mpmc_queue_try_pop_bulk(struct mpmc_queue * queue, unsigned int * out, size_t max) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(out, SIZE_MAX);
+    size_t pos;
+    max = claim(queue, &queue->dequeue_pos, 1, max, &pos);
+    for (size_t i = 0; i < max; i++) {
+        struct mpmc_queue_slot * slot = &queue->slots[(pos + i) & queue->mask];
+        out[i] = slot->data;
+        atomic_store_explicit(&slot->sequence, pos + i + queue->mask + 1, memory_order_release);
+    }
+    return max;
+}
+
+/* Get the number of entries, consumers first so the difference can't go
+   negative */
+size_t mpmc_queue_size(struct mpmc_queue * queue) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    size_t dequeued = atomic_load(&queue->dequeue_pos);
+    size_t enqueued = atomic_load(&queue->enqueue_pos);
+    return enqueued - dequeued;
+}
+
+/* Get the number of entries the ring holds */
+size_t mpmc_queue_capacity(struct mpmc_queue * queue) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    return queue->mask + 1;
+}
+
+/* Register malloc function */
+bool mpmc_queue_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register free function */
+bool mpmc_queue_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MPMC_QUEUE_H_
+#define MPMC_QUEUE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A bounded lock-free queue of unsigned ints that any number of threads
+   can push to and pop from at the same time (Dmitry Vyukov's bounded MPMC
+   queue).
+
+   Every slot of the power-of-two ring carries a sequence number that says
+   whose turn it is. A slot at position pos is free for the producer that
+   claims pos when its sequence is pos, and holds data for the consumer
+   that claims pos when its sequence is pos + 1. Producers claim positions
+   by compare-and-swap on enqueue_pos and consumers on dequeue_pos, so the
+   two sides only meet on the slots themselves. After a producer writes
+   its data it sets the sequence to pos + 1, and after a consumer reads it
+   sets it to pos + capacity, handing the slot to the producer one lap
+   later. Both stores are releases, paired with acquire loads.
+
+   The batch calls claim a run of consecutive ready slots with one
+   compare-and-swap. */
+
+// Padding used to keep the producer and consumer positions on their own
+// cache lines.
+//
+#define MPMC_QUEUE_CACHE_LINE   (64)
+
+struct mpmc_queue_slot {
+    _Atomic size_t sequence;
+    unsigned int data;
+};
+
+// Definition of the queue.
+//
+struct mpmc_queue {
+    _Atomic size_t enqueue_pos;
+    char pad_producers[MPMC_QUEUE_CACHE_LINE];
+    _Atomic size_t dequeue_pos;
+    char pad_consumers[MPMC_QUEUE_CACHE_LINE];
+    struct mpmc_queue_slot * slots;
+    size_t mask;
+};
+
+// Creates a new, empty queue.
+// PRECONDITION: Register malloc() and free() functions via the
+//               mpmc_queue_register_malloc() and
+//               mpmc_queue_register_free() functions.
+// \param capacity : Number of entries, rounded up to a power of two of at
+//                   least 2.
+// Returns a new mpmc_queue on success, NULL on failure.
+//
+struct mpmc_queue * mpmc_queue_create(size_t capacity);
+
+// Deletes a queue.
+// PRECONDITION: No thread is using the queue.
+// \param queue : Pointer to queue to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool mpmc_queue_delete(struct mpmc_queue * queue);
+
+// Pushes an unsigned int onto the queue without waiting.
+// \param queue : Pointer to queue.
+// \param data  : Data to insert.
+// Returns TRUE on success, FALSE if the queue is full or on failure.
+//
+bool mpmc_queue_try_push(struct mpmc_queue * queue, unsigned int data);
+
+// Pops an unsigned int from the queue without waiting.
+// \param queue       : Pointer to queue.
+// \param popped_data : Pointer to popped data (provided by caller), if pop occurs.
+// Returns TRUE on success, FALSE if the queue is empty or on failure.
+//
+bool mpmc_queue_try_pop(struct mpmc_queue * queue, unsigned int * popped_data);
+
+// Pushes up to n unsigned ints without waiting. The values pushed occupy
+// consecutive positions, other producers' values don't interleave.
+// \param queue : Pointer to queue.
+// \param vals  : Values to push, in order.
+// \param n     : Number of values.
+// Returns the number of values pushed, fewer than n if the queue filled
+// up, SIZE_MAX on failure.
+//
+size_t mpmc_queue_try_push_bulk(struct mpmc_queue * queue,
+                                const unsigned int * vals,
+                                size_t n);
+
+// Pops up to max consecutive unsigned ints without waiting.
+// \param queue : Pointer to queue.
+// \param out   : Receives the popped values, in order.
+// \param max   : Capacity of out.
+// Returns the number of values popped, SIZE_MAX on failure.
+//
+size_t mpmc_queue_try_pop_bulk(struct mpmc_queue * queue,
+                               unsigned int * out,
+                               size_t max);
+
+// Returns the number of entries in the queue. Under concurrent updates
+// this is a snapshot that may already be stale.
+// \param queue : Pointer to queue.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t mpmc_queue_size(struct mpmc_queue * queue);
+
+// Returns the number of entries the queue can hold.
+// \param queue : Pointer to queue.
+// Returns capacity on success, SIZE_MAX otherwise.
+//
+size_t mpmc_queue_capacity(struct mpmc_queue * queue);
+
+// Registers malloc() function.
+// \param malloc : Function pointer to malloc()-like function, must be
+//                 thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool mpmc_queue_register_malloc(void * (*malloc)(size_t));
+
+// Registers free() function.
+// \param free : Function pointer to free()-like function, must be
+//               thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool mpmc_queue_register_free(void (*free)(void*));
+
+#endif
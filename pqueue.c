@@ -0,0 +1,344 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "linked_list.h"
+#include "pqueue.h"
+#include "stdlib.h"
+#include "string.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+//
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+/* Grow an entry array to hold at least min_capacity entries */
+static bool grow_entries(struct pqueue_entry ** entries, size_t len, size_t * capacity, size_t min_capacity) {
+    size_t new_capacity = *capacity ? *capacity : PQUEUE_INITIAL_CAPACITY;
+    while (new_capacity < min_capacity) {
+        if (new_capacity > SIZE_MAX / 2 / sizeof(struct pqueue_entry)) {
+            return false;
+        }
+        new_capacity *= 2;
+    }
+    struct pqueue_entry * grown = malloc_fptr(new_capacity * sizeof(struct pqueue_entry));
+    INVALID_PTR_CHECK(grown, false);
+    if (*entries != NULL) {
+        memcpy(grown, *entries, len * sizeof(struct pqueue_entry));
+        free_fptr(*entries);
+    }
+    *entries = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* Move entry up from slot pos until its parent is no larger */
+static void sift_up(struct pqueue * pqueue, size_t pos, struct pqueue_entry entry) {
+    while (pos != 0) {
+        size_t parent = (pos - 1) / PQUEUE_ARITY;
+        if (pqueue->heap[parent].key <= entry.key) {
+            break;
+        }
+        pqueue->heap[pos] = pqueue->heap[parent];
+        pqueue->slot[pqueue->heap[pos].item] = pos;
+        pos = parent;
+    }
+    pqueue->heap[pos] = entry;
+    pqueue->slot[entry.item] = pos;
+}
+
+/* Move entry down from slot pos until no child is smaller */
+static void sift_down(struct pqueue * pqueue, size_t pos, struct pqueue_entry entry) {
+    for (;;) {
+        size_t first = pos * PQUEUE_ARITY + 1;
+        if (first >= pqueue->len) {
+            break;
+        }
+        size_t last = first + PQUEUE_ARITY;
+        if (last > pqueue->len) {
+            last = pqueue->len;
+        }
+        size_t min = first;
+        for (size_t child = first + 1; child < last; child++) {
+            if (pqueue->heap[child].key < pqueue->heap[min].key) {
+                min = child;
+            }
+        }
+        if (pqueue->heap[min].key >= entry.key) {
+            break;
+        }
+        pqueue->heap[pos] = pqueue->heap[min];
+        pqueue->slot[pqueue->heap[pos].item] = pos;
+        pos = min;
+    }
+    pqueue->heap[pos] = entry;
+    pqueue->slot[entry.item] = pos;
+}
+
+/* Create a d-ary heap */
+struct pqueue * pqueue_create(size_t items) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    if (items == 0 || items >= PQUEUE_ABSENT || items > SIZE_MAX / sizeof(unsigned int)) {
+        return NULL;
+    }
+
+    struct pqueue * pqueue = malloc_fptr(sizeof(struct pqueue));
+    INVALID_PTR_CHECK(pqueue, NULL);
+    pqueue->slot = malloc_fptr(items * sizeof(unsigned int));
+    if (pqueue->slot == NULL) {
+        free_fptr(pqueue);
+        return NULL;
+    }
+    memset(pqueue->slot, 0xff, items * sizeof(unsigned int));
+    pqueue->heap = NULL;
+    pqueue->len = 0;
+    pqueue->capacity = 0;
+    pqueue->items = items;
+    return pqueue;
+}
+
+/* Delete a d-ary heap */
+bool pqueue_delete(struct pqueue * pqueue) {
+    INVALID_PTR_CHECK(pqueue, false);
+    if (pqueue->heap != NULL) {
+        free_fptr(pqueue->heap);
+    }
+    free_fptr(pqueue->slot);
+    free_fptr(pqueue);
+    return true;
+}
+
+/* Insert an item */
+bool pqueue_push(struct pqueue * pqueue, unsigned int item, unsigned int key) {
+    INVALID_PTR_CHECK(pqueue, false);
+    if (item >= pqueue->items || pqueue->slot[item] != PQUEUE_ABSENT) {
+        return false;
+    }
+    if (pqueue->len == pqueue->capacity &&
+        !grow_entries(&pqueue->heap, pqueue->len, &pqueue->capacity, pqueue->len + 1)) {
+        return false;
+    }
+
+    struct pqueue_entry entry = {key, item};
+    sift_up(pqueue, pqueue->len++, entry);
+    return true;
+}
+
+/* Lower the key of a queued item */
+bool pqueue_decrease_key(struct pqueue * pqueue, unsigned int item, unsigned int key) {
+    INVALID_PTR_CHECK(pqueue, false);
+    if (item >= pqueue->items || pqueue->slot[item] == PQUEUE_ABSENT) {
+        return false;
+    }
+    size_t pos = pqueue->slot[item];
+    if (key > pqueue->heap[pos].key) {
+        return false;
+    }
+
+    struct pqueue_entry entry = {key, item};
+    sift_up(pqueue, pos, entry);
+    return true;
+}
+
+/* Remove the item with the smallest key */
+bool pqueue_pop(struct pqueue * pqueue, unsigned int * item, unsigned int * key) {
+    INVALID_PTR_CHECK(pqueue, false);
+    INVALID_PTR_CHECK(item, false);
+    if (pqueue->len == 0) {
+        return false;
+    }
+
+    *item = pqueue->heap[0].item;
+    if (key != NULL) {
+        *key = pqueue->heap[0].key;
+    }
+    pqueue->slot[*item] = PQUEUE_ABSENT;
+    if (--pqueue->len != 0) {
+        sift_down(pqueue, 0, pqueue->heap[pqueue->len]);
+    }
+    return true;
+}
+
+/* Look at the item with the smallest key */
+bool pqueue_peek(struct pqueue * pqueue, unsigned int * item, unsigned int * key) {
+    INVALID_PTR_CHECK(pqueue, false);
+    INVALID_PTR_CHECK(item, false);
+    if (pqueue->len == 0) {
+        return false;
+    }
+
+    *item = pqueue->heap[0].item;
+    if (key != NULL) {
+        *key = pqueue->heap[0].key;
+    }
+    return true;
+}
+
+/* Check whether an item is queued */
+bool pqueue_contains(struct pqueue * pqueue, unsigned int item) {
+    INVALID_PTR_CHECK(pqueue, false);
+    return item < pqueue->items && pqueue->slot[item] != PQUEUE_ABSENT;
+}
+
+/* Get the number of queued items */
+size_t pqueue_size(struct pqueue * pqueue) {
+    INVALID_PTR_CHECK(pqueue, SIZE_MAX);
+    return pqueue->len;
+}
+
+/* Bucket for key relative to the last popped key */
+static inline size_t radix_bucket(unsigned int last, unsigned int key) {
+    if (key == last) {
+        return 0;
+    }
+    return sizeof(unsigned int) * CHAR_BIT - __builtin_clz(key ^ last);
+}
+
+/* Create a radix heap */
+struct radix_heap * radix_heap_create(void) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    struct radix_heap * heap = malloc_fptr(sizeof(struct radix_heap));
+    INVALID_PTR_CHECK(heap, NULL);
+    heap->last = 0;
+    heap->len = 0;
+    for (size_t i = 0; i < RADIX_HEAP_BUCKETS; i++) {
+        heap->buckets[i].entries = NULL;
+        heap->buckets[i].len = 0;
+        heap->buckets[i].capacity = 0;
+    }
+    return heap;
+}
+
+/* Delete a radix heap */
+bool radix_heap_delete(struct radix_heap * heap) {
+    INVALID_PTR_CHECK(heap, false);
+    for (size_t i = 0; i < RADIX_HEAP_BUCKETS; i++) {
+        if (heap->buckets[i].entries != NULL) {
+            free_fptr(heap->buckets[i].entries);
+        }
+    }
+    free_fptr(heap);
+    return true;
+}
+
+/* Insert an item */
+bool radix_heap_push(struct radix_heap * heap, unsigned int item, unsigned int key) {
+    INVALID_PTR_CHECK(heap, false);
+    if (key < heap->last) {
+        return false;
+    }
+
+    struct radix_heap_bucket * bucket = &heap->buckets[radix_bucket(heap->last, key)];
+    if (bucket->len == bucket->capacity &&
+        !grow_entries(&bucket->entries, bucket->len, &bucket->capacity, bucket->len + 1)) {
+        return false;
+    }
+    bucket->entries[bucket->len].key = key;
+    bucket->entries[bucket->len].item = item;
+    ++bucket->len;
+    ++heap->len;
+    return true;
+}
+
+/* Refill bucket 0 from the lowest non-empty bucket. Every entry of that
+   bucket lands in a lower one once last moves to its smallest key. Room
+   is made in the target buckets first, so a failed allocation leaves the
+   heap untouched. */
+static bool redistribute(struct radix_heap * heap) {
+    size_t from = 1;
+    while (heap->buckets[from].len == 0) {
+        ++from;
+    }
+    struct radix_heap_bucket * source = &heap->buckets[from];
+
+    unsigned int min = source->entries[0].key;
+    for (size_t i = 1; i < source->len; i++) {
+        if (source->entries[i].key < min) {
+            min = source->entries[i].key;
+        }
+    }
+
+    size_t counts[RADIX_HEAP_BUCKETS] = {0};
+    for (size_t i = 0; i < source->len; i++) {
+        ++counts[radix_bucket(min, source->entries[i].key)];
+    }
+    for (size_t b = 0; b < from; b++) {
+        struct radix_heap_bucket * target = &heap->buckets[b];
+        if (counts[b] != 0 && target->len + counts[b] > target->capacity &&
+            !grow_entries(&target->entries, target->len, &target->capacity, target->len + counts[b])) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < source->len; i++) {
+        struct radix_heap_bucket * target = &heap->buckets[radix_bucket(min, source->entries[i].key)];
+        target->entries[target->len++] = source->entries[i];
+    }
+    source->len = 0;
+    heap->last = min;
+    return true;
+}
+
+/* Remove an entry with the smallest key */
+bool radix_heap_pop(struct radix_heap * heap, unsigned int * item, unsigned int * key) {
+    INVALID_PTR_CHECK(heap, false);
+    INVALID_PTR_CHECK(item, false);
+    if (heap->len == 0) {
+        return false;
+    }
+    if (heap->buckets[0].len == 0 && !redistribute(heap)) {
+        return false;
+    }
+
+    struct radix_heap_bucket * bucket = &heap->buckets[0];
+    --bucket->len;
+    *item = bucket->entries[bucket->len].item;
+    if (key != NULL) {
+        *key = bucket->entries[bucket->len].key;
+    }
+    --heap->len;
+    return true;
+}
+
+/* Get the number of queued entries */
+size_t radix_heap_size(struct radix_heap * heap) {
+    INVALID_PTR_CHECK(heap, SIZE_MAX);
+    return heap->len;
+}
+
+/* Register malloc function */
+bool pqueue_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register free function */
+bool pqueue_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
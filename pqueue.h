@@ -0,0 +1,208 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef PQUEUE_H_
+#define PQUEUE_H_
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Min-priority queues of unsigned int items keyed by unsigned int.
+
+   struct pqueue is a 4-ary heap of (key, item) pairs in one array. A
+   node's children sit next to each other, so sift-down compares four
+   keys from a single 32 byte run instead of chasing two children a
+   cache line apart, and the tree is half as deep as a binary heap.
+   Items are handles in [0, items) fixed at creation, typically graph
+   node ids. A side array maps each handle to its heap slot, which is
+   what lets pqueue_decrease_key() find an entry without a search.
+
+   struct radix_heap is for monotone keys only: a key pushed must be no
+   smaller than the last key popped, which holds for Dijkstra with
+   non-negative weights. Entries are kept in 33 buckets by the highest
+   bit in which their key differs from the last popped key. Popping only
+   scans a bucket when bucket 0 runs dry, and then redistributes it into
+   lower buckets, so each entry moves at most 32 times over its life. It
+   has no decrease-key; push the item again with the smaller key and
+   skip stale entries when they come out.
+
+   Both use the functions registered with pqueue_register_malloc() and
+   pqueue_register_free(). */
+
+#define PQUEUE_ARITY            (4)
+#define PQUEUE_INITIAL_CAPACITY (64)
+
+// Heap slot of an item that is not in the queue.
+//
+#define PQUEUE_ABSENT           (UINT_MAX)
+
+// One bucket per bit of the key, plus bucket 0 for keys equal to the
+// last popped key.
+//
+#define RADIX_HEAP_BUCKETS      (sizeof(unsigned int) * CHAR_BIT + 1)
+
+struct pqueue_entry {
+    unsigned int key;
+    unsigned int item;
+};
+
+// Definition of the d-ary heap. slot[item] is the item's index in heap,
+// or PQUEUE_ABSENT.
+//
+struct pqueue {
+    struct pqueue_entry * heap;
+    size_t len;
+    size_t capacity;
+    unsigned int * slot;
+    size_t items;
+};
+
+struct radix_heap_bucket {
+    struct pqueue_entry * entries;
+    size_t len;
+    size_t capacity;
+};
+
+// Definition of the radix heap.
+//
+struct radix_heap {
+    unsigned int last;
+    size_t len;
+    struct radix_heap_bucket buckets[RADIX_HEAP_BUCKETS];
+};
+
+// Creates a new, empty d-ary heap.
+// PRECONDITION: Register malloc() and free() functions via the
+//               pqueue_register_malloc() and pqueue_register_free()
+//               functions.
+// \param items : Number of item handles, items are 0 to items - 1.
+// Returns a new pqueue on success, NULL on failure.
+//
+struct pqueue * pqueue_create(size_t items);
+
+// Deletes a d-ary heap.
+// \param pqueue : Pointer to heap to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool pqueue_delete(struct pqueue * pqueue);
+
+// Inserts an item.
+// \param pqueue : Pointer to heap.
+// \param item   : Item handle, below the heap's item count.
+// \param key    : Priority, smaller pops first.
+// Returns TRUE on success, FALSE if the item is already queued, out of
+// range, or on failure.
+//
+bool pqueue_push(struct pqueue * pqueue, unsigned int item, unsigned int key);
+
+// Lowers the key of a queued item.
+// \param pqueue : Pointer to heap.
+// \param item   : Item handle.
+// \param key    : New priority, no larger than the current one.
+// Returns TRUE on success, FALSE if the item is not queued, key is larger
+// than its current key, or on failure.
+//
+bool pqueue_decrease_key(struct pqueue * pqueue, unsigned int item, unsigned int key);
+
+// Pops the item with the smallest key. Ties pop in no particular order.
+// \param pqueue : Pointer to heap.
+// \param item   : Receives the item.
+// \param key    : Receives its key, may be NULL.
+// Returns TRUE on success, FALSE if the heap is empty or on failure.
+//
+bool pqueue_pop(struct pqueue * pqueue, unsigned int * item, unsigned int * key);
+
+// Returns the item with the smallest key without removing it.
+// \param pqueue : Pointer to heap.
+// \param item   : Receives the item.
+// \param key    : Receives its key, may be NULL.
+// Returns TRUE on success, FALSE if the heap is empty or on failure.
+//
+bool pqueue_peek(struct pqueue * pqueue, unsigned int * item, unsigned int * key);
+
+// Checks whether an item is queued.
+// \param pqueue : Pointer to heap.
+// \param item   : Item handle.
+// Returns TRUE if the item is queued, FALSE otherwise.
+//
+bool pqueue_contains(struct pqueue * pqueue, unsigned int item);
+
+// Returns the number of queued items.
+// \param pqueue : Pointer to heap.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t pqueue_size(struct pqueue * pqueue);
+
+// Creates a new, empty radix heap. The last popped key starts at 0.
+// PRECONDITION: Register malloc() and free() functions via the
+//               pqueue_register_malloc() and pqueue_register_free()
+//               functions.
+// Returns a new radix_heap on success, NULL on failure.
+//
+struct radix_heap * radix_heap_create(void);
+
+// Deletes a radix heap.
+// \param heap : Pointer to heap to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool radix_heap_delete(struct radix_heap * heap);
+
+// Inserts an item. The same item may be queued more than once.
+// \param heap : Pointer to heap.
+// \param item : Item.
+// \param key  : Priority, no smaller than the last popped key.
+// Returns TRUE on success, FALSE if key is smaller than the last popped
+// key or on failure.
+//
+bool radix_heap_push(struct radix_heap * heap, unsigned int item, unsigned int key);
+
+// Pops an entry with the smallest key.
+// \param heap : Pointer to heap.
+// \param item : Receives the item.
+// \param key  : Receives its key, may be NULL.
+// Returns TRUE on success, FALSE if the heap is empty or on failure.
+//
+bool radix_heap_pop(struct radix_heap * heap, unsigned int * item, unsigned int * key);
+
+// Returns the number of queued entries.
+// \param heap : Pointer to heap.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t radix_heap_size(struct radix_heap * heap);
+
+// Registers malloc() function.
+// \param malloc : Function pointer to malloc()-like function.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool pqueue_register_malloc(void * (*malloc)(size_t));
+
+// Registers free() function.
+// \param free : Function pointer to free()-like function.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool pqueue_register_free(void (*free)(void*));
+
+#endif
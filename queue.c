@@ -23,10 +23,12 @@ SOFTWARE.
 */
 
 #include "queue.h"
+#include "queue_wait.h"
 #include "stdlib.h"
 #include "stdint.h"
 #include "stdbool.h"
 #include "stdio.h"
+#include "string.h"
 
 // Function pointers to (potentially) custom malloc() and
 // free() functions.
@@ -36,11 +38,27 @@ static void   (*free_fptr)(void* addr)    = NULL;
 // Implement your queue functions here.
 //
 
+/* Queues without their own allocator use an allocator that forwards to
+   the functions registered here */
+static void * registered_malloc(void * ctx, size_t size) {
+    (void)ctx;
+    return malloc_fptr(size);
+}
+
+static void registered_free(void * ctx, void * addr) {
+    (void)ctx;
+    free_fptr(addr);
+}
+
+static const struct ll_allocator registered_allocator = {
+    .malloc = registered_malloc,
+    .free   = registered_free,
+};
+
 /* Register a user-specified malloc method */
 bool queue_register_malloc(void * (*malloc)(size_t)) {
     INVALID_PTR_CHECK(malloc, false);
     malloc_fptr = malloc;
-    linked_list_register_malloc(malloc);
     return true;
 }
 
@@ -48,79 +66,274 @@ bool queue_register_malloc(void * (*malloc)(size_t)) {
 bool queue_register_free(void (*free)(void*)) {
     INVALID_PTR_CHECK(free, false);
     free_fptr = free; 
-    linked_list_register_free(free);
     return true;
 }
 
+/* Copy the n oldest entries to out without popping them. At most two
+   runs, the part up to the end of the buffer and the part that wrapped. */
+static void ring_read(struct queue * queue, unsigned int * out, size_t n) {
+    size_t first = queue->capacity - queue->head;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, &queue->buf[queue->head], first * sizeof(unsigned int));
+    memcpy(&out[first], queue->buf, (n - first) * sizeof(unsigned int));
+}
+
 /* Create a queue */
 struct queue * queue_create(void) {
-    struct queue *q = (struct queue *) malloc_fptr(sizeof(struct queue));
+    return queue_create_with_allocator(NULL, NULL);
+}
+
+/* Create a queue on its own allocator */
+struct queue * queue_create_with_allocator(const struct ll_allocator * ops, void * ctx) {
+    if (ops == NULL) {
+        ops = &registered_allocator;
+    }
+    struct queue *q = (struct queue *) ops->malloc(ctx, sizeof(struct queue));
     INVALID_PTR_CHECK(q, NULL);
-    q->ll = linked_list_create();
+    q->allocator = ops;
+    q->allocator_ctx = ctx;
+    q->ll = NULL;
     q->len = 0;
+    q->buf = NULL;
+    q->capacity = 0;
+    q->head = 0;
+    queue_wait_init(q);
     return q;
 }
 
 /* Delete a queue */
 bool queue_delete(struct queue * queue) {
     INVALID_PTR_CHECK(queue, false);
-    linked_list_delete(queue->ll);
-    free_fptr(queue);
+    if (queue->buf != NULL) {
+        queue->allocator->free(queue->allocator_ctx, queue->buf);
+    }
+    queue_wait_destroy(queue);
+    queue->allocator->free(queue->allocator_ctx, queue);
     return true;
 }
 
-/* Push new data onto the end of the queue */
-bool queue_push(struct queue * queue, unsigned int data) {
-    INVALID_PTR_CHECK(queue, false);
+/* Move the entries into a buffer of at least min_capacity entries,
+   doubling, and unwrap them so the oldest lands at index 0 */
+static bool grow(struct queue * queue, size_t min_capacity) {
+    size_t capacity = queue->capacity ? queue->capacity : QUEUE_INITIAL_CAPACITY;
+    while (capacity < min_capacity) {
+        if (capacity > SIZE_MAX / 2 / sizeof(unsigned int)) {
+            return false;
+        }
+        capacity *= 2;
+    }
+    unsigned int * buf = queue->allocator->malloc(queue->allocator_ctx, capacity * sizeof(unsigned int));
+    INVALID_PTR_CHECK(buf, false);
+    if (queue->buf != NULL) {
+        ring_read(queue, buf, queue->len);
+        queue->allocator->free(queue->allocator_ctx, queue->buf);
+    }
+    queue->buf = buf;
+    queue->capacity = capacity;
+    queue->head = 0;
+    return true;
+}
 
-    if (!linked_list_insert_end(queue->ll, data)) {
+/* Append one value */
+static bool push(struct queue * queue, unsigned int data) {
+    if (queue->len == queue->capacity && !grow(queue, queue->len + 1)) {
         return false;
     }
 
+    queue->buf[(queue->head + queue->len) & (queue->capacity - 1)] = data;
     ++queue->len;
     return true;
 }
 
-/* Pop data from the head of the queue */
-bool queue_pop(struct queue * queue, unsigned int * popped_data __attribute__((unused))) {
-    INVALID_PTR_CHECK(queue, false);
-
+/* Take the oldest value */
+static bool pop(struct queue * queue, unsigned int * popped_data) {
     /* Return early if there is no data to pop */
     if (!queue->len) {
-        popped_data = NULL;
         return false;
     }
 
-    /* Set the pointer to the data to pop */
-    *popped_data = queue->ll->head->data;
-
-    /* Remove the first element of the queue. */
-    bool ret = linked_list_remove(queue->ll, 0);
+    *popped_data = queue->buf[queue->head];
+    queue->head = (queue->head + 1) & (queue->capacity - 1);
     --queue->len;
+    return true;
+}
+
+/* Push a run of values, growing at most once */
+static bool push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    if (n > SIZE_MAX - queue->len) {
+        return false;
+    }
+    if (queue->capacity - queue->len < n && !grow(queue, queue->len + n)) {
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+
+    size_t tail = (queue->head + queue->len) & (queue->capacity - 1);
+    size_t first = queue->capacity - tail;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(&queue->buf[tail], vals, first * sizeof(unsigned int));
+    memcpy(queue->buf, &vals[first], (n - first) * sizeof(unsigned int));
+    queue->len += n;
+    return true;
+}
 
-    return ret;
+/* Take up to max of the oldest values */
+static size_t pop_many(struct queue * queue, unsigned int * out, size_t max) {
+    size_t n = (max < queue->len) ? max : queue->len;
+    if (n == 0) {
+        return 0;
+    }
+    ring_read(queue, out, n);
+    queue->head = (queue->head + n) & (queue->capacity - 1);
+    queue->len -= n;
+    return n;
+}
+
+/* Peek at the oldest value */
+static bool next(struct queue * queue, unsigned int * popped_data) {
+    if (!queue->len) {
+        return false;
+    }
+
+    *popped_data = queue->buf[queue->head];
+    return true;
+}
+
+/* Hooks for queue_wait.c */
+bool queue_backend_push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    return push_many(queue, vals, n);
+}
+
+void queue_backend_drop(struct queue * queue, size_t n) {
+    queue->head = (queue->head + n) & (queue->capacity - 1);
+    queue->len -= n;
+}
+
+/* Size the buffer for a bounded queue so pushes never allocate */
+bool queue_backend_reserve(struct queue * queue, size_t capacity) {
+    return grow(queue, capacity);
+}
+
+size_t queue_backend_capacity(struct queue * queue) {
+    return queue->capacity;
+}
+
+/* Move the entries into the smallest power of two buffer that holds both
+   them and min_capacity, or free the buffer if that is zero */
+void queue_backend_shrink(struct queue * queue, size_t min_capacity) {
+    size_t needed = (queue->len > min_capacity) ? queue->len : min_capacity;
+    if (needed == 0) {
+        if (queue->buf != NULL) {
+            queue->allocator->free(queue->allocator_ctx, queue->buf);
+        }
+        queue->buf = NULL;
+        queue->capacity = 0;
+        queue->head = 0;
+        return;
+    }
+    size_t capacity = 1;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    if (capacity >= queue->capacity) {
+        return;
+    }
+    unsigned int * buf = queue->allocator->malloc(queue->allocator_ctx, capacity * sizeof(unsigned int));
+    if (buf == NULL) {
+        return;
+    }
+    ring_read(queue, buf, queue->len);
+    queue->allocator->free(queue->allocator_ctx, queue->buf);
+    queue->buf = buf;
+    queue->capacity = capacity;
+    queue->head = 0;
+}
+
+/* Push new data onto the end of the queue */
+bool queue_push(struct queue * queue, unsigned int data) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    size_t added = 0;
+    bool pushed = queue_bounded(queue) ? queue_push_bounded(queue, &data, 1, &added) : push(queue, data);
+    size_t high_water = queue_high_water_check(queue);
+    queue_unlock(queue);
+    queue_notify(queue, pushed ? 1 : 0);
+    queue_report_high_water(queue, high_water);
+    return pushed;
+}
+
+/* Pop data from the head of the queue */
+bool queue_pop(struct queue * queue, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    bool popped = pop(queue, popped_data);
+    queue_high_water_rearm(queue);
+    queue_shrink_check(queue);
+    queue_unlock(queue);
+    queue_notify_space(queue, popped ? 1 : 0);
+    return popped;
+}
+
+/* Push a run of values */
+bool queue_push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(queue, false);
+    INVALID_PTR_CHECK(vals, false);
+    queue_lock(queue);
+    size_t added = 0;
+    bool pushed;
+    if (queue_bounded(queue)) {
+        pushed = queue_push_bounded(queue, vals, n, &added);
+    }
+    else {
+        pushed = push_many(queue, vals, n);
+        added = pushed ? n : 0;
+    }
+    size_t high_water = queue_high_water_check(queue);
+    queue_unlock(queue);
+    queue_notify(queue, added);
+    queue_report_high_water(queue, high_water);
+    return pushed;
+}
+
+/* Pop up to max values from the head of the queue */
+size_t queue_pop_many(struct queue * queue, unsigned int * out, size_t max) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(out, SIZE_MAX);
+    queue_lock(queue);
+    size_t popped = pop_many(queue, out, max);
+    queue_high_water_rearm(queue);
+    queue_shrink_check(queue);
+    queue_unlock(queue);
+    queue_notify_space(queue, popped);
+    return popped;
 }
 
 /* Get the size of the queue */
 size_t queue_size(struct queue * queue) {
     INVALID_PTR_CHECK(queue, SIZE_MAX);
-    return queue->len;
+    queue_lock(queue);
+    size_t len = queue->len;
+    queue_unlock(queue);
+    return len;
 }
 
 /* Check if the queue contains readable data */
 bool queue_has_next(struct queue * queue) {
-    INVALID_PTR_CHECK(queue, false);
-    return queue->len ? true : false;
+    size_t len = queue_size(queue);
+    return len != 0 && len != SIZE_MAX;
 }
 
 /* Return the head of the queue in a passed parameter */
-bool queue_next(struct queue * queue, unsigned int * popped_data __attribute__((unused))){
+bool queue_next(struct queue * queue, unsigned int * popped_data) {
     INVALID_PTR_CHECK(queue, false);
-    if (!queue->len) {
-        popped_data = NULL;
-        return false;
-    }
-    
-    *popped_data = queue->ll->head->data;
-    return true;
+    queue_lock(queue);
+    bool found = next(queue, popped_data);
+    queue_unlock(queue);
+    return found;
 }
@@ -25,10 +25,14 @@ SOFTWARE.
 #ifndef _QUEUE_H
 #define _QUEUE_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 #include "linked_list.h"
 
 // Some rules for Pointer Wars 2025 week 2:
 // 0. Implement all functions in queue.c
+//    (or queue_chunked.c when built with QUEUE_CHUNKED_BACKEND).
 // 1. Feel free to add members to the structures, but please do not remove 
 //    any or rename any. Doing so will cause test infrastructure to fail
 //    to link against your shared library.
@@ -38,13 +42,121 @@ SOFTWARE.
 //    test infrastructure a bit more flexility. See linked_list.c for
 //    declarations of those function pointers.
 
+// What a push does when a bounded queue is full, see
+// queue_create_bounded().
+//
+enum queue_overflow_policy {
+    QUEUE_OVERFLOW_FAIL,          // The push returns FALSE
+    QUEUE_OVERFLOW_BLOCK,         // The producer waits for a pop to make room
+    QUEUE_OVERFLOW_OVERWRITE,     // The oldest entries are dropped
+};
+
+struct queue;
+
+// Called when a queue's length reaches its high water mark, see
+// queue_set_high_water_mark().
+//
+typedef void (*queue_high_water_fn)(struct queue * queue, size_t len, void * ctx);
+
+#ifndef QUEUE_CHUNKED_BACKEND
+
+// Capacity of a queue's buffer when it is first allocated. Must be a
+// power of two.
+//
+#define QUEUE_INITIAL_CAPACITY (16)
+
 // Definition of the queue.
+// Entries live in a circular buffer of capacity entries, a power of two so
+// positions wrap by masking. The oldest entry is at buf[head]. The buffer
+// is allocated on the first push and doubles when full. ll is no longer
+// used and stays NULL.
 // 
 struct queue {
     struct linked_list* ll;
     size_t len;
+    const struct ll_allocator * allocator;  // Never NULL, the registered malloc/free functions by default
+    void * allocator_ctx;
+    unsigned int * buf;
+    size_t capacity;
+    size_t head;
+    bool blocking;                // See queue_blocking_enable()
+    pthread_mutex_t lock;
+    _Atomic uint32_t wait_seq;
+    _Atomic uint32_t waiters;
+    size_t limit;                 // SIZE_MAX unless bounded, see queue_create_bounded()
+    enum queue_overflow_policy policy;
+    _Atomic uint32_t space_seq;
+    _Atomic uint32_t space_waiters;
+#ifndef __linux__
+    pthread_cond_t wait_cond;     // Stand in for futexes on wait_seq and space_seq
+    pthread_cond_t space_cond;
+#endif
+    size_t high_water_mark;       // SIZE_MAX unless set, see queue_set_high_water_mark()
+    bool high_water_armed;
+    queue_high_water_fn high_water;
+    void * high_water_ctx;
+    unsigned int shrink_percent;  // 0 unless set, see queue_set_shrink_policy()
+    size_t shrink_period;
+    size_t shrink_quiet;          // Pops in a row below shrink_percent
+};
+
+#else
+
+// Chunked queue (queue_chunked.c, see QUEUE_BACKEND in the Makefile).
+// Entries live in a chain of fixed size blocks: push appends to the tail
+// block, pop consumes from the head block, and a block emptied by pop is
+// kept in a small pool for the next push to reuse. Growing never copies,
+// and after a spike at most QUEUE_BLOCK_POOL spare blocks stay allocated.
+//
+#define QUEUE_BLOCK_BYTES       (4096)
+#define QUEUE_BLOCK_ENTRIES     ((QUEUE_BLOCK_BYTES - sizeof(void *)) / sizeof(unsigned int))
+#define QUEUE_BLOCK_POOL        (2)
+
+// Entries the first allocation holds.
+//
+#define QUEUE_INITIAL_CAPACITY  QUEUE_BLOCK_ENTRIES
+
+struct queue_block {
+    struct queue_block * next;
+    unsigned int data[QUEUE_BLOCK_ENTRIES];
+};
+
+// Definition of the queue. The oldest entry is head_block->data[head], the
+// next push goes to tail_block->data[tail]. ll is not used and stays NULL.
+//
+struct queue {
+    struct linked_list* ll;
+    size_t len;
+    const struct ll_allocator * allocator;  // Never NULL, the registered malloc/free functions by default
+    void * allocator_ctx;
+    struct queue_block * head_block;
+    struct queue_block * tail_block;
+    size_t head;
+    size_t tail;
+    struct queue_block * pool;
+    size_t pool_count;
+    bool blocking;                // See queue_blocking_enable()
+    pthread_mutex_t lock;
+    _Atomic uint32_t wait_seq;
+    _Atomic uint32_t waiters;
+    size_t limit;                 // SIZE_MAX unless bounded, see queue_create_bounded()
+    enum queue_overflow_policy policy;
+    _Atomic uint32_t space_seq;
+    _Atomic uint32_t space_waiters;
+#ifndef __linux__
+    pthread_cond_t wait_cond;     // Stand in for futexes on wait_seq and space_seq
+    pthread_cond_t space_cond;
+#endif
+    size_t high_water_mark;       // SIZE_MAX unless set, see queue_set_high_water_mark()
+    bool high_water_armed;
+    queue_high_water_fn high_water;
+    void * high_water_ctx;
+    unsigned int shrink_percent;  // 0 unless set, see queue_set_shrink_policy()
+    size_t shrink_period;
+    size_t shrink_quiet;          // Pops in a row below shrink_percent
 };
 
+#endif
 
 // Creates a new queue.
 // PRECONDITION: Register malloc() and free() functions via the
@@ -60,6 +172,17 @@ struct queue * queue_create(void);
 //
 bool queue_delete(struct queue * queue);
 
+// Creates a new queue that allocates from its own allocator. The queue
+// and its buffer both use ops.
+// \param ops : Allocator, must outlive the queue. NULL for the functions
+//              registered with queue_register_malloc() and
+//              queue_register_free(), like queue_create().
+// \param ctx : Passed to every ops call.
+// Returns a new queue on success, NULL on failure.
+//
+struct queue * queue_create_with_allocator(const struct ll_allocator * ops,
+                                           void * ctx);
+
 // Pushes an unsigned int onto the queue.
 // \param queue : Pointer to queue.
 // \param data  : Data to insert.
@@ -74,6 +197,24 @@ bool queue_push(struct queue * queue, unsigned int data);
 //
 bool queue_pop(struct queue * queue, unsigned int * popped_data); 
 
+// Pushes n unsigned ints onto the queue, in order, copying them in as
+// whole runs rather than one at a time. Either all of them are pushed or,
+// if memory runs out, none (but see QUEUE_OVERFLOW_BLOCK below).
+// \param queue : Pointer to queue.
+// \param vals  : Values to push.
+// \param n     : Number of values.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_push_many(struct queue * queue, const unsigned int * vals, size_t n);
+
+// Pops up to max unsigned ints from the queue, oldest first.
+// \param queue : Pointer to queue.
+// \param out   : Receives the popped values (provided by caller).
+// \param max   : Capacity of out.
+// Returns the number of values popped, SIZE_MAX on failure.
+//
+size_t queue_pop_many(struct queue * queue, unsigned int * out, size_t max);
+
 // Returns the size of the queue.
 // \param queue : Pointer to queue.
 // Returns size on success, SIZE_MAX otherwise.
@@ -94,16 +235,128 @@ bool queue_has_next(struct queue * queue);
 //
 bool queue_next(struct queue * queue, unsigned int * popped_data);
 
+// Blocking mode.
+//
+// A queue in blocking mode may be shared between threads: every queue
+// function takes the queue's lock, and consumers can wait for entries with
+// queue_pop_wait() instead of polling. A waiting consumer first spins for
+// QUEUE_WAIT_SPINS attempts, then parks on a futex. Pushes only make a
+// system call when a consumer is parked, and then wake one parked consumer
+// per value pushed.
+
+#define QUEUE_WAIT_SPINS    (128)
+#define QUEUE_WAIT_FOREVER  (UINT64_MAX)
+
+// Switches a queue into blocking mode. There is no way back.
+// PRECONDITION: No other thread is using the queue yet.
+// \param queue : Pointer to queue.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_blocking_enable(struct queue * queue);
+
+// Pops an unsigned int from the queue, waiting up to timeout_ns for one to
+// be pushed if the queue is empty. Without blocking mode it doesn't wait.
+// \param queue       : Pointer to queue.
+// \param popped_data : Pointer to popped data (provided by caller), if pop occurs.
+// \param timeout_ns  : Longest wait in nanoseconds, QUEUE_WAIT_FOREVER for no limit.
+// Returns TRUE on success, FALSE on timeout or failure.
+//
+bool queue_pop_wait(struct queue * queue, unsigned int * popped_data, uint64_t timeout_ns);
+
+// Bounded mode.
+//
+// A bounded queue never holds more than its capacity. A push that would
+// go past it fails, waits, or drops the oldest entries, depending on the
+// queue's policy. A queue_push_many() of more values than fit:
+//  QUEUE_OVERFLOW_FAIL      : pushes none of them.
+//  QUEUE_OVERFLOW_BLOCK     : pushes them in order as room frees up, so
+//                             other producers' values may interleave. If
+//                             memory runs out part way, the values
+//                             already pushed stay and it returns FALSE.
+//  QUEUE_OVERFLOW_OVERWRITE : keeps the newest capacity values.
+// The ring backend allocates the whole capacity up front, so a bounded
+// ring queue never allocates on push.
+
+// Creates a new bounded queue. A QUEUE_OVERFLOW_BLOCK queue is created in
+// blocking mode, since only another thread can make room.
+// PRECONDITION: Register malloc() and free() functions via the
+//               queue_register_malloc() and
+//               queue_register_free() functions.
+// \param capacity : Most entries the queue holds, at least 1.
+// \param policy   : What a push does when the queue is full.
+// Returns a new queue on success, NULL on failure.
+//
+struct queue * queue_create_bounded(size_t capacity, enum queue_overflow_policy policy);
+
+// Creates a new bounded queue that allocates from its own allocator, see
+// queue_create_bounded() and queue_create_with_allocator().
+// \param capacity : Most entries the queue holds, at least 1.
+// \param policy   : What a push does when the queue is full.
+// \param ops      : Allocator, must outlive the queue. NULL for the
+//                   registered functions, like queue_create_bounded().
+// \param ctx      : Passed to every ops call.
+// Returns a new queue on success, NULL on failure.
+//
+struct queue * queue_create_bounded_with_allocator(size_t capacity,
+                                                   enum queue_overflow_policy policy,
+                                                   const struct ll_allocator * ops,
+                                                   void * ctx);
+
+// Sets a callback for when the queue's length reaches mark. It is called
+// once, from the pushing thread after the queue's lock is released, and
+// armed again once the queue drains to mark / 2. Works on any queue, a
+// bounded queue can use its capacity as the mark to learn when it is full.
+// \param queue    : Pointer to queue.
+// \param mark     : Length to report, at least 1.
+// \param callback : Function to call, NULL to remove the callback.
+// \param ctx      : Passed to callback.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_high_water_mark(struct queue * queue,
+                               size_t mark,
+                               queue_high_water_fn callback,
+                               void * ctx);
+
+// Shrinking.
+//
+// A queue keeps the memory it grew into until it is deleted, unless it is
+// shrunk. The ring backend shrinks by moving the entries into a smaller
+// buffer, the chunked backend by freeing its spare blocks. Shrinking is
+// best effort: if the smaller buffer can't be allocated the queue stays
+// as it is. A bounded ring queue keeps room for its capacity.
+
+// Makes the queue shrink on its own once it has been mostly empty for a
+// while. Every pop checks the queue's length against its capacity, and
+// after period pops in a row with the length below occupancy_percent of
+// the capacity the queue shrinks, keeping room for twice its length.
+// \param queue             : Pointer to queue.
+// \param occupancy_percent : 1 to 100, or 0 to stop shrinking.
+// \param period            : Pops in a row below the occupancy, at least 1.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_shrink_policy(struct queue * queue,
+                             unsigned int occupancy_percent,
+                             size_t period);
+
+// Releases all the memory the queue's entries don't need right now. An
+// empty queue frees its buffer or blocks entirely.
+// \param queue : Pointer to queue.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_shrink_to_fit(struct queue * queue);
+
 // Registers malloc() function.
+// Queues created without their own allocator use it for the queue and its
+// buffer. Lists are not affected.
 // \param malloc : Function pointer to malloc()-like function.
-// POSTCONDITION: Initializes malloc() function pointer in linked_list.
 // Returns TRUE on success, FALSE otherwise.
 //
 bool queue_register_malloc(void * (*malloc)(size_t));
 
 // Registers free() function.
+// Queues created without their own allocator use it for the queue and its
+// buffer. Lists are not affected.
 // \param free : Function pointer to free()-like function.
-// POSTCONDITION: Initializes free() functional pointer in linked_list.
 // Returns TRUE on success, FALSE otherwise.
 //
 bool queue_register_free(void (*free)(void*));
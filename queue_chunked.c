@@ -0,0 +1,407 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Chunked queue backend. Built in place of queue.c when
+   QUEUE_CHUNKED_BACKEND is defined (see QUEUE_BACKEND in the Makefile).
+
+   Entries are stored in 4 KB blocks linked head to tail. A push that finds
+   the tail block full links a new one, a pop that empties the head block
+   unlinks it. Unlinked blocks go to a pool of at most QUEUE_BLOCK_POOL
+   blocks, so a queue that oscillates around a block boundary doesn't call
+   malloc() every time, while the blocks of a past spike are released as
+   the queue drains. */
+
+#include "queue.h"
+#include "queue_wait.h"
+#include "stdlib.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL; 
+
+_Static_assert(sizeof(struct queue_block) <= QUEUE_BLOCK_BYTES,
+               "a queue block must fit in QUEUE_BLOCK_BYTES");
+
+/* Queues without their own allocator use an allocator that forwards to
+   the functions registered here */
+static void * registered_malloc(void * ctx, size_t size) {
+    (void)ctx;
+    return malloc_fptr(size);
+}
+
+static void registered_free(void * ctx, void * addr) {
+    (void)ctx;
+    free_fptr(addr);
+}
+
+static const struct ll_allocator registered_allocator = {
+    .malloc = registered_malloc,
+    .free   = registered_free,
+};
+
+/* Register a user-specified malloc method */
+bool queue_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register a user-specified free method */
+bool queue_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free; 
+    return true;
+}
+
+/* Take a block from the pool, or allocate one */
+static struct queue_block * block_take(struct queue * queue) {
+    struct queue_block * block = queue->pool;
+    if (block != NULL) {
+        queue->pool = block->next;
+        --queue->pool_count;
+    } else {
+        block = queue->allocator->malloc(queue->allocator_ctx, sizeof(struct queue_block));
+        INVALID_PTR_CHECK(block, NULL);
+    }
+    block->next = NULL;
+    return block;
+}
+
+/* Return a block to the pool, or free it if the pool is full */
+static void block_release(struct queue * queue, struct queue_block * block) {
+    if (queue->pool_count < QUEUE_BLOCK_POOL) {
+        block->next = queue->pool;
+        queue->pool = block;
+        ++queue->pool_count;
+    } else {
+        queue->allocator->free(queue->allocator_ctx, block);
+    }
+}
+
+/* Free a chain of blocks */
+static void free_blocks(struct queue * queue, struct queue_block * block) {
+    while (block != NULL) {
+        struct queue_block * next = block->next;
+        queue->allocator->free(queue->allocator_ctx, block);
+        block = next;
+    }
+}
+
+/* Create a queue */
+struct queue * queue_create(void) {
+    return queue_create_with_allocator(NULL, NULL);
+}
+
+/* Create a queue on its own allocator */
+struct queue * queue_create_with_allocator(const struct ll_allocator * ops, void * ctx) {
+    if (ops == NULL) {
+        ops = &registered_allocator;
+    }
+    struct queue *q = (struct queue *) ops->malloc(ctx, sizeof(struct queue));
+    INVALID_PTR_CHECK(q, NULL);
+    q->allocator = ops;
+    q->allocator_ctx = ctx;
+    q->ll = NULL;
+    q->len = 0;
+    q->head_block = NULL;
+    q->tail_block = NULL;
+    q->head = 0;
+    q->tail = 0;
+    q->pool = NULL;
+    q->pool_count = 0;
+    queue_wait_init(q);
+    return q;
+}
+
+/* Delete a queue */
+bool queue_delete(struct queue * queue) {
+    INVALID_PTR_CHECK(queue, false);
+    free_blocks(queue, queue->head_block);
+    free_blocks(queue, queue->pool);
+    queue_wait_destroy(queue);
+    queue->allocator->free(queue->allocator_ctx, queue);
+    return true;
+}
+
+/* Append one value */
+static bool push(struct queue * queue, unsigned int data) {
+    if (queue->tail_block == NULL || queue->tail == QUEUE_BLOCK_ENTRIES) {
+        struct queue_block * block = block_take(queue);
+        INVALID_PTR_CHECK(block, false);
+        if (queue->tail_block == NULL) {
+            queue->head_block = block;
+            queue->head = 0;
+        } else {
+            queue->tail_block->next = block;
+        }
+        queue->tail_block = block;
+        queue->tail = 0;
+    }
+
+    queue->tail_block->data[queue->tail++] = data;
+    ++queue->len;
+    return true;
+}
+
+/* Take the oldest value */
+static bool pop(struct queue * queue, unsigned int * popped_data) {
+    /* Return early if there is no data to pop */
+    if (!queue->len) {
+        return false;
+    }
+
+    *popped_data = queue->head_block->data[queue->head++];
+    --queue->len;
+
+    /* An empty queue starts over at the front of its only block, a
+       drained head block is recycled */
+    if (!queue->len) {
+        queue->head = 0;
+        queue->tail = 0;
+    } else if (queue->head == QUEUE_BLOCK_ENTRIES) {
+        struct queue_block * drained = queue->head_block;
+        queue->head_block = drained->next;
+        queue->head = 0;
+        block_release(queue, drained);
+    }
+    return true;
+}
+
+/* Push a run of values. The blocks it needs beyond the tail block are
+   taken up front, so running out of memory leaves the queue untouched. */
+static bool push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    size_t space = (queue->tail_block == NULL) ? 0 : QUEUE_BLOCK_ENTRIES - queue->tail;
+    size_t needed = (n > space) ? (n - space + QUEUE_BLOCK_ENTRIES - 1) / QUEUE_BLOCK_ENTRIES : 0;
+    struct queue_block * chain = NULL;
+    struct queue_block * chain_tail = NULL;
+    for (size_t i = 0; i < needed; i++) {
+        struct queue_block * block = block_take(queue);
+        if (block == NULL) {
+            while (chain != NULL) {
+                struct queue_block * next = chain->next;
+                block_release(queue, chain);
+                chain = next;
+            }
+            return false;
+        }
+        if (chain == NULL) {
+            chain = block;
+        } else {
+            chain_tail->next = block;
+        }
+        chain_tail = block;
+    }
+
+    if (chain != NULL) {
+        if (queue->tail_block == NULL) {
+            queue->head_block = chain;
+            queue->head = 0;
+            queue->tail_block = chain;
+            queue->tail = 0;
+        } else {
+            queue->tail_block->next = chain;
+        }
+    }
+    queue->len += n;
+    while (n != 0) {
+        if (queue->tail == QUEUE_BLOCK_ENTRIES) {
+            queue->tail_block = queue->tail_block->next;
+            queue->tail = 0;
+        }
+        size_t run = QUEUE_BLOCK_ENTRIES - queue->tail;
+        if (run > n) {
+            run = n;
+        }
+        memcpy(&queue->tail_block->data[queue->tail], vals, run * sizeof(unsigned int));
+        queue->tail += run;
+        vals += run;
+        n -= run;
+    }
+    return true;
+}
+
+/* Take up to max of the oldest values, a block's worth at a time */
+static size_t pop_many(struct queue * queue, unsigned int * out, size_t max) {
+    size_t popped = 0;
+    while (popped < max && queue->len != 0) {
+        size_t run = (queue->head_block == queue->tail_block ? queue->tail : QUEUE_BLOCK_ENTRIES) - queue->head;
+        if (run > max - popped) {
+            run = max - popped;
+        }
+        memcpy(&out[popped], &queue->head_block->data[queue->head], run * sizeof(unsigned int));
+        popped += run;
+        queue->head += run;
+        queue->len -= run;
+
+        if (!queue->len) {
+            queue->head = 0;
+            queue->tail = 0;
+        } else if (queue->head == QUEUE_BLOCK_ENTRIES) {
+            struct queue_block * drained = queue->head_block;
+            queue->head_block = drained->next;
+            queue->head = 0;
+            block_release(queue, drained);
+        }
+    }
+    return popped;
+}
+
+/* Peek at the oldest value */
+static bool next(struct queue * queue, unsigned int * popped_data) {
+    if (!queue->len) {
+        return false;
+    }
+
+    *popped_data = queue->head_block->data[queue->head];
+    return true;
+}
+
+/* Hooks for queue_wait.c */
+bool queue_backend_push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    return push_many(queue, vals, n);
+}
+
+void queue_backend_drop(struct queue * queue, size_t n) {
+    unsigned int dropped;
+    while (n-- != 0) {
+        pop(queue, &dropped);
+    }
+}
+
+/* Blocks are taken as the queue fills, nothing to do up front */
+bool queue_backend_reserve(struct queue * queue, size_t capacity) {
+    (void)queue;
+    (void)capacity;
+    return true;
+}
+
+/* Entries the chained blocks and the pool can hold */
+size_t queue_backend_capacity(struct queue * queue) {
+    size_t chained = (queue->head_block == NULL) ? 0 : queue->head + queue->len + QUEUE_BLOCK_ENTRIES - queue->tail;
+    return chained + queue->pool_count * QUEUE_BLOCK_ENTRIES;
+}
+
+/* Free the pool, and the last block too once the queue is empty and
+   min_capacity allows it. Chained blocks are full apart from the ends, so
+   there is nothing else to give back. */
+void queue_backend_shrink(struct queue * queue, size_t min_capacity) {
+    free_blocks(queue, queue->pool);
+    queue->pool = NULL;
+    queue->pool_count = 0;
+    if (queue->len == 0 && min_capacity == 0 && queue->head_block != NULL) {
+        free_blocks(queue, queue->head_block);
+        queue->head_block = NULL;
+        queue->tail_block = NULL;
+        queue->head = 0;
+        queue->tail = 0;
+    }
+}
+
+/* Push new data onto the end of the queue */
+bool queue_push(struct queue * queue, unsigned int data) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    size_t added = 0;
+    bool pushed = queue_bounded(queue) ? queue_push_bounded(queue, &data, 1, &added) : push(queue, data);
+    size_t high_water = queue_high_water_check(queue);
+    queue_unlock(queue);
+    queue_notify(queue, pushed ? 1 : 0);
+    queue_report_high_water(queue, high_water);
+    return pushed;
+}
+
+/* Pop data from the head of the queue */
+bool queue_pop(struct queue * queue, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    bool popped = pop(queue, popped_data);
+    queue_high_water_rearm(queue);
+    queue_shrink_check(queue);
+    queue_unlock(queue);
+    queue_notify_space(queue, popped ? 1 : 0);
+    return popped;
+}
+
+/* Push a run of values */
+bool queue_push_many(struct queue * queue, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(queue, false);
+    INVALID_PTR_CHECK(vals, false);
+    queue_lock(queue);
+    size_t added = 0;
+    bool pushed;
+    if (queue_bounded(queue)) {
+        pushed = queue_push_bounded(queue, vals, n, &added);
+    }
+    else {
+        pushed = push_many(queue, vals, n);
+        added = pushed ? n : 0;
+    }
+    size_t high_water = queue_high_water_check(queue);
+    queue_unlock(queue);
+    queue_notify(queue, added);
+    queue_report_high_water(queue, high_water);
+    return pushed;
+}
+
+/* Pop up to max values from the head of the queue */
+size_t queue_pop_many(struct queue * queue, unsigned int * out, size_t max) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(out, SIZE_MAX);
+    queue_lock(queue);
+    size_t popped = pop_many(queue, out, max);
+    queue_high_water_rearm(queue);
+    queue_shrink_check(queue);
+    queue_unlock(queue);
+    queue_notify_space(queue, popped);
+    return popped;
+}
+
+/* Get the size of the queue */
+size_t queue_size(struct queue * queue) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    queue_lock(queue);
+    size_t len = queue->len;
+    queue_unlock(queue);
+    return len;
+}
+
+/* Check if the queue contains readable data */
+bool queue_has_next(struct queue * queue) {
+    size_t len = queue_size(queue);
+    return len != 0 && len != SIZE_MAX;
+}
+
+/* Return the head of the queue in a passed parameter */
+bool queue_next(struct queue * queue, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    bool found = next(queue, popped_data);
+    queue_unlock(queue);
+    return found;
+}
@@ -1,17 +1,25 @@
+#define _GNU_SOURCE
 #include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #ifdef COMPILE_ARM_PMU_CODE
 #include "arm_pmu.h"
 #endif
 
 #include "mmio.h"
+#include "mpmc_queue.h"
+#include "pqueue.h"
 #include "queue.h"
 #include "slab_allocator.h"
+#include "spsc_queue.h"
+#include "ws_deque.h"
 
 // A hacky adjacency matrix. 
 //
@@ -94,51 +102,53 @@ long compute_timespec_diff(struct timespec start,
     return nanoseconds;
 }
 
+// Nodes popped off the BFS queue at a time.
+//
+#define BFS_POP_BATCH (256)
+
 bool breadth_first_search(unsigned int i, unsigned int j) {
     struct queue * queue = queue_create();
 
     bool found_path = false;
-    unsigned int next_node = i;
+    unsigned int batch[BFS_POP_BATCH];
+    size_t batch_len = 1;
+    size_t batch_pos = 0;
+    batch[0] = i;
     size_t node_count = 0;
     struct timespec start, stop;
     GRAB_CLOCK(start)
     while(!found_path) {
-        // Push data onto the queue.
+        // Pop the next batch of rows off the queue.
         //
-        struct row * row = rows[next_node];
+        if (batch_pos == batch_len) {
+            batch_len = queue_pop_many(queue, batch, BFS_POP_BATCH);
+            batch_pos = 0;
+            if (batch_len == 0 || batch_len == SIZE_MAX) {
+                break;
+            }
+        }
+        unsigned int next_node = batch[batch_pos++];
+        ++node_count;
 
+        struct row * row = rows[next_node];
         if (row == NULL || row->visited) {
-            bool not_done = queue_pop(queue, &next_node);
-            ++node_count;
-            if (!not_done) break;
             continue;
-        } else {
-            row->visited = true;
         }
+        row->visited = true;
 
-        if (row != NULL) {
-            for(size_t node = 0; node < row->size; node++) {
-                unsigned int data = row->adjacent_nodes[node];
-                // Check if we found the node.
-                //
-                if (j == data) {
-                    found_path = true;
-                }
-                bool sanity = queue_push(queue, row->adjacent_nodes[node]);
-                if (!sanity) {
-                    printf("Error pushing into queue.\n");
-                    return 1;
-                }
+        // Check if we found the node, then push the whole row onto the
+        // queue.
+        //
+        for(size_t node = 0; node < row->size; node++) {
+            if (j == row->adjacent_nodes[node]) {
+                found_path = true;
             }
         }
-
-        // Pop the next row off the queue.
-        //
-        bool full = queue_pop(queue, &next_node);
-        if (!full) {
-            break;
+        bool sanity = queue_push_many(queue, row->adjacent_nodes, row->size);
+        if (!sanity) {
+            printf("Error pushing into queue.\n");
+            return 1;
         }
-        ++node_count;
     }
     queue_delete(queue);
     GRAB_CLOCK(stop)
@@ -193,7 +203,581 @@ void add_edge(unsigned int i, unsigned int j) {
     }
 }
 
-int main(void) {
+// Pins the calling thread to a CPU, modulo the number online.
+//
+void pin_thread(long cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % (cpus > 0 ? cpus : 1), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Waiting side of a benchmark loop. Spins for a while, then yields so a
+// benchmark pinned to a single CPU still makes progress.
+//
+#define BENCH_SPINS  (1024)
+
+static inline void bench_backoff(unsigned int * spins) {
+    if (++*spins >= BENCH_SPINS) {
+        sched_yield();
+        *spins = 0;
+    }
+}
+
+// SPSC queue benchmark. A producer pinned to CPU 0 streams SPSC_VALUES
+// values to a consumer pinned to CPU 1, first one at a time then in
+// batches. Latency is the mean round trip of one value bounced back over
+// a second queue, halved.
+//
+#define SPSC_CAPACITY      (4096)
+#define SPSC_VALUES        (20u * 1000u * 1000u)
+#define SPSC_BATCH         (64)
+#define SPSC_ROUND_TRIPS   (100000u)
+
+struct spsc_bench {
+    struct spsc_queue * to_consumer;
+    struct spsc_queue * to_producer;
+    size_t batch;
+    pthread_barrier_t start;
+};
+
+void * spsc_consumer_run(void * arg) {
+    struct spsc_bench * bench = arg;
+    pin_thread(1);
+    pthread_barrier_wait(&bench->start);
+    unsigned int out[SPSC_BATCH];
+    unsigned int spins = 0;
+    unsigned long long sum = 0;
+    for (size_t received = 0; received < SPSC_VALUES; ) {
+        size_t n = (bench->batch == 1) ? spsc_queue_pop(bench->to_consumer, out)
+                                       : spsc_queue_pop_bulk(bench->to_consumer, out, bench->batch);
+        if (n == 0) {
+            bench_backoff(&spins);
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            sum += out[i];
+        }
+        received += n;
+    }
+    if (sum != (unsigned long long)SPSC_VALUES * (SPSC_VALUES - 1) / 2) {
+        printf("SPSC consumer received the wrong values.\n");
+        exit(1);
+    }
+    return NULL;
+}
+
+void * spsc_echo_run(void * arg) {
+    struct spsc_bench * bench = arg;
+    pin_thread(1);
+    pthread_barrier_wait(&bench->start);
+    unsigned int spins = 0;
+    for (size_t i = 0; i < SPSC_ROUND_TRIPS; i++) {
+        unsigned int data;
+        while (!spsc_queue_pop(bench->to_consumer, &data)) {
+            bench_backoff(&spins);
+        }
+        while (!spsc_queue_push(bench->to_producer, data)) {
+            bench_backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+void spsc_benchmark(void) {
+    spsc_queue_register_malloc(malloc);
+    spsc_queue_register_free(free);
+    struct spsc_bench bench;
+    bench.to_consumer = spsc_queue_create(SPSC_CAPACITY);
+    bench.to_producer = spsc_queue_create(SPSC_CAPACITY);
+    if (bench.to_consumer == NULL || bench.to_producer == NULL) {
+        printf("Failed to create spsc_queue.\n");
+        exit(1);
+    }
+    printf("SPSC queue benchmark, %u values, capacity %d, %ld CPUs\n",
+           SPSC_VALUES, SPSC_CAPACITY, sysconf(_SC_NPROCESSORS_ONLN));
+    pin_thread(0);
+
+    const size_t batches[] = {1, SPSC_BATCH};
+    for (size_t b = 0; b < 2; b++) {
+        bench.batch = batches[b];
+        pthread_barrier_init(&bench.start, NULL, 2);
+        pthread_t consumer;
+        pthread_create(&consumer, NULL, spsc_consumer_run, &bench);
+
+        unsigned int vals[SPSC_BATCH];
+        unsigned int spins = 0;
+        struct timespec start, stop;
+        pthread_barrier_wait(&bench.start);
+        GRAB_CLOCK(start)
+        for (unsigned int next = 0; next < SPSC_VALUES; ) {
+            size_t n;
+            if (bench.batch == 1) {
+                n = spsc_queue_push(bench.to_consumer, next);
+            } else {
+                size_t want = (SPSC_VALUES - next < bench.batch) ? SPSC_VALUES - next : bench.batch;
+                for (size_t i = 0; i < want; i++) {
+                    vals[i] = next + i;
+                }
+                n = spsc_queue_push_bulk(bench.to_consumer, vals, want);
+            }
+            if (n == 0) {
+                bench_backoff(&spins);
+            }
+            next += n;
+        }
+        pthread_join(consumer, NULL);
+        GRAB_CLOCK(stop)
+        pthread_barrier_destroy(&bench.start);
+        double seconds = (double)compute_timespec_diff(start, stop) / 1000000000.0;
+        printf("Batch %2zu throughput [Mops/s]: %0.3f\n", bench.batch, SPSC_VALUES / seconds / 1000000.0);
+    }
+
+    pthread_barrier_init(&bench.start, NULL, 2);
+    pthread_t echo;
+    pthread_create(&echo, NULL, spsc_echo_run, &bench);
+    unsigned int spins = 0;
+    struct timespec start, stop;
+    pthread_barrier_wait(&bench.start);
+    GRAB_CLOCK(start)
+    for (unsigned int i = 0; i < SPSC_ROUND_TRIPS; i++) {
+        unsigned int data;
+        spsc_queue_push(bench.to_consumer, i);
+        while (!spsc_queue_pop(bench.to_producer, &data)) {
+            bench_backoff(&spins);
+        }
+    }
+    GRAB_CLOCK(stop)
+    pthread_join(echo, NULL);
+    pthread_barrier_destroy(&bench.start);
+    printf("One-way latency [ns]: %0.1f\n\n",
+           (double)compute_timespec_diff(start, stop) / SPSC_ROUND_TRIPS / 2.0);
+
+    spsc_queue_delete(bench.to_consumer);
+    spsc_queue_delete(bench.to_producer);
+}
+
+// MPMC queue contention benchmark. Every thread alternates a push and a
+// pop on one shared queue, so all threads are producers and consumers at
+// once. The queue starts half full so neither side runs dry.
+//
+#define MPMC_CAPACITY         (1024)
+#define MPMC_OPS_PER_THREAD   (2u * 1000u * 1000u)
+#define MPMC_MIN_THREADS      (4u)
+#define MPMC_MAX_THREADS      (16u)
+
+struct mpmc_worker {
+    pthread_t thread;
+    struct mpmc_queue * queue;
+    pthread_barrier_t * start;
+    long cpu;
+};
+
+void * mpmc_worker_run(void * arg) {
+    struct mpmc_worker * worker = arg;
+    pin_thread(worker->cpu);
+    pthread_barrier_wait(worker->start);
+    unsigned int spins = 0;
+    for (unsigned int i = 0; i < MPMC_OPS_PER_THREAD / 2; i++) {
+        unsigned int data;
+        while (!mpmc_queue_try_push(worker->queue, i)) {
+            bench_backoff(&spins);
+        }
+        while (!mpmc_queue_try_pop(worker->queue, &data)) {
+            bench_backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+void mpmc_benchmark(void) {
+    mpmc_queue_register_malloc(malloc);
+    mpmc_queue_register_free(free);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    // Always go a little past one thread, so contention is exercised even
+    // on small machines.
+    unsigned int max_threads = (cpus < MPMC_MIN_THREADS) ? MPMC_MIN_THREADS : (unsigned int)cpus;
+    if (max_threads > MPMC_MAX_THREADS) {
+        max_threads = MPMC_MAX_THREADS;
+    }
+    printf("MPMC queue benchmark, capacity %d, %u ops per thread, %ld CPUs\n",
+           MPMC_CAPACITY, MPMC_OPS_PER_THREAD, cpus);
+
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        struct mpmc_queue * queue = mpmc_queue_create(MPMC_CAPACITY);
+        if (queue == NULL) {
+            printf("Failed to create mpmc_queue.\n");
+            exit(1);
+        }
+        for (unsigned int i = 0; i < MPMC_CAPACITY / 2; i++) {
+            mpmc_queue_try_push(queue, i);
+        }
+
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, threads + 1);
+        struct mpmc_worker workers[MPMC_MAX_THREADS];
+        for (unsigned int i = 0; i < threads; i++) {
+            workers[i].queue = queue;
+            workers[i].start = &start;
+            workers[i].cpu = i;
+            pthread_create(&workers[i].thread, NULL, mpmc_worker_run, &workers[i]);
+        }
+
+        struct timespec begin, stop;
+        pthread_barrier_wait(&start);
+        GRAB_CLOCK(begin)
+        for (unsigned int i = 0; i < threads; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        GRAB_CLOCK(stop)
+        pthread_barrier_destroy(&start);
+
+        double seconds = (double)compute_timespec_diff(begin, stop) / 1000000000.0;
+        double mops = (double)threads * MPMC_OPS_PER_THREAD / seconds / 1000000.0;
+        printf("Threads %2u [Mops/s]: %0.3f\n", threads, mops);
+        mpmc_queue_delete(queue);
+    }
+    printf("\n");
+}
+
+// Work-stealing BFS benchmark. A synthetic graph with the Wikipedia
+// graph's problem, a few hubs with thousands of edges among many nodes
+// with a handful, is searched from node 0 once with the serial queue
+// and then with the frontier spread over a ws_pool of 1, 2, 4, ...
+// threads. Each task expands one node and spawns its unvisited
+// neighbours, so a hub's edges are stolen by whichever threads are idle.
+//
+#define STEAL_NODES        (1u << 20)
+#define STEAL_DEGREE       (8u)
+#define STEAL_HUB_DEGREE   (4096u)
+#define STEAL_HUB_EVERY    (1024u)
+#define STEAL_MIN_THREADS  (4u)
+#define STEAL_MAX_THREADS  (16u)
+
+struct steal_graph {
+    size_t * offsets;
+    unsigned int * targets;
+    _Atomic unsigned char * visited;
+};
+
+void steal_task(struct ws_worker * worker, unsigned int node, void * ctx) {
+    struct steal_graph * graph = ctx;
+    for (size_t e = graph->offsets[node]; e < graph->offsets[node + 1]; e++) {
+        unsigned int next = graph->targets[e];
+        if (atomic_load_explicit(&graph->visited[next], memory_order_relaxed) == 0 &&
+            atomic_exchange_explicit(&graph->visited[next], 1, memory_order_relaxed) == 0) {
+            ws_pool_spawn(worker, next);
+        }
+    }
+}
+
+size_t steal_count_visited(struct steal_graph * graph) {
+    size_t visited = 0;
+    for (size_t i = 0; i < STEAL_NODES; i++) {
+        visited += graph->visited[i];
+        graph->visited[i] = 0;
+    }
+    return visited;
+}
+
+void steal_benchmark(void) {
+    ws_deque_register_malloc(malloc);
+    ws_deque_register_free(free);
+
+    struct steal_graph graph;
+    graph.offsets = malloc((STEAL_NODES + 1) * sizeof(size_t));
+    graph.visited = calloc(STEAL_NODES, sizeof(*graph.visited));
+    size_t edges = 0;
+    for (size_t i = 0; i < STEAL_NODES; i++) {
+        graph.offsets[i] = edges;
+        edges += (i % STEAL_HUB_EVERY == 0) ? STEAL_HUB_DEGREE : 1 + (size_t)rand() % (2 * STEAL_DEGREE - 1);
+    }
+    graph.offsets[STEAL_NODES] = edges;
+    graph.targets = malloc(edges * sizeof(unsigned int));
+    if (graph.offsets == NULL || graph.visited == NULL || graph.targets == NULL) {
+        printf("Failed to allocate graph.\n");
+        exit(1);
+    }
+    for (size_t e = 0; e < edges; e++) {
+        graph.targets[e] = (unsigned int)rand() % STEAL_NODES;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("Work-stealing BFS benchmark, %u nodes, %zu edges, %ld CPUs\n", STEAL_NODES, edges, cpus);
+
+    queue_register_malloc(malloc);
+    queue_register_free(free);
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    struct queue * queue = queue_create();
+    graph.visited[0] = 1;
+    unsigned int node = 0;
+    do {
+        for (size_t e = graph.offsets[node]; e < graph.offsets[node + 1]; e++) {
+            unsigned int next = graph.targets[e];
+            if (!graph.visited[next]) {
+                graph.visited[next] = 1;
+                queue_push(queue, next);
+            }
+        }
+    } while (queue_pop(queue, &node));
+    queue_delete(queue);
+    GRAB_CLOCK(stop)
+    size_t visited = steal_count_visited(&graph);
+    printf("Serial queue   visited %zu [ms]: %0.3f\n", visited, (double)compute_timespec_diff(start, stop) / 1000000.0);
+
+    unsigned int max_threads = (cpus < STEAL_MIN_THREADS) ? STEAL_MIN_THREADS : (unsigned int)cpus;
+    if (max_threads > STEAL_MAX_THREADS) {
+        max_threads = STEAL_MAX_THREADS;
+    }
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        struct ws_pool * pool = ws_pool_create(threads);
+        if (pool == NULL) {
+            printf("Failed to create ws_pool.\n");
+            exit(1);
+        }
+        const unsigned int root = 0;
+        GRAB_CLOCK(start)
+        graph.visited[root] = 1;
+        bool ok = ws_pool_run(pool, &root, 1, steal_task, &graph);
+        GRAB_CLOCK(stop)
+        visited = steal_count_visited(&graph);
+        printf("Threads %2u     visited %zu [ms]: %0.3f%s\n", threads, visited,
+               (double)compute_timespec_diff(start, stop) / 1000000.0, ok ? "" : " (spawn failed)");
+        ws_pool_delete(pool);
+    }
+    printf("\n");
+
+    free(graph.offsets);
+    free(graph.targets);
+    free((void *)graph.visited);
+}
+
+// Blocking queue benchmark. Latency is the mean round trip of one value
+// bounced between two threads over a pair of blocking queues, halved.
+// Idle cost is the CPU time a consumer burns waiting WAIT_IDLE_NS on an
+// empty queue, which should be little more than the spin phase.
+//
+#define WAIT_ROUND_TRIPS   (100000u)
+#define WAIT_IDLE_NS       (100ull * 1000ull * 1000ull)
+
+struct wait_bench {
+    struct queue * to_echo;
+    struct queue * to_main;
+    long idle_cpu_ns;
+};
+
+void * wait_echo_run(void * arg) {
+    struct wait_bench * bench = arg;
+    pin_thread(1);
+    unsigned int data;
+    for (size_t i = 0; i < WAIT_ROUND_TRIPS; i++) {
+        queue_pop_wait(bench->to_echo, &data, QUEUE_WAIT_FOREVER);
+        queue_push(bench->to_main, data);
+    }
+    return NULL;
+}
+
+void * wait_idle_run(void * arg) {
+    struct wait_bench * bench = arg;
+    unsigned int data;
+    struct timespec start, stop;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    queue_pop_wait(bench->to_echo, &data, WAIT_IDLE_NS);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stop);
+    bench->idle_cpu_ns = compute_timespec_diff(start, stop);
+    return NULL;
+}
+
+void wait_benchmark(void) {
+    queue_register_malloc(malloc);
+    queue_register_free(free);
+    struct wait_bench bench;
+    bench.to_echo = queue_create();
+    bench.to_main = queue_create();
+    if (bench.to_echo == NULL || bench.to_main == NULL ||
+        !queue_blocking_enable(bench.to_echo) || !queue_blocking_enable(bench.to_main)) {
+        printf("Failed to create blocking queue.\n");
+        exit(1);
+    }
+    printf("Blocking queue benchmark, %u round trips, %ld CPUs\n",
+           WAIT_ROUND_TRIPS, sysconf(_SC_NPROCESSORS_ONLN));
+    pin_thread(0);
+
+    pthread_t echo;
+    pthread_create(&echo, NULL, wait_echo_run, &bench);
+    struct timespec start, stop;
+    GRAB_CLOCK(start)
+    for (unsigned int i = 0; i < WAIT_ROUND_TRIPS; i++) {
+        unsigned int data;
+        queue_push(bench.to_echo, i);
+        queue_pop_wait(bench.to_main, &data, QUEUE_WAIT_FOREVER);
+    }
+    GRAB_CLOCK(stop)
+    pthread_join(echo, NULL);
+    printf("One-way wakeup latency [ns]: %0.1f\n",
+           (double)compute_timespec_diff(start, stop) / WAIT_ROUND_TRIPS / 2.0);
+
+    pthread_t idle;
+    pthread_create(&idle, NULL, wait_idle_run, &bench);
+    pthread_join(idle, NULL);
+    printf("CPU time of a %llu ms idle wait [us]: %0.1f\n\n",
+           WAIT_IDLE_NS / 1000000ull, bench.idle_cpu_ns / 1000.0);
+
+    queue_delete(bench.to_echo);
+    queue_delete(bench.to_main);
+}
+
+// Shortest path benchmark. Dijkstra from node 0 over a random weighted
+// graph, once with the d-ary heap and decrease-key, once with the radix
+// heap and lazy deletion. The Wikipedia matrix is a pattern matrix with
+// no values, so the weights are drawn at random.
+//
+#define DIJKSTRA_NODES       (1u << 20)
+#define DIJKSTRA_DEGREE      (8u)
+#define DIJKSTRA_MAX_WEIGHT  (1000u)
+
+struct dijkstra_graph {
+    size_t * offsets;
+    unsigned int * targets;
+    unsigned int * weights;
+    unsigned int * dist;
+};
+
+size_t dijkstra_pqueue(struct dijkstra_graph * graph) {
+    struct pqueue * pqueue = pqueue_create(DIJKSTRA_NODES);
+    size_t settled = 0;
+    unsigned int node, dist;
+    graph->dist[0] = 0;
+    pqueue_push(pqueue, 0, 0);
+    while (pqueue_pop(pqueue, &node, &dist)) {
+        ++settled;
+        for (size_t e = graph->offsets[node]; e < graph->offsets[node + 1]; e++) {
+            unsigned int next = graph->targets[e];
+            unsigned int candidate = dist + graph->weights[e];
+            if (candidate < graph->dist[next]) {
+                bool queued = (graph->dist[next] != UINT_MAX);
+                graph->dist[next] = candidate;
+                if (queued) {
+                    pqueue_decrease_key(pqueue, next, candidate);
+                } else {
+                    pqueue_push(pqueue, next, candidate);
+                }
+            }
+        }
+    }
+    pqueue_delete(pqueue);
+    return settled;
+}
+
+size_t dijkstra_radix_heap(struct dijkstra_graph * graph) {
+    struct radix_heap * heap = radix_heap_create();
+    size_t settled = 0;
+    unsigned int node, dist;
+    graph->dist[0] = 0;
+    radix_heap_push(heap, 0, 0);
+    while (radix_heap_pop(heap, &node, &dist)) {
+        if (dist != graph->dist[node]) {
+            continue;
+        }
+        ++settled;
+        for (size_t e = graph->offsets[node]; e < graph->offsets[node + 1]; e++) {
+            unsigned int next = graph->targets[e];
+            unsigned int candidate = dist + graph->weights[e];
+            if (candidate < graph->dist[next]) {
+                graph->dist[next] = candidate;
+                radix_heap_push(heap, next, candidate);
+            }
+        }
+    }
+    radix_heap_delete(heap);
+    return settled;
+}
+
+void dijkstra_benchmark(void) {
+    pqueue_register_malloc(malloc);
+    pqueue_register_free(free);
+
+    struct dijkstra_graph graph;
+    size_t edges = (size_t)DIJKSTRA_NODES * DIJKSTRA_DEGREE;
+    graph.offsets = malloc((DIJKSTRA_NODES + 1) * sizeof(size_t));
+    graph.targets = malloc(edges * sizeof(unsigned int));
+    graph.weights = malloc(edges * sizeof(unsigned int));
+    graph.dist = malloc(DIJKSTRA_NODES * sizeof(unsigned int));
+    unsigned int * reference = malloc(DIJKSTRA_NODES * sizeof(unsigned int));
+    if (graph.offsets == NULL || graph.targets == NULL || graph.weights == NULL ||
+        graph.dist == NULL || reference == NULL) {
+        printf("Failed to allocate graph.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i <= DIJKSTRA_NODES; i++) {
+        graph.offsets[i] = i * DIJKSTRA_DEGREE;
+    }
+    for (size_t e = 0; e < edges; e++) {
+        graph.targets[e] = (unsigned int)rand() % DIJKSTRA_NODES;
+        graph.weights[e] = 1 + (unsigned int)rand() % DIJKSTRA_MAX_WEIGHT;
+    }
+    printf("Dijkstra benchmark, %u nodes, %zu edges\n", DIJKSTRA_NODES, edges);
+
+    struct timespec start, stop;
+    memset(graph.dist, 0xff, DIJKSTRA_NODES * sizeof(unsigned int));
+    GRAB_CLOCK(start)
+    size_t settled = dijkstra_pqueue(&graph);
+    GRAB_CLOCK(stop)
+    printf("%d-ary heap  settled %zu [ms]: %0.3f\n", PQUEUE_ARITY, settled,
+           (double)compute_timespec_diff(start, stop) / 1000000.0);
+    memcpy(reference, graph.dist, DIJKSTRA_NODES * sizeof(unsigned int));
+
+    memset(graph.dist, 0xff, DIJKSTRA_NODES * sizeof(unsigned int));
+    GRAB_CLOCK(start)
+    settled = dijkstra_radix_heap(&graph);
+    GRAB_CLOCK(stop)
+    printf("Radix heap  settled %zu [ms]: %0.3f\n", settled,
+           (double)compute_timespec_diff(start, stop) / 1000000.0);
+    if (memcmp(reference, graph.dist, DIJKSTRA_NODES * sizeof(unsigned int)) != 0) {
+        printf("The heaps disagree on the shortest paths.\n");
+        exit(1);
+    }
+    printf("\n");
+
+    free(graph.offsets);
+    free(graph.targets);
+    free(graph.weights);
+    free(graph.dist);
+    free(reference);
+}
+
+struct benchmark {
+    const char * name;
+    void (*run)(void);
+};
+
+struct benchmark benchmarks[] = {
+    {"spsc", spsc_benchmark},
+    {"mpmc", mpmc_benchmark},
+    {"steal", steal_benchmark},
+    {"wait", wait_benchmark},
+    {"dijkstra", dijkstra_benchmark},
+    {NULL, NULL},
+};
+
+// Runs the queue benchmarks named on the command line, or the BFS over
+// the Wikipedia graph when none are given.
+//
+int main(int argc, char ** argv) {
+    if (argc >= 2) {
+        for (struct benchmark * b = benchmarks; b->name != NULL; b++) {
+            for (int i = 1; i < argc; i++) {
+                if (strcmp(argv[i], b->name) == 0) {
+                    b->run();
+                }
+            }
+        }
+        return 0;
+    }
+
+
 
     // Initialize malloc() and free()
     //
@@ -0,0 +1,327 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* Blocking mode, bounded mode and shrinking for both queue backends, see
+   queue_wait.h.
+
+   Parked consumers sleep on the futex word wait_seq. A consumer counts
+   itself in waiters and reads wait_seq before its last attempt to pop;
+   a producer that sees waiters bumps wait_seq before waking, so a
+   consumer that was about to park fails its FUTEX_WAIT instead of
+   missing the push.
+
+   Producers blocked on a full bounded queue do the same on space_seq and
+   space_waiters, except that they count themselves and read space_seq
+   while still holding the lock, so the pop that makes room always comes
+   after them.
+
+   Futexes are Linux only. Elsewhere each futex word has a condition
+   variable on the queue's lock standing in for it: a sleeper checks the
+   word with the lock held before waiting, and a waker takes the lock
+   between bumping the word and signalling, so the bump can't fall
+   between the check and the wait. */
+
+#include "limits.h"
+#include "queue_wait.h"
+#include "time.h"
+#ifdef __linux__
+#include "linux/futex.h"
+#include "sys/syscall.h"
+#include "unistd.h"
+
+static long futex(_Atomic uint32_t * addr, int op, uint32_t val, const struct timespec * timeout) {
+    return syscall(SYS_futex, (uint32_t *) addr, op, val, timeout, NULL, 0);
+}
+#else
+static pthread_cond_t * cond_of(struct queue * queue, _Atomic uint32_t * word) {
+    return (word == &queue->wait_seq) ? &queue->wait_cond : &queue->space_cond;
+}
+#endif
+
+/* Sleep until word moves on from seq or a wake arrives, for at most
+   timeout if it isn't NULL. Called without the lock. */
+static void park(struct queue * queue, _Atomic uint32_t * word, uint32_t seq, const struct timespec * timeout) {
+#ifdef __linux__
+    (void) queue;
+    futex(word, FUTEX_WAIT_PRIVATE, seq, timeout);
+#else
+    pthread_mutex_lock(&queue->lock);
+    if (atomic_load(word) == seq) {
+        if (timeout == NULL) {
+            pthread_cond_wait(cond_of(queue, word), &queue->lock);
+        }
+        else {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += timeout->tv_sec;
+            deadline.tv_nsec += timeout->tv_nsec;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(cond_of(queue, word), &queue->lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+#endif
+}
+
+/* Bump word and wake up to n threads parked on it. held says whether the
+   caller holds the lock. */
+static void wake(struct queue * queue, _Atomic uint32_t * word, size_t n, bool held) {
+    atomic_fetch_add(word, 1);
+#ifdef __linux__
+    (void) queue;
+    (void) held;
+    futex(word, FUTEX_WAKE_PRIVATE, (n > INT_MAX) ? INT_MAX : (uint32_t) n, NULL);
+#else
+    if (!held) {
+        pthread_mutex_lock(&queue->lock);
+    }
+    if (n == 1) {
+        pthread_cond_signal(cond_of(queue, word));
+    }
+    else {
+        pthread_cond_broadcast(cond_of(queue, word));
+    }
+    if (!held) {
+        pthread_mutex_unlock(&queue->lock);
+    }
+#endif
+}
+
+/* Wake up to n parked consumers */
+void queue_wake_waiters(struct queue * queue, size_t n) {
+    wake(queue, &queue->wait_seq, n, false);
+}
+
+/* Wake up to n producers waiting for room */
+void queue_wake_producers(struct queue * queue, size_t n) {
+    wake(queue, &queue->space_seq, n, false);
+}
+
+/* Switch a queue into blocking mode */
+bool queue_blocking_enable(struct queue * queue) {
+    INVALID_PTR_CHECK(queue, false);
+    queue->blocking = true;
+    return true;
+}
+
+/* Pop, spinning and then parking until a value arrives or time runs out */
+bool queue_pop_wait(struct queue * queue, unsigned int * popped_data, uint64_t timeout_ns) {
+    INVALID_PTR_CHECK(queue, false);
+    INVALID_PTR_CHECK(popped_data, false);
+    if (queue_pop(queue, popped_data)) {
+        return true;
+    }
+    if (!queue->blocking || timeout_ns == 0) {
+        return false;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < QUEUE_WAIT_SPINS; i++) {
+        if (queue_pop(queue, popped_data)) {
+            return true;
+        }
+    }
+
+    for (;;) {
+        atomic_fetch_add(&queue->waiters, 1);
+        uint32_t seq = atomic_load(&queue->wait_seq);
+        if (queue_pop(queue, popped_data)) {
+            atomic_fetch_sub(&queue->waiters, 1);
+            return true;
+        }
+
+        struct timespec remaining;
+        struct timespec * timeout = NULL;
+        if (timeout_ns != QUEUE_WAIT_FOREVER) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            uint64_t elapsed = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000000ull + now.tv_nsec - start.tv_nsec;
+            if (elapsed >= timeout_ns) {
+                atomic_fetch_sub(&queue->waiters, 1);
+                return false;
+            }
+            remaining.tv_sec = (timeout_ns - elapsed) / 1000000000ull;
+            remaining.tv_nsec = (timeout_ns - elapsed) % 1000000000ull;
+            timeout = &remaining;
+        }
+        park(queue, &queue->wait_seq, seq, timeout);
+        atomic_fetch_sub(&queue->waiters, 1);
+    }
+}
+
+/* Create a bounded queue */
+struct queue * queue_create_bounded(size_t capacity, enum queue_overflow_policy policy) {
+    return queue_create_bounded_with_allocator(capacity, policy, NULL, NULL);
+}
+
+/* Create a bounded queue on its own allocator */
+struct queue * queue_create_bounded_with_allocator(size_t capacity, enum queue_overflow_policy policy,
+                                                   const struct ll_allocator * ops, void * ctx) {
+    if (capacity == 0 || capacity == SIZE_MAX) {
+        return NULL;
+    }
+    if (policy != QUEUE_OVERFLOW_FAIL && policy != QUEUE_OVERFLOW_BLOCK && policy != QUEUE_OVERFLOW_OVERWRITE) {
+        return NULL;
+    }
+    struct queue * queue = queue_create_with_allocator(ops, ctx);
+    INVALID_PTR_CHECK(queue, NULL);
+    if (!queue_backend_reserve(queue, capacity)) {
+        queue_delete(queue);
+        return NULL;
+    }
+    queue->limit = capacity;
+    queue->policy = policy;
+    queue->blocking = (policy == QUEUE_OVERFLOW_BLOCK);
+    return queue;
+}
+
+/* Release the lock until a pop makes room */
+static void wait_for_space(struct queue * queue) {
+    atomic_fetch_add(&queue->space_waiters, 1);
+    uint32_t seq = atomic_load(&queue->space_seq);
+    pthread_mutex_unlock(&queue->lock);
+    park(queue, &queue->space_seq, seq, NULL);
+    pthread_mutex_lock(&queue->lock);
+    atomic_fetch_sub(&queue->space_waiters, 1);
+}
+
+/* Push onto a bounded queue following its overflow policy, counting the
+   values that went in */
+bool queue_push_bounded(struct queue * queue, const unsigned int * vals, size_t n, size_t * added) {
+    size_t room = queue->limit - queue->len;
+    *added = 0;
+    switch (queue->policy) {
+    case QUEUE_OVERFLOW_FAIL:
+        if (n > room || !queue_backend_push_many(queue, vals, n)) {
+            return false;
+        }
+        *added = n;
+        return true;
+
+    case QUEUE_OVERFLOW_OVERWRITE: {
+        // Only the newest limit values can survive the push
+        size_t keep = (n > queue->limit) ? queue->limit : n;
+        if (keep > room) {
+            queue_backend_drop(queue, keep - room);
+        }
+        if (!queue_backend_push_many(queue, vals + (n - keep), keep)) {
+            return false;
+        }
+        *added = keep;
+        return true;
+    }
+
+    case QUEUE_OVERFLOW_BLOCK:
+        // Values pushed before a failure stay, so they are counted too
+        while (n - *added > room) {
+            if (room != 0) {
+                if (!queue_backend_push_many(queue, vals + *added, room)) {
+                    return false;
+                }
+                *added += room;
+                // Consumers must see the partial push or nobody makes room
+                if (atomic_load(&queue->waiters) != 0) {
+                    wake(queue, &queue->wait_seq, room, true);
+                }
+            }
+            wait_for_space(queue);
+            room = queue->limit - queue->len;
+        }
+        if (!queue_backend_push_many(queue, vals + *added, n - *added)) {
+            return false;
+        }
+        *added = n;
+        return true;
+    }
+    return false;
+}
+
+/* Set or clear the high water callback */
+bool queue_set_high_water_mark(struct queue * queue, size_t mark, queue_high_water_fn callback, void * ctx) {
+    INVALID_PTR_CHECK(queue, false);
+    if (mark == 0) {
+        return false;
+    }
+    queue_lock(queue);
+    queue->high_water_mark = (callback != NULL) ? mark : SIZE_MAX;
+    queue->high_water_armed = true;
+    queue->high_water = callback;
+    queue->high_water_ctx = ctx;
+    queue_unlock(queue);
+    return true;
+}
+
+/* Smallest capacity a shrink may leave. A bounded queue keeps room for
+   its capacity, which only the ring backend reserves. */
+static size_t shrink_floor(struct queue * queue, size_t min_capacity) {
+    if (queue_bounded(queue) && queue->limit > min_capacity) {
+        return queue->limit;
+    }
+    return min_capacity;
+}
+
+/* Count a pop towards the shrink policy */
+void queue_shrink_idle(struct queue * queue) {
+    if (queue->len * 100 >= queue_backend_capacity(queue) * queue->shrink_percent) {
+        queue->shrink_quiet = 0;
+        return;
+    }
+    if (++queue->shrink_quiet < queue->shrink_period) {
+        return;
+    }
+    queue->shrink_quiet = 0;
+    size_t headroom = (queue->len > SIZE_MAX / 2) ? SIZE_MAX : 2 * queue->len;
+    if (headroom < QUEUE_INITIAL_CAPACITY) {
+        headroom = QUEUE_INITIAL_CAPACITY;
+    }
+    queue_backend_shrink(queue, shrink_floor(queue, headroom));
+}
+
+/* Set or clear the shrink policy */
+bool queue_set_shrink_policy(struct queue * queue, unsigned int occupancy_percent, size_t period) {
+    INVALID_PTR_CHECK(queue, false);
+    if (occupancy_percent > 100 || (occupancy_percent != 0 && period == 0)) {
+        return false;
+    }
+    queue_lock(queue);
+    queue->shrink_percent = occupancy_percent;
+    queue->shrink_period = period;
+    queue->shrink_quiet = 0;
+    queue_unlock(queue);
+    return true;
+}
+
+/* Release the memory the entries don't need */
+bool queue_shrink_to_fit(struct queue * queue) {
+    INVALID_PTR_CHECK(queue, false);
+    queue_lock(queue);
+    queue_backend_shrink(queue, shrink_floor(queue, 0));
+    queue->shrink_quiet = 0;
+    queue_unlock(queue);
+    return true;
+}
@@ -0,0 +1,178 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUEUE_WAIT_H_
+#define QUEUE_WAIT_H_
+
+#include "queue.h"
+
+/* Internal to the queue backends (queue.c, queue_chunked.c) and
+   queue_wait.c, which implements blocking mode (queue_blocking_enable(),
+   queue_pop_wait()), bounded mode (queue_create_bounded(),
+   queue_set_high_water_mark()) and shrinking (queue_set_shrink_policy(),
+   queue_shrink_to_fit()) for both of them.
+
+   Every public queue function brackets its work with queue_lock() and
+   queue_unlock(), which cost a predictable branch outside blocking mode.
+   Pushes go through queue_push_bounded() when the queue is bounded and
+   check the high water mark before unlocking. After unlocking, anything
+   that pushed calls queue_notify() with the number of values pushed and
+   queue_report_high_water(). Anything that popped calls
+   queue_shrink_check() before unlocking and queue_notify_space() with
+   the number of values popped after. */
+
+// Implemented by each backend, called with the lock held.
+//
+bool queue_backend_push_many(struct queue * queue, const unsigned int * vals, size_t n);
+void queue_backend_drop(struct queue * queue, size_t n);
+bool queue_backend_reserve(struct queue * queue, size_t capacity);
+size_t queue_backend_capacity(struct queue * queue);
+void queue_backend_shrink(struct queue * queue, size_t min_capacity);
+
+// Pushes n values onto a bounded queue following its overflow policy.
+// Called with the lock held, which QUEUE_OVERFLOW_BLOCK releases while
+// it waits. Sets *added to how many values went into the queue, for
+// queue_notify(): fewer than n when QUEUE_OVERFLOW_OVERWRITE keeps only
+// the newest capacity values, or when QUEUE_OVERFLOW_BLOCK fails part
+// way. Returns TRUE on success, FALSE otherwise.
+//
+bool queue_push_bounded(struct queue * queue, const unsigned int * vals, size_t n, size_t * added);
+
+// Counts a pop towards the shrink policy and shrinks once it is due.
+// Called with the lock held.
+//
+void queue_shrink_idle(struct queue * queue);
+
+// Wakes up to n consumers parked in queue_pop_wait().
+//
+void queue_wake_waiters(struct queue * queue, size_t n);
+
+// Wakes up to n producers waiting for room in a QUEUE_OVERFLOW_BLOCK queue.
+//
+void queue_wake_producers(struct queue * queue, size_t n);
+
+static inline void queue_lock(struct queue * queue) {
+    if (queue->blocking) {
+        pthread_mutex_lock(&queue->lock);
+    }
+}
+
+static inline void queue_unlock(struct queue * queue) {
+    if (queue->blocking) {
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+static inline bool queue_bounded(struct queue * queue) {
+    return queue->limit != SIZE_MAX;
+}
+
+// The waiters load pairs with the increment in queue_pop_wait(): either
+// the pusher sees the waiter, or the waiter's pop sees the value.
+//
+static inline void queue_notify(struct queue * queue, size_t n) {
+    if (queue->blocking && n != 0 && atomic_load(&queue->waiters) != 0) {
+        queue_wake_waiters(queue, n);
+    }
+}
+
+// Producers count themselves in space_waiters with the lock held, so a
+// pop that unlocked after them sees the count.
+//
+static inline void queue_notify_space(struct queue * queue, size_t n) {
+    if (queue->blocking && n != 0 && atomic_load(&queue->space_waiters) != 0) {
+        queue_wake_producers(queue, n);
+    }
+}
+
+// Called with the lock held after a push. Disarms the high water mark if
+// the queue reached it and returns the length to report, 0 otherwise.
+//
+static inline size_t queue_high_water_check(struct queue * queue) {
+    if (queue->len < queue->high_water_mark || !queue->high_water_armed) {
+        return 0;
+    }
+    queue->high_water_armed = false;
+    return queue->len;
+}
+
+// Called with the lock held after a pop.
+//
+static inline void queue_high_water_rearm(struct queue * queue) {
+    if (!queue->high_water_armed && queue->len <= queue->high_water_mark / 2) {
+        queue->high_water_armed = true;
+    }
+}
+
+// Called with the lock held after a pop.
+//
+static inline void queue_shrink_check(struct queue * queue) {
+    if (queue->shrink_percent != 0) {
+        queue_shrink_idle(queue);
+    }
+}
+
+// Called after unlocking with what queue_high_water_check() returned.
+//
+static inline void queue_report_high_water(struct queue * queue, size_t len) {
+    if (len != 0 && queue->high_water != NULL) {
+        queue->high_water(queue, len, queue->high_water_ctx);
+    }
+}
+
+// Sets up the blocking, bounded and shrink fields of a newly created queue.
+//
+static inline void queue_wait_init(struct queue * queue) {
+    queue->blocking = false;
+    pthread_mutex_init(&queue->lock, NULL);
+    atomic_init(&queue->wait_seq, 0);
+    atomic_init(&queue->waiters, 0);
+    queue->limit = SIZE_MAX;
+    queue->policy = QUEUE_OVERFLOW_FAIL;
+    atomic_init(&queue->space_seq, 0);
+    atomic_init(&queue->space_waiters, 0);
+#ifndef __linux__
+    pthread_cond_init(&queue->wait_cond, NULL);
+    pthread_cond_init(&queue->space_cond, NULL);
+#endif
+    queue->high_water_mark = SIZE_MAX;
+    queue->high_water_armed = true;
+    queue->high_water = NULL;
+    queue->high_water_ctx = NULL;
+    queue->shrink_percent = 0;
+    queue->shrink_period = 0;
+    queue->shrink_quiet = 0;
+}
+
+// Tears down what queue_wait_init() set up, when the queue is deleted.
+//
+static inline void queue_wait_destroy(struct queue * queue) {
+    pthread_mutex_destroy(&queue->lock);
+#ifndef __linux__
+    pthread_cond_destroy(&queue->wait_cond);
+    pthread_cond_destroy(&queue->space_cond);
+#endif
+}
+
+#endif
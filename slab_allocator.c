@@ -48,6 +48,12 @@ static void slab_allocator_mutex_init(void) {
 /* Size of the node header, which contains the data size */
 #define NODE_HEADER_SIZE   (sizeof(uint32_t))
 
+/* Allocations of an unsupported size are passed through to stdlib malloc.
+   They carry a larger header so the returned pointer stays 16-byte aligned,
+   and its size word is set to LARGE_ALLOC_SIZE so free can tell them apart. */
+#define LARGE_ALLOC_HEADER_SIZE   (16)
+#define LARGE_ALLOC_SIZE          (0)
+
 /* Global allocator instance */
 static struct slab_allocator g_allocator = {0};
 
@@ -66,7 +72,7 @@ static inline void allocator_init(void) {
 }
 
 /* Map of allocation block size to slab list index.
-   Fatally errors on failure. */
+   Returns -1 if the size is not served by a slab. */
 static inline int supported_alloc_size_map(uint32_t alloc_size) {
     int idx = -1;
     for (int i = 0; i < MAX_SUPPORTED_SIZES; i++) {
@@ -75,13 +81,20 @@ static inline int supported_alloc_size_map(uint32_t alloc_size) {
            break; 
         }
     }
-    if (idx == -1) {
-        printf("Unsupported allocation size: %u.\n", alloc_size);
-        exit(1);
-    }
     return idx;
 }
 
+/* Pass an allocation of unsupported size through to stdlib malloc */
+static void *large_alloc_malloc(uint32_t alloc_size) {
+    uint8_t *block = malloc((size_t) alloc_size + LARGE_ALLOC_HEADER_SIZE);
+    if (block == NULL) {
+        return NULL;
+    }
+    uint8_t *ret = block + LARGE_ALLOC_HEADER_SIZE;
+    *((uint32_t *) ret - 1) = LARGE_ALLOC_SIZE;
+    return ret;
+}
+
 /* Create a slab. Initialize its parameters and partition 
    its nodes according to the required node size. */
 static struct slab *create_slab(uint32_t size_idx) {
@@ -210,6 +223,9 @@ void* slab_allocator_malloc(uint32_t alloc_size) {
 
     /* Find size idx */
     int size_idx = supported_alloc_size_map(alloc_size);
+    if (size_idx == -1) {
+        return large_alloc_malloc(alloc_size);
+    }
 
     /* Find a slab with free space */
     struct slab *slab = g_allocator.slabs[size_idx];
@@ -246,8 +262,18 @@ void slab_allocator_free(void* ptr) {
     /* Get the size of the block to be freed from the provided pointer */
     struct free_node *node = (struct free_node *) ((uint32_t *) ptr - 1);
 
+    /* Blocks of unsupported size came straight from stdlib malloc */
+    if (node->alloc_size == LARGE_ALLOC_SIZE) {
+        free((uint8_t *) ptr - LARGE_ALLOC_HEADER_SIZE);
+        return;
+    }
+
     /* Find size idx */
     int size_idx = supported_alloc_size_map(node->alloc_size);
+    if (size_idx == -1) {
+        printf("Unsupported allocation size: %u.\n", node->alloc_size);
+        exit(1);
+    }
 
     /* Iterate over slabs to find the slab that owns ptr */
     struct slab *slab = g_allocator.slabs[size_idx];
@@ -0,0 +1,192 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "linked_list.h"
+#include "spsc_queue.h"
+#include "stdlib.h"
+#include "string.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+//
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+/* Copy n values into the ring starting at index pos, wrapping at the end */
+static void ring_write(struct spsc_queue * queue, size_t pos, const unsigned int * vals, size_t n) {
+    size_t start = pos & queue->mask;
+    size_t first = queue->mask + 1 - start;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(&queue->buf[start], vals, first * sizeof(unsigned int));
+    memcpy(queue->buf, &vals[first], (n - first) * sizeof(unsigned int));
+}
+
+/* Copy n values out of the ring starting at index pos, wrapping at the end */
+static void ring_read(struct spsc_queue * queue, size_t pos, unsigned int * out, size_t n) {
+    size_t start = pos & queue->mask;
+    size_t first = queue->mask + 1 - start;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, &queue->buf[start], first * sizeof(unsigned int));
+    memcpy(&out[first], queue->buf, (n - first) * sizeof(unsigned int));
+}
+
+/* Create a queue */
+struct spsc_queue * spsc_queue_create(size_t capacity) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    if (capacity == 0 || capacity > SIZE_MAX / 2 / sizeof(unsigned int)) {
+        return NULL;
+    }
+    size_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    struct spsc_queue * queue = malloc_fptr(sizeof(struct spsc_queue));
+    INVALID_PTR_CHECK(queue, NULL);
+    queue->buf = malloc_fptr(size * sizeof(unsigned int));
+    if (queue->buf == NULL) {
+        free_fptr(queue);
+        return NULL;
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_tail = 0;
+    queue->cached_head = 0;
+    return queue;
+}
+
+/* Delete a queue */
+bool spsc_queue_delete(struct spsc_queue * queue) {
+    INVALID_PTR_CHECK(queue, false);
+    free_fptr(queue->buf);
+    free_fptr(queue);
+    return true;
+}
+
+/* Push from the producer. The consumer's head is only reloaded when the
+   cached copy says the ring is full. */
+bool spsc_queue_push(struct spsc_queue * queue, unsigned int data) {
+    INVALID_PTR_CHECK(queue, false);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - queue->cached_head > queue->mask) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail - queue->cached_head > queue->mask) {
+            return false;
+        }
+    }
+    queue->buf[tail & queue->mask] = data;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/* Pop from the consumer. The producer's tail is only reloaded when the
+   cached copy says the ring is empty. */
+bool spsc_queue_pop(struct spsc_queue * queue, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(queue, false);
+    INVALID_PTR_CHECK(popped_data, false);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == queue->cached_tail) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cached_tail) {
+            return false;
+        }
+    }
+    *popped_data = queue->buf[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+/* Push a batch with a single tail update */
+size_t spsc_queue_push_bulk(struct spsc_queue * queue, const unsigned int * vals, size_t n) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(vals, SIZE_MAX);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t space = queue->mask + 1 - (tail - queue->cached_head);
+    if (space < n) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        space = queue->mask + 1 - (tail - queue->cached_head);
+    }
+    if (n > space) {
+        n = space;
+    }
+    if (n != 0) {
+        ring_write(queue, tail, vals, n);
+        atomic_store_explicit(&queue->tail, tail + n, memory_order_release);
+    }
+    return n;
+}
+
+/* Pop a batch with a single head update */
+size_t spsc_queue_pop_bulk(struct spsc_queue * queue, unsigned int * out, size_t max) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    INVALID_PTR_CHECK(out, SIZE_MAX);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t available = queue->cached_tail - head;
+    if (available < max) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        available = queue->cached_tail - head;
+    }
+    if (max > available) {
+        max = available;
+    }
+    if (max != 0) {
+        ring_read(queue, head, out, max);
+        atomic_store_explicit(&queue->head, head + max, memory_order_release);
+    }
+    return max;
+}
+
+/* Get the number of entries, head first so the difference can't go negative */
+size_t spsc_queue_size(struct spsc_queue * queue) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    return tail - head;
+}
+
+/* Get the number of entries the ring holds */
+size_t spsc_queue_capacity(struct spsc_queue * queue) {
+    INVALID_PTR_CHECK(queue, SIZE_MAX);
+    return queue->mask + 1;
+}
+
+/* Register malloc function */
+bool spsc_queue_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register free function */
+bool spsc_queue_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A bounded lock-free queue of unsigned ints between exactly one producer
+   thread and one consumer thread.
+
+   The entries live in a power-of-two ring. head and tail count pops and
+   pushes since creation and are masked on access. Only the producer
+   writes tail, only the consumer writes head, and each publishes its
+   index with a release store after touching the ring so the other side's
+   acquire load sees the entries (or the freed slots) first. The two
+   indices sit on separate cache lines so the threads don't contend for
+   one line on every operation.
+
+   Each side also keeps a private copy of the other side's index and only
+   reloads it when the copy says the ring is full (or empty). In steady
+   state a push or pop then touches nothing the other thread writes. The
+   batch calls go one step further and publish a single index update for
+   the whole batch. */
+
+// Padding used to keep each side's indices on their own cache line.
+//
+#define SPSC_QUEUE_CACHE_LINE   (64)
+
+// Definition of the queue. The first group is written by the consumer,
+// the second by the producer, the last is read only after creation.
+//
+struct spsc_queue {
+    _Atomic size_t head;
+    size_t cached_tail;
+    char pad_consumer[SPSC_QUEUE_CACHE_LINE];
+    _Atomic size_t tail;
+    size_t cached_head;
+    char pad_producer[SPSC_QUEUE_CACHE_LINE];
+    unsigned int * buf;
+    size_t mask;
+};
+
+// Creates a new, empty queue.
+// PRECONDITION: Register malloc() and free() functions via the
+//               spsc_queue_register_malloc() and
+//               spsc_queue_register_free() functions.
+// \param capacity : Number of entries, rounded up to a power of two.
+// Returns a new spsc_queue on success, NULL on failure.
+//
+struct spsc_queue * spsc_queue_create(size_t capacity);
+
+// Deletes a queue.
+// PRECONDITION: Neither thread is using the queue.
+// \param queue : Pointer to queue to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool spsc_queue_delete(struct spsc_queue * queue);
+
+// Pushes an unsigned int onto the queue. Producer thread only.
+// \param queue : Pointer to queue.
+// \param data  : Data to insert.
+// Returns TRUE on success, FALSE if the queue is full or on failure.
+//
+bool spsc_queue_push(struct spsc_queue * queue, unsigned int data);
+
+// Pops an unsigned int from the queue. Consumer thread only.
+// \param queue       : Pointer to queue.
+// \param popped_data : Pointer to popped data (provided by caller), if pop occurs.
+// Returns TRUE on success, FALSE if the queue is empty or on failure.
+//
+bool spsc_queue_pop(struct spsc_queue * queue, unsigned int * popped_data);
+
+// Pushes up to n unsigned ints, publishing them to the consumer at once.
+// Producer thread only.
+// \param queue : Pointer to queue.
+// \param vals  : Values to push, in order.
+// \param n     : Number of values.
+// Returns the number of values pushed, fewer than n if the queue filled up,
+// SIZE_MAX on failure.
+//
+size_t spsc_queue_push_bulk(struct spsc_queue * queue,
+                            const unsigned int * vals,
+                            size_t n);
+
+// Pops up to max unsigned ints, handing their slots back to the producer
+// at once. Consumer thread only.
+// \param queue : Pointer to queue.
+// \param out   : Receives the popped values, in order.
+// \param max   : Capacity of out.
+// Returns the number of values popped, SIZE_MAX on failure.
+//
+size_t spsc_queue_pop_bulk(struct spsc_queue * queue,
+                           unsigned int * out,
+                           size_t max);
+
+// Returns the number of entries in the queue. From any thread other than
+// the producer or consumer this is a snapshot that may already be stale.
+// \param queue : Pointer to queue.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t spsc_queue_size(struct spsc_queue * queue);
+
+// Returns the number of entries the queue can hold.
+// \param queue : Pointer to queue.
+// Returns capacity on success, SIZE_MAX otherwise.
+//
+size_t spsc_queue_capacity(struct spsc_queue * queue);
+
+// Registers malloc() function.
+// \param malloc : Function pointer to malloc()-like function.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool spsc_queue_register_malloc(void * (*malloc)(size_t));
+
+// Registers free() function.
+// \param free : Function pointer to free()-like function.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool spsc_queue_register_free(void (*free)(void*));
+
+#endif
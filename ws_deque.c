@@ -0,0 +1,367 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "linked_list.h"
+#include "sched.h"
+#include "stdlib.h"
+#include "ws_deque.h"
+
+// Function pointers to (potentially) custom malloc() and
+// free() functions.
+//
+static void * (*malloc_fptr)(size_t size) = NULL;
+static void   (*free_fptr)(void* addr)    = NULL;
+
+// Failed steal attempts before an idle pool thread yields its CPU.
+//
+#define WS_POOL_SPINS   (64)
+
+/* Allocate a ring of size entries */
+static struct ws_deque_array * array_create(size_t size) {
+    struct ws_deque_array * array = malloc_fptr(sizeof(struct ws_deque_array) + size * sizeof(unsigned int));
+    INVALID_PTR_CHECK(array, NULL);
+    array->mask = size - 1;
+    array->prev = NULL;
+    return array;
+}
+
+/* Initialize a deque in caller-provided storage */
+bool ws_deque_init(struct ws_deque * deque) {
+    INVALID_PTR_CHECK(deque, false);
+    INVALID_PTR_CHECK(malloc_fptr, false);
+    INVALID_PTR_CHECK(free_fptr, false);
+    struct ws_deque_array * array = array_create(WS_DEQUE_INITIAL_SIZE);
+    INVALID_PTR_CHECK(array, false);
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->array, array);
+    return true;
+}
+
+/* Free the current ring and every ring it replaced */
+bool ws_deque_destroy(struct ws_deque * deque) {
+    INVALID_PTR_CHECK(deque, false);
+    struct ws_deque_array * array = atomic_load(&deque->array);
+    while (array != NULL) {
+        struct ws_deque_array * prev = array->prev;
+        free_fptr(array);
+        array = prev;
+    }
+    atomic_store(&deque->array, NULL);
+    return true;
+}
+
+/* Copy [top, bottom) into a ring twice the size. The old ring stays on
+   the chain for thieves that already loaded it. */
+static struct ws_deque_array * grow(struct ws_deque * deque, struct ws_deque_array * old,
+                                    int64_t top, int64_t bottom) {
+    struct ws_deque_array * array = array_create((old->mask + 1) * 2);
+    INVALID_PTR_CHECK(array, NULL);
+    for (int64_t i = top; i < bottom; i++) {
+        unsigned int data = atomic_load_explicit(&old->data[i & old->mask], memory_order_relaxed);
+        atomic_store_explicit(&array->data[i & array->mask], data, memory_order_relaxed);
+    }
+    array->prev = old;
+    atomic_store_explicit(&deque->array, array, memory_order_release);
+    return array;
+}
+
+/* Push at the bottom, owner only */
+bool ws_deque_push(struct ws_deque * deque, unsigned int data) {
+    INVALID_PTR_CHECK(deque, false);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    struct ws_deque_array * array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    if (bottom - top > (int64_t)array->mask) {
+        array = grow(deque, array, top, bottom);
+        INVALID_PTR_CHECK(array, false);
+    }
+    atomic_store_explicit(&array->data[bottom & array->mask], data, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+/* Pop at the bottom, owner only. Taking the last entry races thieves
+   for it on top. */
+bool ws_deque_pop(struct ws_deque * deque, unsigned int * popped_data) {
+    INVALID_PTR_CHECK(deque, false);
+    INVALID_PTR_CHECK(popped_data, false);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    struct ws_deque_array * array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    unsigned int data = atomic_load_explicit(&array->data[bottom & array->mask], memory_order_relaxed);
+    if (top == bottom) {
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                           memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        if (!won) {
+            return false;
+        }
+    }
+    *popped_data = data;
+    return true;
+}
+
+/* Steal from the top, any thread */
+enum ws_steal_result ws_deque_steal(struct ws_deque * deque, unsigned int * stolen_data) {
+    INVALID_PTR_CHECK(deque, WS_STEAL_EMPTY);
+    INVALID_PTR_CHECK(stolen_data, WS_STEAL_EMPTY);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return WS_STEAL_EMPTY;
+    }
+    struct ws_deque_array * array = atomic_load_explicit(&deque->array, memory_order_acquire);
+    unsigned int data = atomic_load_explicit(&array->data[top & array->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return WS_STEAL_RETRY;
+    }
+    *stolen_data = data;
+    return WS_STEAL_SUCCESS;
+}
+
+/* Get the number of entries, top first so the difference can't go
+   negative for a quiescent deque */
+size_t ws_deque_size(struct ws_deque * deque) {
+    INVALID_PTR_CHECK(deque, SIZE_MAX);
+    int64_t top = atomic_load(&deque->top);
+    int64_t bottom = atomic_load(&deque->bottom);
+    return (bottom > top) ? (size_t)(bottom - top) : 0;
+}
+
+/* Try to steal one task from a random victim, visiting each other thread
+   at most once */
+static bool steal_any(struct ws_worker * worker, unsigned int * item) {
+    struct ws_pool * pool = worker->pool;
+    worker->seed = worker->seed * 1103515245u + 12345u;
+    size_t start = (worker->seed >> 8) % pool->threads;
+    for (size_t i = 0; i < pool->threads; i++) {
+        struct ws_worker * victim = &pool->workers[(start + i) % pool->threads];
+        if (victim == worker) {
+            continue;
+        }
+        enum ws_steal_result result;
+        do {
+            result = ws_deque_steal(&victim->deque, item);
+        } while (result == WS_STEAL_RETRY);
+        if (result == WS_STEAL_SUCCESS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Run tasks from the own deque, then stolen ones, until none are left
+   anywhere. pending counts tasks queued or running, and a task's spawns
+   are counted before the task itself is retired, so it only reaches zero
+   once everything is done. */
+static void work(struct ws_worker * worker) {
+    struct ws_pool * pool = worker->pool;
+    unsigned int spins = 0;
+    for (;;) {
+        unsigned int item;
+        if (ws_deque_pop(&worker->deque, &item) || steal_any(worker, &item)) {
+            pool->task(worker, item, pool->ctx);
+            atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release);
+            spins = 0;
+            continue;
+        }
+        if (atomic_load_explicit(&pool->pending, memory_order_acquire) == 0) {
+            return;
+        }
+        if (++spins >= WS_POOL_SPINS) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+/* Pool thread body: sleep until a run starts, join it, report back */
+static void * worker_run(void * arg) {
+    struct ws_worker * worker = arg;
+    struct ws_pool * pool = worker->pool;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/* Create a pool and start its threads */
+struct ws_pool * ws_pool_create(size_t threads) {
+    INVALID_PTR_CHECK(malloc_fptr, NULL);
+    INVALID_PTR_CHECK(free_fptr, NULL);
+    if (threads == 0) {
+        return NULL;
+    }
+    struct ws_pool * pool = malloc_fptr(sizeof(struct ws_pool));
+    INVALID_PTR_CHECK(pool, NULL);
+    pool->workers = malloc_fptr(threads * sizeof(struct ws_worker));
+    if (pool->workers == NULL) {
+        free_fptr(pool);
+        return NULL;
+    }
+    pool->threads = 0;
+    pool->task = NULL;
+    pool->ctx = NULL;
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->failed, false);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = 0;
+    pool->running = 0;
+    pool->stop = false;
+
+    for (size_t i = 0; i < threads; i++) {
+        struct ws_worker * worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->id = i;
+        worker->seed = (unsigned int)i * 2654435761u + 1u;
+        if (!ws_deque_init(&worker->deque)) {
+            ws_pool_delete(pool);
+            return NULL;
+        }
+        // Thread 0 is whoever calls ws_pool_run()
+        if (i != 0 && pthread_create(&worker->thread, NULL, worker_run, worker) != 0) {
+            ws_deque_destroy(&worker->deque);
+            ws_pool_delete(pool);
+            return NULL;
+        }
+        pool->threads = i + 1;
+    }
+    return pool;
+}
+
+/* Stop the threads and free the pool */
+bool ws_pool_delete(struct ws_pool * pool) {
+    INVALID_PTR_CHECK(pool, false);
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->threads; i++) {
+        if (i != 0) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+        ws_deque_destroy(&pool->workers[i].deque);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free_fptr(pool->workers);
+    free_fptr(pool);
+    return true;
+}
+
+/* Seed the deques with the roots and run until no task is left */
+bool ws_pool_run(struct ws_pool * pool, const unsigned int * roots, size_t n,
+                 void (*task)(struct ws_worker * worker, unsigned int item, void * ctx), void * ctx) {
+    INVALID_PTR_CHECK(pool, false);
+    INVALID_PTR_CHECK(task, false);
+    if (n != 0) {
+        INVALID_PTR_CHECK(roots, false);
+    }
+
+    // The other threads are asleep, so their deques can be filled from
+    // here; the lock publishes the entries to them.
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    atomic_store(&pool->failed, false);
+    atomic_store(&pool->pending, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (!ws_deque_push(&pool->workers[i % pool->threads].deque, roots[i])) {
+            atomic_store(&pool->failed, true);
+            continue;
+        }
+        atomic_fetch_add(&pool->pending, 1);
+    }
+    ++pool->generation;
+    pool->running = pool->threads - 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(&pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running != 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return !atomic_load(&pool->failed);
+}
+
+/* Spawn onto the calling thread's own deque */
+bool ws_pool_spawn(struct ws_worker * worker, unsigned int item) {
+    INVALID_PTR_CHECK(worker, false);
+    struct ws_pool * pool = worker->pool;
+    atomic_fetch_add(&pool->pending, 1);
+    if (!ws_deque_push(&worker->deque, item)) {
+        atomic_fetch_sub(&pool->pending, 1);
+        atomic_store(&pool->failed, true);
+        return false;
+    }
+    return true;
+}
+
+/* Register malloc function */
+bool ws_deque_register_malloc(void * (*malloc)(size_t)) {
+    INVALID_PTR_CHECK(malloc, false);
+    malloc_fptr = malloc;
+    return true;
+}
+
+/* Register free function */
+bool ws_deque_register_free(void (*free)(void*)) {
+    INVALID_PTR_CHECK(free, false);
+    free_fptr = free;
+    return true;
+}
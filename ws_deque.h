@@ -0,0 +1,206 @@
+/*
+MIT License
+
+Copyright (c) 2025 pointerwars2025
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef WS_DEQUE_H_
+#define WS_DEQUE_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Chase-Lev work-stealing deque of unsigned ints, with the C11 memory
+   orderings from Le, Pop, Cohen and Zappa Nardelli, "Correct and
+   Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+
+   One owner thread pushes and pops at the bottom, LIFO, without atomic
+   read-modify-writes except when it races a thief for the last entry.
+   Any other thread may steal from the top, FIFO, with one
+   compare-and-swap on top. The owner grows the power-of-two ring by
+   doubling when it is full. Thieves may still be reading a replaced ring,
+   so old rings are kept on a chain and only freed by ws_deque_delete().
+
+   ws_pool is a small scheduler built on it: a fixed set of threads, each
+   owning a deque. A task is an unsigned int handed to a callback that may
+   spawn further tasks onto its own deque. Idle threads steal from random
+   victims, so work spawned by a busy thread spreads to the others
+   without any central queue. A run ends when no task is queued or
+   running. */
+
+// Padding used to keep top and bottom on their own cache lines.
+//
+#define WS_DEQUE_CACHE_LINE     (64)
+#define WS_DEQUE_INITIAL_SIZE   (64)
+
+struct ws_deque_array {
+    size_t mask;
+    struct ws_deque_array * prev;
+    _Atomic unsigned int data[];
+};
+
+// Definition of the deque. top and bottom count from zero and are masked
+// on access, the deque holds the entries in [top, bottom).
+//
+struct ws_deque {
+    _Atomic int64_t top;
+    char pad_thieves[WS_DEQUE_CACHE_LINE];
+    _Atomic int64_t bottom;
+    _Atomic(struct ws_deque_array *) array;
+    char pad_owner[WS_DEQUE_CACHE_LINE];
+};
+
+// Result of a steal.
+//
+enum ws_steal_result {
+    WS_STEAL_SUCCESS,
+    WS_STEAL_EMPTY,
+    WS_STEAL_RETRY,    // Lost a race for the top entry, the deque may not be empty
+};
+
+struct ws_pool;
+
+// Per-thread state of a pool, passed to tasks so they can spawn more.
+//
+struct ws_worker {
+    struct ws_deque deque;
+    struct ws_pool * pool;
+    pthread_t thread;
+    size_t id;
+    unsigned int seed;
+};
+
+// Definition of the pool. Thread 0 is the thread calling ws_pool_run().
+//
+struct ws_pool {
+    size_t threads;
+    struct ws_worker * workers;
+    void (*task)(struct ws_worker * worker, unsigned int item, void * ctx);
+    void * ctx;
+    _Atomic size_t pending;
+    atomic_bool failed;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    uint64_t generation;
+    size_t running;
+    bool stop;
+};
+
+// Initializes a deque in caller-provided storage.
+// PRECONDITION: Register malloc() and free() functions via the
+//               ws_deque_register_malloc() and
+//               ws_deque_register_free() functions.
+// \param deque : Deque to initialize.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_deque_init(struct ws_deque * deque);
+
+// Frees a deque's rings.
+// PRECONDITION: No thread is using the deque.
+// \param deque : Deque to tear down.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_deque_destroy(struct ws_deque * deque);
+
+// Pushes an unsigned int onto the bottom. Owner thread only.
+// \param deque : Pointer to deque.
+// \param data  : Data to insert.
+// Returns TRUE on success, FALSE if growing the ring failed.
+//
+bool ws_deque_push(struct ws_deque * deque, unsigned int data);
+
+// Pops the most recently pushed unsigned int. Owner thread only.
+// \param deque       : Pointer to deque.
+// \param popped_data : Pointer to popped data (provided by caller), if pop occurs.
+// Returns TRUE on success, FALSE if the deque is empty.
+//
+bool ws_deque_pop(struct ws_deque * deque, unsigned int * popped_data);
+
+// Steals the oldest unsigned int. Any thread.
+// \param deque       : Pointer to deque.
+// \param stolen_data : Pointer to stolen data (provided by caller), if steal occurs.
+// Returns WS_STEAL_SUCCESS, WS_STEAL_EMPTY, or WS_STEAL_RETRY if another
+// thread took the entry first.
+//
+enum ws_steal_result ws_deque_steal(struct ws_deque * deque, unsigned int * stolen_data);
+
+// Returns the number of entries in the deque. Under concurrent updates
+// this is a snapshot that may already be stale.
+// \param deque : Pointer to deque.
+// Returns size on success, SIZE_MAX otherwise.
+//
+size_t ws_deque_size(struct ws_deque * deque);
+
+// Creates a pool, starting threads - 1 worker threads. They sleep until
+// ws_pool_run().
+// \param threads : Number of threads, including the caller of ws_pool_run().
+// Returns a new pool on success, NULL on failure.
+//
+struct ws_pool * ws_pool_create(size_t threads);
+
+// Stops the worker threads and deletes a pool.
+// \param pool : Pointer to pool to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_pool_delete(struct ws_pool * pool);
+
+// Runs task on every root, and on everything those tasks spawn, across
+// the pool's threads. Returns once no task is left.
+// \param pool  : Pointer to pool.
+// \param roots : Initial tasks, spread over the threads.
+// \param n     : Number of roots.
+// \param task  : Called once per task, from any thread of the pool.
+// \param ctx   : Passed to every task call.
+// Returns TRUE on success, FALSE if a spawn failed (some tasks were
+// dropped) or on failure.
+//
+bool ws_pool_run(struct ws_pool * pool,
+                 const unsigned int * roots,
+                 size_t n,
+                 void (*task)(struct ws_worker * worker, unsigned int item, void * ctx),
+                 void * ctx);
+
+// Spawns a task from inside a running task, onto the calling thread's deque.
+// \param worker : Worker passed to the running task.
+// \param item   : Task to spawn.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_pool_spawn(struct ws_worker * worker, unsigned int item);
+
+// Registers malloc() function.
+// \param malloc : Function pointer to malloc()-like function, must be
+//                 thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_deque_register_malloc(void * (*malloc)(size_t));
+
+// Registers free() function.
+// \param free : Function pointer to free()-like function, must be
+//               thread safe.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool ws_deque_register_free(void (*free)(void*));
+
+#endif